@@ -45,6 +45,8 @@ BTreeIndex::BTreeIndex(const std::string & relationName,
     this->leafOccupancy = INTARRAYLEAFSIZE;
     // Number of keys in non-leaf node.
     this->nodeOccupancy = INTARRAYNONLEAFSIZE;
+    this->hasEvicted = false;
+    this->rootFrame = OptimisticRead::NO_FRAME;
 
     // The constructor needs to check if the specified index file exists.
     if (std::ifstream(outIndexName)) {
@@ -52,12 +54,11 @@ BTreeIndex::BTreeIndex(const std::string & relationName,
         this->file = new BlobFile(outIndexName, false);
         // The page number of meta page is the pageid of first page in the file.
         this->headerPageNum = file->getFirstPageNo();
-        // The meta page.
-        Page *headerInfoPage;
-        // Reads the meta page from the file.
-        this->bufMgr->readPage(this->file, this->headerPageNum, headerInfoPage);
+        // Reads the meta page from the file. The handle unpins it when it goes
+        // out of scope, also if one of the checks below throws.
+        PageHandle headerInfoPage = this->bufMgr->readPage(this->file, this->headerPageNum);
         // Cast headerInfoPage to struct IndexMetaInfo to retrieve information.
-        IndexMetaInfo *indexMetaInfo = (IndexMetaInfo*)headerInfoPage;
+        const IndexMetaInfo *indexMetaInfo = (const IndexMetaInfo*)headerInfoPage.get();
         // Get page number of root page of the B+ Tree inside the file index file.
         this->rootPageNum = indexMetaInfo->rootPageNo;
         // Check if the values in meta page match with values received through
@@ -71,20 +72,17 @@ BTreeIndex::BTreeIndex(const std::string & relationName,
         if (relationName != indexMetaInfo->relationName) {
             throw BadIndexInfoException("The name of base relation is not consistent.");
         }
-        // readPage() increases the pinCnt of the page. The page has not been modified.
-        this->bufMgr->unPinPage(this->file, this->headerPageNum, false);
+        this->bufMgr->setEvictionListener(this->file, this);
     } else {
         // The file does not exist.
         this->file = new BlobFile(outIndexName, true);
-        Page *headerInfoPage;
-        // Allocate a new page for meta data in the file. The pointer to that page is stored
-        // in headerInfoPage (allocPage() set pinCnt to 1).
-        this->bufMgr->allocPage(this->file, this->headerPageNum, headerInfoPage);
-        Page *rootNodePage;
-        // Allocate a new page for the root node. The pointer to that page is stored
-        // in rootNodePage.
-        this->bufMgr->allocPage(this->file, this->rootPageNum, rootNodePage);
-        IndexMetaInfo *indexMetaInfo = (IndexMetaInfo*)headerInfoPage;
+        this->bufMgr->setEvictionListener(this->file, this);
+        // Allocate a new page for meta data in the file. The handle headerInfoPage
+        // holds the pin set by allocPage().
+        PageHandle headerInfoPage = this->bufMgr->allocPage(this->file, this->headerPageNum);
+        // Allocate a new page for the root node.
+        PageHandle rootNodePage = this->bufMgr->allocPage(this->file, this->rootPageNum);
+        IndexMetaInfo *indexMetaInfo = (IndexMetaInfo*)headerInfoPage.getMutable();
         // Copy the information to struct IndexMetaInfo.
         std::size_t length = relationName.copy(indexMetaInfo->relationName,
                                                relationName.length(), 0);
@@ -93,13 +91,14 @@ BTreeIndex::BTreeIndex(const std::string & relationName,
         indexMetaInfo->attrType = this->attributeType;
         indexMetaInfo->rootPageNo = this->rootPageNum;
         // The root node.
-        LeafNodeInt *root = (LeafNodeInt*)rootNodePage;
+        LeafNodeInt *root = (LeafNodeInt*)rootNodePage.getMutable();
         // Number of keys in the root node.
         root->num = 0;
         // The root does not have a rightSibPageNo currently.
         root->rightSibPageNo = 0;
-        this->bufMgr->unPinPage(this->file, this->headerPageNum, true);
-        this->bufMgr->unPinPage(this->file, this->rootPageNum, true);
+        // Both pages were written through getMutable() and are unpinned dirty.
+        headerInfoPage.release();
+        rootNodePage.release();
         // Scan the records and insert them into the B+ tree.
         FileScan *fs = new FileScan(relationName, this->bufMgr);
         try {
@@ -113,6 +112,8 @@ BTreeIndex::BTreeIndex(const std::string & relationName,
         } catch (EndOfFileException& e) {
             /* File scan completed. */
         }
+        // Parents with swizzled slots are pinned and cannot be flushed.
+        unswizzleAll();
         this->bufMgr->flushFile(file);
         delete(fs);
     }    
@@ -125,6 +126,12 @@ BTreeIndex::BTreeIndex(const std::string & relationName,
 
 BTreeIndex::~BTreeIndex()
 {
+    // Unpin the page of an unfinished scan, the file cannot be flushed otherwise.
+    this->currentPage.release();
+    // Restore the swizzled slots, which unpins their parents, and stop
+    // listening before the flush evicts the pages.
+    unswizzleAll();
+    this->bufMgr->setEvictionListener(this->file, NULL);
     // Flush index file.
     this->bufMgr->flushFile(this->file);
     // End initialized scan.
@@ -141,82 +148,278 @@ const void BTreeIndex::insertEntry(const void *key, const RecordId rid)
 {
      RIDKeyPair<int> data;
      data.set(rid, *((int *)key));
+     processEvictions();
+     // Most inserts only change a leaf, so find it without pinning the
+     // inner nodes and pin just the leaf. A full leaf has to split, which
+     // changes its ancestors too; that takes the pinned descent below.
+     // The index has a single writer, so the leaf cannot split between the
+     // validation of its parent and the pin.
+     for (int attempt = 0; attempt < OPTIMISTIC_RETRIES; attempt++)
+     {
+       PageId leafPageNum;
+       FrameId leafFrame;
+       DescentResult result = findLeafOptimistic(data.key, leafPageNum, leafFrame);
+       if (result == DESCENT_CHANGED)
+       {
+         continue;
+       }
+       if (result == DESCENT_BLOCKED)
+       {
+         break;
+       }
+       PageHandle leaf = bufMgr->readPageHinted(file, leafPageNum, leafFrame);
+       if (((const LeafNodeInt *)leaf.get())->ridArray[leafOccupancy - 1].page_number == 0)
+       {
+         insertLeaf((LeafNodeInt *)leaf.getMutable(), data);
+         return;
+       }
+       break;
+     }
      // root
-     Page* root;
-     // PageId rootPageNum;
-     bufMgr->readPage(file, rootPageNum, root);
-     PageKeyPair<int> *child = nullptr;
-     insert(root, rootPageNum, origRootPageNum == rootPageNum ? true : false, data, child);
+     PageHandle root = bufMgr->readPageHinted(file, rootPageNum, rootFrame);
+     rootFrame = root.frame();
+     PageKeyPair<int> child;
+     insert(root, origRootPageNum == rootPageNum ? true : false, data, child);
 }
 
 /**
  * Recursive function to insert the index entry to the index file
  * @param curPage
- * @param curPageNum        
  * @param nodeIsLeaf     
  * @param data      
  * @param child     
 */
-const void BTreeIndex::insert(Page *curPage, PageId curPageNum, bool nodeIsLeaf, const RIDKeyPair<int> data, PageKeyPair<int> *&child)
+bool BTreeIndex::insert(PageHandle &curPage, bool nodeIsLeaf, const RIDKeyPair<int> data, PageKeyPair<int> &child)
 {
 	if (nodeIsLeaf){
-		LeafNodeInt *leaf = (LeafNodeInt *)curPage;
+		const LeafNodeInt *leaf = (const LeafNodeInt *)curPage.get();
 		if (leaf->ridArray[leafOccupancy - 1].page_number == 0)
 		{
-		  insertLeaf(leaf, data);
-		  bufMgr->unPinPage(file, curPageNum, true);
-		  child = nullptr;
-		}
-		else
-		{
-		  splitLeaf(leaf, curPageNum, child, data);
+		  insertLeaf((LeafNodeInt *)curPage.getMutable(), data);
+		  curPage.release();
+		  return false;
 		}
+		splitLeaf(curPage, child, data);
+		return true;
 	}
 	else
 	{
-		NonLeafNodeInt *curNode = (NonLeafNodeInt *)curPage;
+		// every descent passes the inner nodes
+		curPage.setHint(KEEP_HOT);
+		const NonLeafNodeInt *curNode = (const NonLeafNodeInt *)curPage.get();
 		// find the right key to traverse
-		Page *nextPage;
-		PageId nextNodePageNum;
-		int i = nodeOccupancy;
-		while(i >= 0 && (curNode->pageNoArray[i] == 0))
-		{
-			i--;
-		}
-		while(i > 0 && (curNode->keyArray[i-1] >= data.key))
-		{
-			i--;
-		}
-		nextNodePageNum = curNode->pageNoArray[i];
-		bufMgr->readPage(file, nextNodePageNum, nextPage);
-		// NonLeafNodeInt *nextNode = (NonLeafNodeInt *)nextPage;
+		PageHandle nextPage = readChild(curPage, childSlot(curNode, data.key));
 		nodeIsLeaf = curNode->level == 1;
-		insert(nextPage, nextNodePageNum, nodeIsLeaf, data, child);
 		// no split in child, just return
-		if (child == nullptr)
+		if (!insert(nextPage, nodeIsLeaf, data, child))
 			{
 				// unpin current page from call stack
-				bufMgr->unPinPage(file, curPageNum, false);
-			}
-			else
-			{ 
-			  // if the curpage is not full
-			  if (curNode->pageNoArray[nodeOccupancy] == 0)
-			  {
-				// insert the child to curpage
-				insertNonLeaf(curNode, child);
-				child = nullptr;
-				// finish the insert process, unpin current page
-				bufMgr->unPinPage(file, curPageNum, true);
-			  }
-			  else
-			  {
-				splitNonLeaf(curNode, curPageNum, child);
-			  }
+				curPage.release();
+				return false;
 			}
+		// the slots move around below, so restore their page numbers
+		unswizzleChildren(curPage);
+		// if the curpage is not full
+		if (curNode->pageNoArray[nodeOccupancy] == 0)
+		{
+			// insert the child to curpage
+			insertNonLeaf((NonLeafNodeInt *)curPage.getMutable(), &child);
+			// finish the insert process, unpin current page
+			curPage.release();
+			return false;
+		}
+		splitNonLeaf(curPage, child);
+		return true;
     }
 }
 
+int BTreeIndex::childSlot(const NonLeafNodeInt *node, int key)
+{
+	int i = nodeOccupancy;
+	while(i > 0 && (node->pageNoArray[i] == 0))
+	{
+		i--;
+	}
+	while(i > 0 && (node->keyArray[i-1] >= key))
+	{
+		i--;
+	}
+	return i;
+}
+
+const PageId *BTreeIndex::slotsOf(const PageHandle &node)
+{
+	return ((const NonLeafNodeInt *)node.get())->pageNoArray;
+}
+
+void BTreeIndex::setSlot(PageHandle &node, int slot, PageId ref)
+{
+	// Optimistic descents reading the node have to notice the change, but
+	// a swizzled slot is restored before the node can be written back, so
+	// the node is not dirtied.
+	((NonLeafNodeInt *)node.getTransient())->pageNoArray[slot] = ref;
+}
+
+PageHandle BTreeIndex::readChild(PageHandle &parent, int slot)
+{
+	processEvictions();
+	PageId ref = slotsOf(parent)[slot];
+	if (ref & SWIZZLED)
+	{
+		FrameId frame = ref & ~SWIZZLED;
+		return bufMgr->readPageHinted(file, swizzledChildren[frame].pageNo, frame);
+	}
+	PageHandle child = bufMgr->readPage(file, ref);
+	swizzle(parent, slot, child);
+	return child;
+}
+
+void BTreeIndex::swizzle(PageHandle &parent, int slot, const PageHandle &child)
+{
+	FrameId frame = child.frame();
+	if (frame >= swizzledChildren.size())
+	{
+		SwizzledChild none = {Page::INVALID_NUMBER, Page::INVALID_NUMBER, 0};
+		swizzledChildren.resize(frame + 1, none);
+	}
+	// readChild() processed the evictions, so an entry in use belongs to
+	// a page that is still in the frame, and the page has a single parent.
+	if (swizzledChildren[frame].pageNo != Page::INVALID_NUMBER)
+	{
+		return;
+	}
+	if (swizzledParents.count(parent.pageNo()) == 0 &&
+	    swizzledParents.size() >= bufMgr->getNumBufs() / PINNED_PARENT_SHARE)
+	{
+		// Pinning another parent would take too much of the pool.
+		return;
+	}
+	SwizzledParent &parentPin = swizzledParents[parent.pageNo()];
+	if (parentPin.children == 0)
+	{
+		parentPin.pin = bufMgr->readPageHinted(file, parent.pageNo(), parent.frame());
+		parentPin.pin.setHint(KEEP_HOT);
+	}
+	parentPin.children++;
+	SwizzledChild swizzled = {child.pageNo(), parent.pageNo(), slot};
+	swizzledChildren[frame] = swizzled;
+	setSlot(parent, slot, SWIZZLED | frame);
+}
+
+void BTreeIndex::unswizzle(FrameId frame)
+{
+	SwizzledChild &swizzled = swizzledChildren[frame];
+	std::unordered_map<PageId, SwizzledParent>::iterator it = swizzledParents.find(swizzled.parentPageNo);
+	{
+		// A handle of its own, since the writer it announces lasts until
+		// the handle is released and the pin may be held for long.
+		PageHandle parent = bufMgr->readPageHinted(file, swizzled.parentPageNo, it->second.pin.frame());
+		setSlot(parent, swizzled.slot, swizzled.pageNo);
+	}
+	swizzled.pageNo = Page::INVALID_NUMBER;
+	if (--it->second.children == 0)
+	{
+		swizzledParents.erase(it);
+	}
+}
+
+void BTreeIndex::unswizzleChildren(PageHandle &node)
+{
+	if (swizzledParents.count(node.pageNo()) == 0)
+	{
+		return;
+	}
+	const PageId *slots = slotsOf(node);
+	for (int i = 0; i <= nodeOccupancy; i++)
+	{
+		if (slots[i] & SWIZZLED)
+		{
+			unswizzle(slots[i] & ~SWIZZLED);
+		}
+	}
+}
+
+void BTreeIndex::unswizzleAll()
+{
+	for (FrameId frame = 0; frame < swizzledChildren.size(); frame++)
+	{
+		if (swizzledChildren[frame].pageNo != Page::INVALID_NUMBER)
+		{
+			unswizzle(frame);
+		}
+	}
+	std::lock_guard<std::mutex> guard(evictedLatch);
+	evictedPages.clear();
+	hasEvicted = false;
+}
+
+void BTreeIndex::processEvictions()
+{
+	if (!hasEvicted.load(std::memory_order_acquire))
+	{
+		return;
+	}
+	std::vector<EvictedPage> evicted;
+	{
+		std::lock_guard<std::mutex> guard(evictedLatch);
+		evicted.swap(evictedPages);
+		hasEvicted = false;
+	}
+	for (std::size_t i = 0; i < evicted.size(); i++)
+	{
+		FrameId frame = evicted[i].frame;
+		if (frame < swizzledChildren.size() && swizzledChildren[frame].pageNo == evicted[i].pageNo)
+		{
+			unswizzle(frame);
+		}
+	}
+}
+
+void BTreeIndex::pageEvicted(const File *file, PageId pageNo, FrameId frame)
+{
+	std::lock_guard<std::mutex> guard(evictedLatch);
+	EvictedPage page = {frame, pageNo};
+	evictedPages.push_back(page);
+	hasEvicted = true;
+}
+
+BTreeIndex::DescentResult BTreeIndex::findLeafOptimistic(int key, PageId &leafPageNum, FrameId &leafFrame)
+{
+	PageId curPageNum = rootPageNum;
+	FrameId curFrame = rootFrame;
+	bool nodeIsLeaf = origRootPageNum == rootPageNum;
+	while (!nodeIsLeaf)
+	{
+		OptimisticRead read(curFrame);
+		if (!bufMgr->readOptimistic(file, curPageNum, read))
+		{
+			// Not resident, or a writer is at work; the index has a single
+			// writer, so neither goes away by trying again.
+			return DESCENT_BLOCKED;
+		}
+		// The node may change under us; nothing read from it is used
+		// before the read has been validated.
+		const NonLeafNodeInt *curNode = (const NonLeafNodeInt *)read.page;
+		PageId ref = curNode->pageNoArray[childSlot(curNode, key)];
+		bool childIsLeaf = curNode->level == 1;
+		if (!bufMgr->validate(read))
+		{
+			return DESCENT_CHANGED;
+		}
+		// Only the pinned descent swizzles; leave unswizzled paths to it.
+		if (!(ref & SWIZZLED))
+		{
+			return DESCENT_BLOCKED;
+		}
+		curFrame = ref & ~SWIZZLED;
+		curPageNum = swizzledChildren[curFrame].pageNo;
+		nodeIsLeaf = childIsLeaf;
+	}
+	leafPageNum = curPageNum;
+	leafFrame = curFrame;
+	return DESCENT_FOUND;
+}
+
 const void BTreeIndex::insertLeaf(LeafNodeInt *leaf, RIDKeyPair<int> data)
 {
   // Insert directly if leaf is empty
@@ -246,13 +449,14 @@ const void BTreeIndex::insertLeaf(LeafNodeInt *leaf, RIDKeyPair<int> data)
   }
 }
 
-const void BTreeIndex::splitLeaf(LeafNodeInt *leaf, PageId leafPageNum, PageKeyPair<int> *&child, const RIDKeyPair<int> data)
+const void BTreeIndex::splitLeaf(PageHandle &leafPage, PageKeyPair<int> &child, const RIDKeyPair<int> data)
 {
+  LeafNodeInt *leaf = (LeafNodeInt *)leafPage.getMutable();
+  PageId leafPageNum = leafPage.pageNo();
   // Create a new leaf node
-  Page *newPage;
   PageId newPageNum;
-  bufMgr->allocPage(file, newPageNum, newPage);
-  LeafNodeInt *newLeafNode = (LeafNodeInt *)newPage;
+  PageHandle newPage = bufMgr->allocPage(file, newPageNum);
+  LeafNodeInt *newLeafNode = (LeafNodeInt *)newPage.getMutable();
 
   int midval = leafOccupancy/2;
   // odd number of keys
@@ -283,36 +487,32 @@ const void BTreeIndex::splitLeaf(LeafNodeInt *leaf, PageId leafPageNum, PageKeyP
   leaf->rightSibPageNo = newPageNum;
 
   // set the smallest key from right page as the new child entry
-  child = new PageKeyPair<int>();
-  PageKeyPair<int> newKeyPair;
-  newKeyPair.set(newPageNum, newLeafNode->keyArray[0]);
-  child = &newKeyPair;
-  bufMgr->unPinPage(file, leafPageNum, true);
-  bufMgr->unPinPage(file, newPageNum, true);
+  child.set(newPageNum, newLeafNode->keyArray[0]);
+  leafPage.release();
+  newPage.release();
 
   // if curr page is root
   if (leafPageNum == rootPageNum)
   {
 	// create a new root 
 	PageId newRootPageNum;
-	Page *newRoot;
-	bufMgr->allocPage(file, newRootPageNum, newRoot);
-	NonLeafNodeInt *newRootPage = (NonLeafNodeInt *)newRoot;
+	PageHandle newRoot = bufMgr->allocPage(file, newRootPageNum);
+	newRoot.setHint(KEEP_HOT);
+	NonLeafNodeInt *newRootPage = (NonLeafNodeInt *)newRoot.getMutable();
 
 	// update new root info
 	newRootPage->level = origRootPageNum == rootPageNum ? 1 : 0;
-	newRootPage->keyArray[0] = child->key;
+	newRootPage->keyArray[0] = child.key;
 	newRootPage->pageNoArray[0] = leafPageNum;
-	newRootPage->pageNoArray[1] = child->pageNo;
+	newRootPage->pageNoArray[1] = child.pageNo;
 	// create meta
-	Page *meta;
-	bufMgr->readPage(file, headerPageNum, meta);
-	IndexMetaInfo *metaPage = (IndexMetaInfo *)meta;
+	PageHandle meta = bufMgr->readPage(file, headerPageNum);
+	IndexMetaInfo *metaPage = (IndexMetaInfo *)meta.getMutable();
 	metaPage->rootPageNo = newRootPageNum;
 	rootPageNum = newRootPageNum;
 	// unpin unused page
-	bufMgr->unPinPage(file, headerPageNum, true);
-	bufMgr->unPinPage(file, newRootPageNum, true);
+	meta.release();
+	newRoot.release();
   }
 }
 
@@ -335,20 +535,22 @@ const void BTreeIndex::insertNonLeaf(NonLeafNodeInt *nonleaf, PageKeyPair<int> *
   nonleaf->pageNoArray[i+1] = data->pageNo;
 }
 
-const void BTreeIndex::splitNonLeaf(NonLeafNodeInt *curNode, PageId curPageNum, PageKeyPair<int> *&child)
+const void BTreeIndex::splitNonLeaf(PageHandle &curPage, PageKeyPair<int> &child)
 {
+  NonLeafNodeInt *curNode = (NonLeafNodeInt *)curPage.getMutable();
+  PageId curPageNum = curPage.pageNo();
   // allocate a new nonleaf node
   PageId newPageNum;
-  Page *newPage;
-  bufMgr->allocPage(file, newPageNum, newPage);
-  NonLeafNodeInt *newNode = (NonLeafNodeInt *)newPage;
+  PageHandle newPage = bufMgr->allocPage(file, newPageNum);
+  newPage.setHint(KEEP_HOT);
+  NonLeafNodeInt *newNode = (NonLeafNodeInt *)newPage.getMutable();
 
   int mid = nodeOccupancy/2;
   int pushupIndex = mid;
   PageKeyPair<int> pushupEntry;
   if (nodeOccupancy % 2 == 0)
   {
-    pushupIndex = child->key < curNode->keyArray[mid] ? mid -1 : mid;
+    pushupIndex = child.key < curNode->keyArray[mid] ? mid -1 : mid;
   }
   pushupEntry.set(newPageNum, curNode->keyArray[pushupIndex]);
 
@@ -367,37 +569,106 @@ const void BTreeIndex::splitNonLeaf(NonLeafNodeInt *curNode, PageId curPageNum,
   curNode->keyArray[pushupIndex] = 0;
   curNode->pageNoArray[pushupIndex] = 0;
   // insert the new child 
-  insertNonLeaf(child->key < newNode->keyArray[0] ? curNode : newNode, child);
-  child = &pushupEntry;
-  bufMgr->unPinPage(file, curPageNum, true);
-  bufMgr->unPinPage(file, newPageNum, true);
+  insertNonLeaf(child.key < newNode->keyArray[0] ? curNode : newNode, &child);
+  child = pushupEntry;
+  curPage.release();
+  newPage.release();
 
   // if the curNode is the root
   if (curPageNum == rootPageNum)
   {
 	// create a new root 
 	PageId newRootPageNum;
-	Page *newRoot;
-	bufMgr->allocPage(file, newRootPageNum, newRoot);
-	NonLeafNodeInt *newRootPage = (NonLeafNodeInt *)newRoot;
+	PageHandle newRoot = bufMgr->allocPage(file, newRootPageNum);
+	newRoot.setHint(KEEP_HOT);
+	NonLeafNodeInt *newRootPage = (NonLeafNodeInt *)newRoot.getMutable();
 
 	// update metadata
 	newRootPage->level = origRootPageNum == rootPageNum ? 1 : 0;
-	newRootPage->keyArray[0] = child->key;
+	newRootPage->keyArray[0] = child.key;
 	newRootPage->pageNoArray[0] = curPageNum;
-	newRootPage->pageNoArray[1] = child->pageNo;
+	newRootPage->pageNoArray[1] = child.pageNo;
 	// create meta
-	Page *meta;
-	bufMgr->readPage(file, headerPageNum, meta);
-	IndexMetaInfo *metaPage = (IndexMetaInfo *)meta;
+	PageHandle meta = bufMgr->readPage(file, headerPageNum);
+	IndexMetaInfo *metaPage = (IndexMetaInfo *)meta.getMutable();
 	metaPage->rootPageNo = newRootPageNum;
 	rootPageNum = newRootPageNum;
 	// unpin unused page
-	bufMgr->unPinPage(file, headerPageNum, true);
-	bufMgr->unPinPage(file, newRootPageNum, true);
+	meta.release();
+	newRoot.release();
   }
 }
 
+// -----------------------------------------------------------------------------
+// BTreeIndex::lookupAsync
+// -----------------------------------------------------------------------------
+
+void BTreeIndex::lookupAsync(const void *key, AsyncPageScheduler &scheduler, LookupCallback done)
+{
+	int keyValue = *((int *)key);
+	bool rootIsLeaf = origRootPageNum == rootPageNum;
+	scheduler.readPage(file, rootPageNum, [this, keyValue, rootIsLeaf, &scheduler, done](PageHandle root, std::exception_ptr error) {
+		if (error)
+		{
+			done(false, RecordId(), error);
+			return;
+		}
+		lookupStep(keyValue, std::move(root), rootIsLeaf, scheduler, done);
+	});
+}
+
+void BTreeIndex::lookupStep(int key, PageHandle node, bool nodeIsLeaf, AsyncPageScheduler &scheduler, const LookupCallback &done)
+{
+	if (nodeIsLeaf)
+	{
+		const LeafNodeInt *leaf = (const LeafNodeInt *)node.get();
+		for (int i = 0; i < leafOccupancy && leaf->ridArray[i].page_number != 0; i++)
+		{
+			if (leaf->keyArray[i] == key)
+			{
+				done(true, leaf->ridArray[i], std::exception_ptr());
+				return;
+			}
+		}
+		done(false, RecordId(), std::exception_ptr());
+		return;
+	}
+	node.setHint(KEEP_HOT);
+	const NonLeafNodeInt *curNode = (const NonLeafNodeInt *)node.get();
+	bool childIsLeaf = curNode->level == 1;
+	// A split leaves the smallest key of the new right node as the
+	// separator, so an equal key is looked for on the right.
+	int slot = childSlot(curNode, key);
+	while (slot < nodeOccupancy && curNode->pageNoArray[slot + 1] != 0 && curNode->keyArray[slot] == key)
+	{
+		slot++;
+	}
+	processEvictions();
+	PageId ref = slotsOf(node)[slot];
+	if (ref & SWIZZLED)
+	{
+		lookupStep(key, readChild(node, slot), childIsLeaf, scheduler, done);
+		return;
+	}
+	// The parent stays pinned until the child has been read, so that the
+	// child can be swizzled into it.
+	std::shared_ptr<PageHandle> parent = std::make_shared<PageHandle>(std::move(node));
+	scheduler.readPage(file, ref, [this, key, parent, slot, childIsLeaf, &scheduler, done](PageHandle child, std::exception_ptr error) {
+		if (error)
+		{
+			done(false, RecordId(), error);
+			return;
+		}
+		processEvictions();
+		if (slotsOf(*parent)[slot] == child.pageNo())
+		{
+			swizzle(*parent, slot, child);
+		}
+		parent->release();
+		lookupStep(key, std::move(child), childIsLeaf, scheduler, done);
+	});
+}
+
 // -----------------------------------------------------------------------------
 // BTreeIndex::startScan
 // -----------------------------------------------------------------------------
@@ -448,24 +719,29 @@ const void BTreeIndex::scanNext(RecordId& outRid)
         throw ScanNotInitializedException();
     }
     // Get current page being scanned.
-    LeafNodeInt *curr = (LeafNodeInt*) this->currentPageData;
+    const LeafNodeInt *curr = (const LeafNodeInt*) this->currentPage.get();
     // Check if the index of the entry to be scanned is larger or equal to the
     // number of entries (keys) in the array.
     if (this->nextEntry >= curr->num) {
         // Check if there are more leaf nodes.
         if (curr->rightSibPageNo == 0) {
             // Unpin the current page and throw the exception.
-            this->bufMgr->unPinPage(this->file, this->currentPageNum, false);
+            this->currentPage.release();
             throw IndexScanCompletedException();
         } else {
-            // A rightSibPageNo exists.
-            this->bufMgr->unPinPage(this->file, this->currentPageNum, false);
-            // Go the right leaf node and get its page number.
+            // A rightSibPageNo exists. Go the right leaf node and get its page number.
             this->currentPageNum = curr->rightSibPageNo;
-            // Update the currentPageData to the current page being scanned.
-            this->bufMgr->readPage(this->file, this->currentPageNum, this->currentPageData);
+            // Update currentPage to the current page being scanned; assigning
+            // the new handle unpins the previous leaf.
+            this->currentPage = this->bufMgr->readPage(this->file, this->currentPageNum);
+            // The scan is done with the leaf once it moves on.
+            this->currentPage.setHint(EVICT_SOON);
             // Update curr pointer to the new leaf node.
-            curr = (LeafNodeInt*) this->currentPageData;
+            curr = (const LeafNodeInt*) this->currentPage.get();
+            // Start loading the following leaf while this one is scanned.
+            if (curr->rightSibPageNo != 0) {
+                this->bufMgr->prefetch(this->file, curr->rightSibPageNo);
+            }
             // Set value of newEntry to 0.
             this->nextEntry = 0;
         }
@@ -488,15 +764,14 @@ const void BTreeIndex::endScan()
     if (!this->scanExecuting) {
         throw ScanNotInitializedException();
     }
+    // Unpin the current page being scanned.
+    this->currentPage.release();
     // Reset variables.
     this->currentPageNum = 0;
-    this->currentPageData = NULL;
     this->nextEntry = 0;
     this->scanExecuting = false;
     this->lowValInt = 0;
     this->highValInt = 0;
-    // Unpin the current page being scanned.
-    this->bufMgr->unPinPage(this->file, this->currentPageNum, false);
 }
 
 }
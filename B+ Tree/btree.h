@@ -11,11 +11,18 @@
 #include <string>
 #include "string.h"
 #include <sstream>
+#include <atomic>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
 
 #include "types.h"
 #include "page.h"
 #include "file.h"
 #include "buffer.h"
+#include "async_page.h"
 
 namespace badgerdb
 {
@@ -190,11 +197,26 @@ struct LeafNodeInt{
 };
 
 
+/**
+ * @brief Callback of BTreeIndex::lookupAsync(): whether the key was found, its record id, and the
+ * exception thrown while reading a node, if any.
+ */
+typedef std::function<void(bool found, RecordId rid, std::exception_ptr error)> LookupCallback;
+
+
 /**
  * @brief BTreeIndex class. It implements a B+ Tree index on a single attribute of a
  * relation. This index supports only one scan at a time.
+ *
+ * Child pointers of resident non-leaf nodes are swizzled: once a descent has pinned a child, the parent's
+ * slot holds the child's frame, tagged with SWIZZLED, in place of its page number, and later descents reach
+ * the child without a hash table lookup. A parent is kept pinned while it holds swizzled slots, so they are
+ * never written to disk; the buffer manager tells the index when a child is evicted and the slot gets its
+ * page number back before it is used again. At most 1 / PINNED_PARENT_SHARE of the pool is pinned that
+ * way, so that scans through a small pool still find unpinned frames. The index file must therefore not be flushed from outside
+ * while the index is open, and holds at most 2^31 pages.
 */
-class BTreeIndex {
+class BTreeIndex : private BufEvictionListener {
 
  private:
 
@@ -257,9 +279,9 @@ class BTreeIndex {
 	PageId	currentPageNum;
 
   /**
-   * Current Page being scanned.
+   * Current Page being scanned, pinned for as long as the scan is on it.
    */
-	Page		*currentPageData;
+	PageHandle	currentPage;
 
   /**
    * Low INTEGER value for scan.
@@ -305,16 +327,179 @@ class BTreeIndex {
   * the pageId before splitting
   */
   PageId origRootPageNum;
-  
+
+  /**
+   * Tag of a swizzled child pointer; the other bits hold the frame of the child.
+   */
+  static const PageId SWIZZLED = 0x80000000;
+
+  /**
+   * @brief Where a swizzled child lives on disk and which slot points to it
+   */
+  struct SwizzledChild
+  {
+    PageId pageNo;
+    PageId parentPageNo;
+    int slot;
+  };
+
+  /**
+   * @brief Pin kept on a parent while it holds swizzled slots
+   */
+  struct SwizzledParent
+  {
+    PageHandle pin;
+    int children;
+  };
+
+  /**
+   * @brief A page of the index that left its frame
+   */
+  struct EvictedPage
+  {
+    FrameId frame;
+    PageId pageNo;
+  };
+
+  /**
+   * Swizzled children by frame; pageNo is Page::INVALID_NUMBER for frames no slot points to.
+   */
+  std::vector<SwizzledChild> swizzledChildren;
+
   /**
-   * Recursive function to insert the index entry
-   * @param curPage	current page
-   * @param curPageNum  PageId of current Page
+   * Parents that hold swizzled slots, by page number.
+   */
+  std::unordered_map<PageId, SwizzledParent> swizzledParents;
+
+  /**
+   * Pages reported by pageEvicted() that have not been unswizzled yet. Protected by evictedLatch,
+   * since the buffer manager may report evictions caused by other threads.
+   */
+  std::vector<EvictedPage> evictedPages;
+
+  std::mutex evictedLatch;
+
+  /**
+   * Set while evictedPages is not empty, so that descents need not take evictedLatch.
+   */
+  std::atomic<bool> hasEvicted;
+
+  /**
+   * Frame the root was last pinned in.
+   */
+  FrameId rootFrame;
+
+  /**
+   * Share of the buffer pool, as a divisor, that parents pinned for their swizzled slots may occupy.
+   * Once it is used up, children of further parents are reached through the hash table.
+   */
+  static const std::uint32_t PINNED_PARENT_SHARE = 8;
+
+  /**
+   * Number of optimistic descents tried by insertEntry() before it takes the pinned path.
+   */
+  static const int OPTIMISTIC_RETRIES = 3;
+
+  /**
+   * Chooses the child of a non-leaf node that a key belongs under.
+   * @param node   Non-leaf node
+   * @param key    Key to look for
+   * @return  Index of the child's slot in pageNoArray, which may be swizzled.
+   */
+  int childSlot(const NonLeafNodeInt *node, int key);
+
+  /**
+   * Pins a child of a pinned non-leaf node, following the slot's swizzled pointer if it has one and
+   * swizzling it otherwise.
+   * @param parent  Handle of the parent
+   * @param slot    Index of the child's slot in pageNoArray
+   * @return  Handle of the child.
+   */
+  PageHandle readChild(PageHandle &parent, int slot);
+
+  /**
+   * Points a slot of a pinned parent at the frame of a pinned child.
+   * @param parent  Handle of the parent
+   * @param slot    Index of the child's slot in pageNoArray
+   * @param child   Handle of the child
+   */
+  void swizzle(PageHandle &parent, int slot, const PageHandle &child);
+
+  /**
+   * Restores the page number in the slot pointing to a frame, and unpins the parent if that was its
+   * last swizzled slot.
+   * @param frame   Frame of a swizzled child
+   */
+  void unswizzle(FrameId frame);
+
+  /**
+   * Restores the page numbers in all slots of a node, before the node is changed.
+   * @param node    Handle of the node
+   */
+  void unswizzleChildren(PageHandle &node);
+
+  /**
+   * Restores the page numbers in all slots of the index and unpins their parents.
+   */
+  void unswizzleAll();
+
+  /**
+   * Unswizzles the slots pointing to pages reported by pageEvicted(). Called before a slot is followed
+   * or swizzled, so that no slot points to a frame that now holds another page.
+   */
+  void processEvictions();
+
+  /**
+   * Queues an evicted page of the index file for processEvictions().
+   */
+  void pageEvicted(const File *file, PageId pageNo, FrameId frame);
+
+  /**
+   * Slots of a non-leaf node, for reading.
+   * @param node    Handle of the node
+   */
+  const PageId *slotsOf(const PageHandle &node);
+
+  /**
+   * Writes a slot of a non-leaf node through PageHandle::getTransient(), which optimistic descents rely on.
+   * The page is not marked dirty: a node is pinned while it holds swizzled slots and gets its page numbers
+   * back before it is unpinned, so swizzling alone never causes a write.
+   * @param node    Handle of the node
+   * @param slot    Index into pageNoArray
+   * @param ref     Page number, or SWIZZLED and a frame
+   */
+  void setSlot(PageHandle &node, int slot, PageId ref);
+
+  /**
+   * @brief Outcome of findLeafOptimistic()
+   */
+  enum DescentResult
+  {
+    DESCENT_FOUND,      /* The leaf was found */
+    DESCENT_CHANGED,    /* An inner node changed while it was read; another try may succeed */
+    DESCENT_BLOCKED     /* An inner node is not resident, not swizzled or being written; retrying would fail again */
+  };
+
+  /**
+   * Finds the leaf a key belongs in, reading the inner nodes optimistically: they are neither pinned nor
+   * latched, and every read is validated against the frame version before its result is used.
+   * @param key          Key to look for
+   * @param leafPageNum  Page number of the leaf returned via this variable
+   * @param leafFrame    Frame the leaf is in returned via this variable
+   * @return  Whether the leaf was found, and if not whether it is worth trying again.
+   */
+  DescentResult findLeafOptimistic(int key, PageId &leafPageNum, FrameId &leafFrame);
+
+  /**
+   * Recursive function to insert the index entry. Unpins curPage before returning, unless an exception is thrown,
+   * in which case the handles on the call stack unpin their pages.
+   * @param curPage	handle of the current page
    * @param nodeIsLeaf  boolean: if this node is leaf or not
    * @param data        index to be placed
-   * @param child       A pageKeyPair that contains an entry that is pushed up after splitting a node; it is null if no split in child nodes
+   * @param child       Receives the entry to push up if the node is split
+   * @return            True if the node was split
   */
-  const void insert(Page *curPage, PageId curPageNum, bool nodeIsLeaf, const RIDKeyPair<int> data, PageKeyPair<int> *&child);
+  bool insert(PageHandle &curPage, bool nodeIsLeaf, const RIDKeyPair<int> data, PageKeyPair<int> &child);
   
   /**
    * function to insert data into a leaf node
@@ -325,12 +510,11 @@ class BTreeIndex {
 
   /**
    * function to split leaf node
-   * @param curNode       Current leaf node
-   * @param leafPageNum   The number of page of that leaf
-   * @param child         The PageKeyPair that needs to be pushed up
+   * @param leafPage      Handle of the current leaf node
+   * @param child         Receives the PageKeyPair that needs to be pushed up
    * @param data          The data entry that need to be inserted 
   */
-  const void splitLeaf(LeafNodeInt *leaf, PageId leafPageNum, PageKeyPair<int> *&child, const RIDKeyPair<int> data);
+  const void splitLeaf(PageHandle &leafPage, PageKeyPair<int> &child, const RIDKeyPair<int> data);
  
   /**
    * function to insert data into a non leaf node
@@ -342,11 +526,21 @@ class BTreeIndex {
 
  /**
    * function to split the non-leaf node
-   * @param curNode           node to be split
-   * @param curPageNum        PageID of that node
-   * @param child     	      node to be pushed up; node contains new info
+   * @param curPage           handle of the node to be split
+   * @param child     	      entry to insert; replaced by the entry to be pushed up
+   */
+  const void splitNonLeaf(PageHandle &curPage, PageKeyPair<int> &child);
+
+  /**
+   * One step of lookupAsync(): looks the key up in a pinned node, reading the child it leads to through
+   * the scheduler.
+   * @param key         Key to look for
+   * @param node        Handle of the node
+   * @param nodeIsLeaf  boolean: if this node is leaf or not
+   * @param scheduler   Scheduler the reads are made through
+   * @param done        Callback of the lookup
    */
-  const void splitNonLeaf(NonLeafNodeInt *curNode, PageId curPageNum, PageKeyPair<int> *&child);
+  void lookupStep(int key, PageHandle node, bool nodeIsLeaf, AsyncPageScheduler &scheduler, const LookupCallback &done);
 
  public:
 
@@ -387,6 +581,24 @@ class BTreeIndex {
 	const void insertEntry(const void* key, const RecordId rid);
 
 
+  /**
+	 * Look a key up without waiting for the pages on the way to its leaf. Each node is read through the
+	 * scheduler, so one thread can keep many lookups going and the reads of all of them overlap:
+	 *
+	 *   AsyncPageScheduler scheduler(bufMgr);
+	 *   for (int k = 0; k < 100; k++)
+	 *     index.lookupAsync(&keys[k], scheduler, onFound);
+	 *   scheduler.run();
+	 *
+	 * done is called on the thread running the scheduler, or right away if every node is resident.
+	 * No entries may be inserted while lookups are outstanding.
+   * @param key			Key to look for, pointer to integer
+   * @param scheduler	Scheduler the reads are made through
+   * @param done		Receives whether the key was found, its record id, and the exception thrown while reading a node, if any.
+	**/
+	void lookupAsync(const void* key, AsyncPageScheduler& scheduler, LookupCallback done);
+
+
   /**
 	 * Begin a filtered scan of the index.  For instance, if the method is called 
 	 * using ("a",GT,"d",LTE) then we should seek all entries with a value 
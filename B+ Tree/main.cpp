@@ -73,12 +73,20 @@ void indexTests();
 void test1();
 void test2();
 void test3();
+void test4();
+void smallPoolTests();
 void errorTests();
 void deleteRelation();
 
 int main(int argc, char **argv)
 {
-	
+	// An optional argument names a file to record the buffer pool's page
+	// references to, for replay with Buffer Manger/tools/buf_sim.
+	if (argc > 1)
+	{
+		bufMgr->startTrace(argv[1]);
+	}
+
   std::cout << "leaf size:" << INTARRAYLEAFSIZE << " non-leaf size:" << INTARRAYNONLEAFSIZE << std::endl;
 
   // Clean up from any previous runs that crashed.
@@ -140,8 +148,11 @@ int main(int argc, char **argv)
 	test1();
 	test2();
 	test3();
+	test4();
 	//errorTests();
 
+	bufMgr->stopTrace();
+
   return 1;
 }
 
@@ -178,6 +189,17 @@ void test3()
 	deleteRelation();
 }
 
+void test4()
+{
+	// Create a relation with tuples valued 0 to relationSize and build and search an index on it
+	// through a buffer pool much smaller than either
+	std::cout << "--------------------" << std::endl;
+	std::cout << "smallPoolTests" << std::endl;
+	createRelationForward();
+	smallPoolTests();
+	deleteRelation();
+}
+
 // -----------------------------------------------------------------------------
 // createRelationForward
 // -----------------------------------------------------------------------------
@@ -378,10 +400,45 @@ void intTests()
 	checkPassFail(intScan(&index,3000,GTE,4000,LT), 1000)
 }
 
+// -----------------------------------------------------------------------------
+// smallPoolTests
+// -----------------------------------------------------------------------------
+
+void smallPoolTests()
+{
+  std::cout << "Create and search a B+ Tree index through a pool of 10 frames" << std::endl;
+  // Swizzled parents stay pinned; a scan of the whole relation and lookups of
+  // every key must still find frames to read into.
+  BufMgr smallPool(10);
+  {
+    BTreeIndex index(relationName, intIndexName, &smallPool, offsetof(tuple,i), INTEGER);
+    AsyncPageScheduler scheduler(smallPool);
+    int found = 0;
+    for (int key = 0; key < relationSize; key++)
+    {
+      index.lookupAsync(&key, scheduler, [&found](bool hit, RecordId rid, std::exception_ptr error)
+      {
+        if (hit && !error)
+        {
+          found++;
+        }
+      });
+      scheduler.run();
+    }
+    checkPassFail(found, relationSize)
+  }
+  try
+  {
+    File::remove(intIndexName);
+  }
+  catch(FileNotFoundException e)
+  {
+  }
+}
+
 int intScan(BTreeIndex * index, int lowVal, Operator lowOp, int highVal, Operator highOp)
 {
   RecordId scanRid;
-	Page *curPage;
 
   std::cout << "Scan for ";
   if( lowOp == GT ) { std::cout << "("; } else { std::cout << "["; }
@@ -401,31 +458,48 @@ int intScan(BTreeIndex * index, int lowVal, Operator lowOp, int highVal, Operato
 		return 0;
 	}
 
-	while(1)
+	// Fetch the records a batch of entries at a time, so that entries on the
+	// same or neighbouring pages share their reads.
+	const std::size_t batchSize = 32;
+	std::vector<RecordId> rids;
+	std::vector<PageId> pageNos;
+	bool completed = false;
+	while(!completed)
 	{
-		try
+		rids.clear();
+		pageNos.clear();
+		while(rids.size() < batchSize)
 		{
-			index->scanNext(scanRid);
-			bufMgr->readPage(file1, scanRid.page_number, curPage);
-			RECORD myRec = *(reinterpret_cast<const RECORD*>(curPage->getRecord(scanRid).data()));
-			bufMgr->unPinPage(file1, scanRid.page_number, false);
+			try
+			{
+				index->scanNext(scanRid);
+			}
+			catch(IndexScanCompletedException e)
+			{
+				completed = true;
+				break;
+			}
+			rids.push_back(scanRid);
+			pageNos.push_back(scanRid.page_number);
+		}
+
+		std::vector<PageHandle> pages = bufMgr->readPages(file1, pageNos);
+		for (std::size_t k = 0; k < rids.size(); k++)
+		{
+			RECORD myRec = *(reinterpret_cast<const RECORD*>(pages[k]->getRecord(rids[k]).data()));
 
 			if( numResults < 5 )
 			{
-				std::cout << "at:" << scanRid.page_number << "," << scanRid.slot_number;
+				std::cout << "at:" << rids[k].page_number << "," << rids[k].slot_number;
 				std::cout << " -->:" << myRec.i << ":" << myRec.d << ":" << myRec.s << ":" <<std::endl;
 			}
 			else if( numResults == 5 )
 			{
 				std::cout << "..." << std::endl;
 			}
-		}
-		catch(IndexScanCompletedException e)
-		{
-			break;
-		}
 
-		numResults++;
+			numResults++;
+		}
 	}
 
   if( numResults >= 5 )
@@ -0,0 +1,83 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
+ */
+
+#include "admission_filter.h"
+#include "bufHashTbl.h"
+
+namespace badgerdb {
+
+const std::uint8_t AdmissionFilter::MAX_COUNT;
+const int AdmissionFilter::DEPTH;
+const std::uint32_t AdmissionFilter::SAMPLE_FACTOR;
+
+AdmissionFilter::AdmissionFilter(std::uint32_t numFrames)
+{
+  resize(numFrames);
+}
+
+void AdmissionFilter::resize(std::uint32_t numFrames)
+{
+  // A row has at least four counters per frame, so that a page read once
+  // rarely shares all its counters with pages read often.
+  std::uint32_t width = 64;
+  while (width < 4 * (std::uint64_t) numFrames && width < (1u << 24))
+    width <<= 1;
+  mask = width - 1;
+  counters.assign((std::size_t) width * DEPTH / 2, 0);
+  reads = 0;
+  sampleSize = width * SAMPLE_FACTOR;
+}
+
+void AdmissionFilter::index(const File* file, PageId pageNo, std::size_t slots[DEPTH]) const
+{
+  // Pages of a partition share the high bits of the hash and hash table
+  // buckets are picked with its low bits, so remix it for every row.
+  std::uint64_t h = BufHashTbl::hash(file, pageNo);
+  for (int row = 0; row < DEPTH; row++) {
+    h = (h ^ (h >> 31)) * 0xbf58476d1ce4e5b9ULL;
+    h ^= h >> 29;
+    slots[row] = (std::size_t) row * (mask + 1) + (std::size_t) (h & mask);
+  }
+}
+
+void AdmissionFilter::pageRead(const File* file, PageId pageNo)
+{
+  std::size_t slots[DEPTH];
+  index(file, pageNo, slots);
+  std::uint8_t least = MAX_COUNT;
+  for (int row = 0; row < DEPTH; row++) {
+    if (count(slots[row]) < least)
+      least = count(slots[row]);
+  }
+  if (least < MAX_COUNT) {
+    for (int row = 0; row < DEPTH; row++) {
+      if (count(slots[row]) == least)
+        increment(slots[row]);
+    }
+  }
+  if (++reads >= sampleSize) {
+    // Age the counts, both nibbles of a byte at once; the mask drops the
+    // bit the high nibble shifts into the low one.
+    for (std::size_t c = 0; c < counters.size(); c++)
+      counters[c] = (counters[c] >> 1) & 0x77;
+    reads /= 2;
+  }
+}
+
+std::uint32_t AdmissionFilter::estimate(const File* file, PageId pageNo) const
+{
+  std::size_t slots[DEPTH];
+  index(file, pageNo, slots);
+  std::uint8_t least = MAX_COUNT;
+  for (int row = 0; row < DEPTH; row++) {
+    if (count(slots[row]) < least)
+      least = count(slots[row]);
+  }
+  return least;
+}
+
+}
@@ -0,0 +1,127 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include "file.h"
+#include "types.h"
+
+namespace badgerdb {
+
+/**
+* @brief Estimates how often the pages of a buffer pool partition have been read lately, to decide whether a
+* page read on a miss is worth evicting the victim the replacement policy picked (TinyLFU).
+*
+* The counts are kept in a count-min sketch: DEPTH rows of 4-bit saturating counters, each row indexed by
+* a different hash of the page. A read increments the smallest of the page's counters (conservative update)
+* and the estimate is the smallest of them, so collisions can only overstate a count. Once SAMPLE_FACTOR
+* reads per counter of a row have been recorded, every counter is halved, so pages that were read often
+* long ago fade out and the estimates follow changes in the workload.
+*
+* Two counters share a byte, so the sketch takes 8 to 16 bytes per frame whatever the number of pages read,
+* and recording a read costs DEPTH memory accesses.
+*
+* @warning This class is not threadsafe. Each partition has its own, guarded by the partition latch.
+*/
+class AdmissionFilter
+{
+ public:
+	/**
+   * Highest count a counter can reach
+	 */
+  static const std::uint8_t MAX_COUNT = 15;
+
+	/**
+	 * Constructor of AdmissionFilter class.
+	 *
+	 * @param numFrames   Number of frames of the partition
+	 */
+  explicit AdmissionFilter(std::uint32_t numFrames);
+
+	/**
+	 * Starts over for a new partition size, forgetting the counts.
+	 */
+  void resize(std::uint32_t numFrames);
+
+	/**
+	 * Records a read of a page.
+	 */
+  void pageRead(const File* file, PageId pageNo);
+
+	/**
+	 * Estimated number of recent reads of a page, at most MAX_COUNT.
+	 */
+  std::uint32_t estimate(const File* file, PageId pageNo) const;
+
+	/**
+	 * Decides whether a page read on a miss may take the frame of the victim. Ties go to the victim, so a
+	 * burst of pages read once cannot displace anything that was read again.
+	 *
+	 * @param file          File of the page read
+	 * @param pageNo        Page number of the page read
+	 * @param victimFile    File of the page the replacement policy would evict
+	 * @param victimPageNo  Page number of the page the replacement policy would evict
+	 * @return  True if the page read has been read more often than the victim.
+	 */
+  bool admit(const File* file, PageId pageNo, const File* victimFile, PageId victimPageNo) const
+  {
+    return estimate(file, pageNo) > estimate(victimFile, victimPageNo);
+  }
+
+ private:
+	/**
+   * Number of rows of counters
+	 */
+  static const int DEPTH = 4;
+
+	/**
+   * Reads recorded per counter of a row before all counts are halved
+	 */
+  static const std::uint32_t SAMPLE_FACTOR = 10;
+
+	/**
+   * Counters of all rows, row after row, two to a byte: counter c is the low nibble of byte c / 2 if c is
+   * even and the high nibble otherwise
+	 */
+  std::vector<std::uint8_t> counters;
+
+	/**
+   * Number of counters per row, a power of two, minus one
+	 */
+  std::uint32_t mask;
+
+	/**
+   * Reads recorded since the counts were last halved, and the number that triggers the next halving
+	 */
+  std::uint32_t reads;
+  std::uint32_t sampleSize;
+
+	/**
+	 * Index of the counter of a page in every row, into counters.
+	 */
+  void index(const File* file, PageId pageNo, std::size_t slots[DEPTH]) const;
+
+	/**
+	 * Value of a counter.
+	 */
+  std::uint8_t count(std::size_t slot) const
+  {
+    return (counters[slot >> 1] >> ((slot & 1) << 2)) & MAX_COUNT;
+  }
+
+	/**
+	 * Adds one to a counter, which must be below MAX_COUNT.
+	 */
+  void increment(std::size_t slot)
+  {
+    counters[slot >> 1] += (std::uint8_t) (1 << ((slot & 1) << 2));
+  }
+};
+
+}
@@ -0,0 +1,102 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
+ */
+
+#include <memory>
+#include <thread>
+#include "async_page.h"
+
+namespace badgerdb {
+
+AsyncPageScheduler::AsyncPageScheduler(BufMgr& mgr)
+  : bufMgr(mgr), pending(0)
+{
+}
+
+AsyncPageScheduler::~AsyncPageScheduler()
+{
+  std::unique_lock<std::mutex> guard(latch);
+  while (pending != 0)
+    readyChanged.wait(guard);
+  ready.clear();
+}
+
+void AsyncPageScheduler::readPage(File* file, PageId pageNo, PageCallback done)
+{
+  {
+    std::lock_guard<std::mutex> guard(latch);
+    pending++;
+  }
+  std::shared_ptr<PageCallback> callback = std::make_shared<PageCallback>(done);
+  std::thread::id caller = std::this_thread::get_id();
+  bufMgr.readPageAsync(file, pageNo, [this, callback, caller](PageHandle page, std::exception_ptr error) {
+    if (std::this_thread::get_id() == caller) {
+      // A resident page, passed on before readPageAsync() returns.
+      {
+        std::lock_guard<std::mutex> guard(latch);
+        pending--;
+      }
+      (*callback)(std::move(page), error);
+      return;
+    }
+    // Called by an I/O worker. std::function needs a copyable target,
+    // so the handle travels in a shared pointer.
+    std::shared_ptr<PageHandle> handle = std::make_shared<PageHandle>(std::move(page));
+    {
+      std::lock_guard<std::mutex> guard(latch);
+      ready.push_back([callback, handle, error]() { (*callback)(std::move(*handle), error); });
+      pending--;
+      // Notify under the latch: once pending drops to zero the destructor
+      // may run, and the condition variable must still exist here.
+      readyChanged.notify_all();
+    }
+  });
+}
+
+void AsyncPageScheduler::post(std::function<void()> task)
+{
+  {
+    std::lock_guard<std::mutex> guard(latch);
+    ready.push_back(task);
+  }
+  readyChanged.notify_all();
+}
+
+void AsyncPageScheduler::run()
+{
+  std::unique_lock<std::mutex> guard(latch);
+  for (;;) {
+    while (ready.empty() && pending != 0)
+      readyChanged.wait(guard);
+    if (ready.empty())
+      return;
+    std::function<void()> next = std::move(ready.front());
+    ready.pop_front();
+    guard.unlock();
+    next();
+    guard.lock();
+  }
+}
+
+std::size_t AsyncPageScheduler::runOnce()
+{
+  std::deque<std::function<void()> > batch;
+  {
+    std::lock_guard<std::mutex> guard(latch);
+    batch.swap(ready);
+  }
+  for (std::size_t t = 0; t < batch.size(); t++)
+    batch[t]();
+  return batch.size();
+}
+
+std::size_t AsyncPageScheduler::outstanding()
+{
+  std::lock_guard<std::mutex> guard(latch);
+  return pending + ready.size();
+}
+
+}
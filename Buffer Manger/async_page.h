@@ -0,0 +1,216 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
+ */
+
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include "buffer.h"
+
+#ifdef __cpp_impl_coroutine
+#include <coroutine>
+#endif
+
+namespace badgerdb {
+
+/**
+* @brief Runs the callbacks of asynchronous page reads on one thread, so that the thread can keep many
+* reads outstanding without blocking on any of them.
+*
+* readPage() passes a resident page to its callback right away. A page that has to come from disk is read
+* by the I/O workers of the BufMgr, and its callback is queued here until the owning thread calls run()
+* or runOnce(). Callbacks may start further reads, so a chain of reads such as a B+ tree descent runs as
+* a sequence of callbacks:
+*
+*   AsyncPageScheduler scheduler(bufMgr);
+*   for (int k = 0; k < 100; k++)
+*     index.lookupAsync(keys[k], scheduler, onFound);
+*   scheduler.run();  // returns once all 100 lookups are done
+*
+* Built with C++20 coroutines, co_await scheduler.readPageAsync(file, pageNo) reads a page the same way
+* from a coroutine; see PageTask.
+*
+* A completed read keeps its page pinned until its callback has run, so the reads outstanding at a time
+* must leave frames for the rest of the pool.
+*
+* Outstanding reads let the owning thread get on with other work, but few of them overlap on the disk:
+* misses are read by the BufMgr::PREFETCH_THREADS (two) I/O workers, and reads of the same file are
+* serialized on its I/O latch like every other page read and write. Many reads outstanding hide the
+* latency of the disk from the caller without adding much to its throughput.
+*
+* Only readPage() and post() may be called from other threads; the callbacks always run on the thread
+* calling run() or runOnce().
+*/
+class AsyncPageScheduler
+{
+ public:
+	/**
+	 * Constructor of AsyncPageScheduler class.
+	 *
+	 * @param mgr   	Buffer manager to read pages from
+	 */
+  explicit AsyncPageScheduler(BufMgr& mgr);
+
+	/**
+   * Waits for the outstanding reads and drops their callbacks, which unpins their pages
+	 */
+  ~AsyncPageScheduler();
+
+  AsyncPageScheduler(const AsyncPageScheduler&) = delete;
+  AsyncPageScheduler& operator=(const AsyncPageScheduler&) = delete;
+
+	/**
+	 * Reads a page. See BufMgr::readPageAsync().
+	 *
+	 * @param file   	File object
+	 * @param pageNo  Page number
+	 * @param done   	Receives the page or the exception thrown while reading it. Called at once for a
+	 *               	resident page, otherwise by run() or runOnce().
+	 */
+  void readPage(File* file, PageId pageNo, PageCallback done);
+
+	/**
+	 * Queues a task to be run by run() or runOnce().
+	 */
+  void post(std::function<void()> task);
+
+	/**
+	 * Runs the queued callbacks and tasks, including those they queue, until none are outstanding.
+	 */
+  void run();
+
+	/**
+	 * Runs the callbacks and tasks queued so far without waiting for outstanding reads.
+	 *
+	 * @return  			Number of callbacks and tasks run.
+	 */
+  std::size_t runOnce();
+
+	/**
+   * Number of reads whose callback has not run yet, plus queued tasks
+	 */
+  std::size_t outstanding();
+
+#ifdef __cpp_impl_coroutine
+	/**
+	 * @brief Awaitable read of a page, returned by readPageAsync(). Does not suspend the coroutine if the
+	 * page is resident; otherwise the coroutine is resumed by run() once the page has been read.
+	 */
+  class ReadAwaitable
+  {
+   public:
+    ReadAwaitable(AsyncPageScheduler& scheduler, File* file, PageId pageNo)
+      : scheduler(scheduler), file(file), pageNo(pageNo), suspending(false), completed(false)
+    {
+    }
+
+    bool await_ready() { return false; }
+
+    bool await_suspend(std::coroutine_handle<> coroutine)
+    {
+      suspending = true;
+      scheduler.readPage(file, pageNo, [this, coroutine](PageHandle read, std::exception_ptr failure) {
+        page = std::move(read);
+        error = failure;
+        // A resident page arrives before readPage() returns; the
+        // coroutine then simply continues.
+        if (suspending)
+          completed = true;
+        else
+          coroutine.resume();
+      });
+      suspending = false;
+      return !completed;
+    }
+
+	/**
+	 * @return  			Handle of the page.
+	 * @throws  The exception thrown while reading the page
+	 */
+    PageHandle await_resume()
+    {
+      if (error)
+        std::rethrow_exception(error);
+      return std::move(page);
+    }
+
+   private:
+    AsyncPageScheduler& scheduler;
+    File* file;
+    PageId pageNo;
+    PageHandle page;
+    std::exception_ptr error;
+    bool suspending;
+    bool completed;
+  };
+
+	/**
+	 * Reads a page from a coroutine: PageHandle page = co_await scheduler.readPageAsync(file, pageNo).
+	 */
+  ReadAwaitable readPageAsync(File* file, PageId pageNo)
+  {
+    return ReadAwaitable(*this, file, pageNo);
+  }
+#endif
+
+ private:
+	/**
+   * The buffer manager
+	 */
+  BufMgr& bufMgr;
+
+	/**
+   * Protects ready and pending
+	 */
+  std::mutex latch;
+
+	/**
+   * Signalled when a callback or task is queued
+	 */
+  std::condition_variable readyChanged;
+
+	/**
+   * Callbacks of completed reads and posted tasks, in the order they were queued
+	 */
+  std::deque<std::function<void()> > ready;
+
+	/**
+   * Number of reads handed to the I/O workers whose callback has not been queued yet
+	 */
+  std::size_t pending;
+};
+
+#ifdef __cpp_impl_coroutine
+/**
+* @brief Return type of coroutines that read pages through an AsyncPageScheduler. The coroutine starts
+* running when it is called and frees itself when it finishes; an exception escaping it terminates the
+* program, so it should catch what it expects:
+*
+*   PageTask copyPage(AsyncPageScheduler& scheduler, File* file, PageId pageNo, Page& copy)
+*   {
+*     PageHandle page = co_await scheduler.readPageAsync(file, pageNo);
+*     copy = *page;
+*   }
+*/
+struct PageTask
+{
+  struct promise_type
+  {
+    PageTask get_return_object() { return PageTask(); }
+    std::suspend_never initial_suspend() noexcept { return std::suspend_never(); }
+    std::suspend_never final_suspend() noexcept { return std::suspend_never(); }
+    void return_void() {}
+    void unhandled_exception() { std::terminate(); }
+  };
+};
+#endif
+
+}
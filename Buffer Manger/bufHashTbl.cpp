@@ -15,100 +15,185 @@
 
 namespace badgerdb {
 
-int BufHashTbl::hash(const File* file, const PageId pageNo)
+std::uint32_t BufHashTbl::findSlot(const hashBucket* table, const std::uint32_t mask, const File* file, const PageId pageNo)
 {
-  int tmp, value;
-  tmp = (long)file;  // cast of pointer to the file object to an integer
-  value = (tmp + pageNo) % HTSIZE;
-  return value;
+  std::uint32_t index = (std::uint32_t) hash(file, pageNo) & mask;
+  // The table is never full, so every probe run ends at an empty bucket.
+  while (table[index].file != NULL &&
+         (table[index].file != file || table[index].pageNo != pageNo))
+    index = (index + 1) & mask;
+  return index;
 }
 
-BufHashTbl::BufHashTbl(int htSize)
-	: HTSIZE(htSize)
+void BufHashTbl::removeSlot(hashBucket* table, const std::uint32_t mask, std::uint32_t hole)
 {
-  // allocate an array of pointers to hashBuckets
-  ht = new hashBucket* [htSize];
-  for(int i=0; i < HTSIZE; i++)
-    ht[i] = NULL;
+  // Shift later entries of the probe run back into the hole, so lookups
+  // never have to skip over deleted buckets.
+  std::uint32_t index = hole;
+  for (;;)
+	{
+    index = (index + 1) & mask;
+    if (table[index].file == NULL)
+      break;
+    std::uint32_t home = (std::uint32_t) hash(table[index].file, table[index].pageNo) & mask;
+    // Move the entry only if its home bucket does not lie cyclically in
+    // (hole, index], otherwise it would become unreachable.
+    if (((index - home) & mask) >= ((index - hole) & mask))
+		{
+      table[hole] = table[index];
+      hole = index;
+    }
+  }
+  table[hole].file = NULL;
+}
+
+BufHashTbl::BufHashTbl(const std::uint32_t maxEntries)
+	: numEntries(0), maxEntries(maxEntries), oldHt(NULL), oldMask(0), oldEntries(0), rehashCursor(0)
+{
+  // Keep the load factor at or below one half so probe runs stay short.
+  HTSIZE = 2;
+  while (HTSIZE < 2 * maxEntries)
+    HTSIZE <<= 1;
+  mask = HTSIZE - 1;
+
+  // allocate a flat array of buckets
+  ht = new hashBucket [HTSIZE];
+  for(std::uint32_t i=0; i < HTSIZE; i++)
+    ht[i].file = NULL;
 }
 
 BufHashTbl::~BufHashTbl()
 {
-  for(int i = 0; i < HTSIZE; i++) {
-    hashBucket* tmpBuf = ht[i];
-    while (ht[i]) {
-      tmpBuf = ht[i];
-      ht[i] = ht[i]->next;
-      delete tmpBuf;
+  delete [] ht;
+  delete [] oldHt;
+}
+
+void BufHashTbl::rehashStep(std::uint32_t buckets)
+{
+  while (oldHt != NULL && buckets-- > 0)
+  {
+    if (oldEntries == 0)
+    {
+      delete [] oldHt;
+      oldHt = NULL;
+      break;
     }
+    hashBucket& bucket = oldHt[rehashCursor];
+    if (bucket.file == NULL)
+    {
+      rehashCursor = (rehashCursor + 1) & oldMask;
+      continue;
+    }
+    ht[findSlot(ht, mask, bucket.file, bucket.pageNo)] = bucket;
+    // Removing may shift the next entry of the run into this bucket, so the
+    // cursor stays put.
+    removeSlot(oldHt, oldMask, rehashCursor);
+    oldEntries--;
   }
-  delete [] ht;
 }
 
 void BufHashTbl::insert(const File* file, const PageId pageNo, const FrameId frameNo)
 {
-  int index = hash(file, pageNo);
+  rehashStep(REHASH_STEP);
 
-  hashBucket* tmpBuc = ht[index];
-  while (tmpBuc) {
-    if (tmpBuc->file == file && tmpBuc->pageNo == pageNo)
-  		throw HashAlreadyPresentException(tmpBuc->file->filename(), tmpBuc->pageNo, tmpBuc->frameNo);
-    tmpBuc = tmpBuc->next;
+  std::uint32_t index = findSlot(ht, mask, file, pageNo);
+
+  if (ht[index].file != NULL)
+		throw HashAlreadyPresentException(ht[index].file->filename(), ht[index].pageNo, ht[index].frameNo);
+
+  if (oldHt != NULL)
+  {
+    std::uint32_t oldIndex = findSlot(oldHt, oldMask, file, pageNo);
+    if (oldHt[oldIndex].file != NULL)
+      throw HashAlreadyPresentException(oldHt[oldIndex].file->filename(), oldHt[oldIndex].pageNo, oldHt[oldIndex].frameNo);
   }
 
-  tmpBuc = new hashBucket;
-  if (!tmpBuc)
+  if (numEntries >= maxEntries)
   	throw HashTableException();
 
-  tmpBuc->file = (File*) file;
-  tmpBuc->pageNo = pageNo;
-  tmpBuc->frameNo = frameNo;
-  tmpBuc->next = ht[index];
-  ht[index] = tmpBuc;
+  ht[index].file = (File*) file;
+  ht[index].pageNo = pageNo;
+  ht[index].frameNo = frameNo;
+  numEntries++;
 }
 
-void BufHashTbl::lookup(const File* file, const PageId pageNo, FrameId &frameNo) 
+bool BufHashTbl::find(const File* file, const PageId pageNo, FrameId &frameNo) const
 {
-  int index = hash(file, pageNo);
-  hashBucket* tmpBuc = ht[index];
-  while (tmpBuc) {
-    if (tmpBuc->file == file && tmpBuc->pageNo == pageNo)
+  std::uint32_t index = findSlot(ht, mask, file, pageNo);
+  if (ht[index].file != NULL)
+  {
+    frameNo = ht[index].frameNo; // return frameNo by reference
+    return true;
+  }
+  if (oldHt != NULL)
+  {
+    index = findSlot(oldHt, oldMask, file, pageNo);
+    if (oldHt[index].file != NULL)
     {
-      frameNo = tmpBuc->frameNo; // return frameNo by reference
-      return;
+      frameNo = oldHt[index].frameNo;
+      return true;
     }
-    tmpBuc = tmpBuc->next;
   }
+  return false;
+}
 
-  throw HashNotFoundException(file->filename(), pageNo);
+void BufHashTbl::lookup(const File* file, const PageId pageNo, FrameId &frameNo) 
+{
+  if (!find(file, pageNo, frameNo))
+    throw HashNotFoundException(file->filename(), pageNo);
 }
 
 void BufHashTbl::remove(const File* file, const PageId pageNo) {
 
-  int index = hash(file, pageNo);
-  hashBucket* tmpBuc = ht[index];
-  hashBucket* prevBuc = NULL;
+  rehashStep(REHASH_STEP);
 
-  while (tmpBuc)
-	{
-    if (tmpBuc->file == file && tmpBuc->pageNo == pageNo)
-		{
-      if(prevBuc) 
-				prevBuc->next = tmpBuc->next;
-      else
-				ht[index] = tmpBuc->next;
-
-      delete tmpBuc;
+  std::uint32_t hole = findSlot(ht, mask, file, pageNo);
+  if (ht[hole].file != NULL)
+  {
+    removeSlot(ht, mask, hole);
+    numEntries--;
+    return;
+  }
+  if (oldHt != NULL)
+  {
+    hole = findSlot(oldHt, oldMask, file, pageNo);
+    if (oldHt[hole].file != NULL)
+    {
+      removeSlot(oldHt, oldMask, hole);
+      oldEntries--;
+      numEntries--;
       return;
-    }
-		else
-		{
-      prevBuc = tmpBuc;
-      tmpBuc = tmpBuc->next;
     }
   }
-
   throw HashNotFoundException(file->filename(), pageNo);
 }
 
+void BufHashTbl::resize(const std::uint32_t newMaxEntries)
+{
+  if (numEntries > newMaxEntries)
+  	throw HashTableException();
+
+  // Only one old table is kept around at a time.
+  while (oldHt != NULL)
+    rehashStep(HTSIZE);
+
+  maxEntries = newMaxEntries;
+  std::uint32_t size = 2;
+  while (size < 2 * newMaxEntries)
+    size <<= 1;
+  if (size == HTSIZE)
+    return;
+
+  oldHt = ht;
+  oldMask = mask;
+  oldEntries = numEntries;
+  rehashCursor = 0;
+
+  HTSIZE = size;
+  mask = HTSIZE - 1;
+  ht = new hashBucket [HTSIZE];
+  for(std::uint32_t i=0; i < HTSIZE; i++)
+    ht[i].file = NULL;
+}
+
 }
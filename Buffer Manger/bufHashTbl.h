@@ -7,6 +7,7 @@
 
 #pragma once
 
+#include <cstdint>
 #include "file.h"
 
 namespace badgerdb {
@@ -16,7 +17,7 @@ namespace badgerdb {
 */
 struct hashBucket {
 	/**
-	 * pointer a file object (more on this below)
+	 * pointer a file object (more on this below). NULL marks an empty slot.
 	 */
 	File *file;
 
@@ -29,45 +30,125 @@ struct hashBucket {
 	 * frame number of page in the buffer pool
 	 */
 	FrameId frameNo;
-
-	/**
-	 * Next node in the hash table
-	 */
-	hashBucket*   next;
 };
 
 
 /**
 * @brief Hash table class to keep track of pages in the buffer pool
 *
+* The table is a flat array of buckets using open addressing with linear probing, so insert and remove
+* never allocate and a lookup usually touches one or two cache lines. Removal shifts the following
+* entries of the probe run back instead of leaving tombstones. The table is sized for the maximum number
+* of entries it has to hold (one per frame). resize() changes that maximum without a pause: a new array is
+* allocated and every insert or remove moves a few buckets of the old one over, while lookups consult both.
+*
 * @warning This class is not threadsafe.
 */
 class BufHashTbl
 {
  private:
 	/**
-	 *	Size of Hash Table
+	 *	Number of buckets in the table, always a power of two
 	 */
-  int HTSIZE;
+  std::uint32_t HTSIZE;
+
+	/**
+	 *	HTSIZE - 1, used to wrap bucket indexes
+	 */
+  std::uint32_t mask;
+
+	/**
+	 *	Number of entries currently in the table
+	 */
+  std::uint32_t numEntries;
+
+	/**
+	 *	Maximum number of entries the table accepts
+	 */
+  std::uint32_t maxEntries;
+
 	/**
 	 * Actual Hash table object
 	 */
-  hashBucket**  ht;
+  hashBucket*  ht;
+
+	/**
+	 *	Table being drained into ht after a resize, NULL when no rehash is in progress
+	 */
+  hashBucket*  oldHt;
+
+	/**
+	 *	Bucket index mask of oldHt
+	 */
+  std::uint32_t oldMask;
+
+	/**
+	 *	Number of entries still in oldHt (included in numEntries)
+	 */
+  std::uint32_t oldEntries;
 
 	/**
-	 * returns hash value between 0 and HTSIZE-1 computed using file and pageNo
+	 *	Next bucket of oldHt to move over
+	 */
+  std::uint32_t rehashCursor;
+
+	/**
+	 *	Number of buckets of oldHt examined by every insert and remove
+	 */
+  static const std::uint32_t REHASH_STEP = 8;
+
+	/**
+	 * returns the index of the bucket holding (file, pageNo), or of the empty bucket ending its probe run
 	 *
+	 * @param table  	Bucket array to search
+	 * @param mask  	Bucket index mask of the array
 	 * @param file   	File object
 	 * @param pageNo  Page number in the file
-	 * @return  			Hash value.
+	 * @return  			Bucket index.
 	 */
-  int	 hash(const File* file, const PageId pageNo);
+  static std::uint32_t findSlot(const hashBucket* table, const std::uint32_t mask, const File* file, const PageId pageNo);
+
+	/**
+	 * empties a bucket, shifting later entries of its probe run back into the hole
+	 *
+	 * @param table  	Bucket array holding the bucket
+	 * @param mask  	Bucket index mask of the array
+	 * @param hole  	Index of the bucket to empty
+	 */
+  static void removeSlot(hashBucket* table, const std::uint32_t mask, std::uint32_t hole);
+
+	/**
+	 * moves entries of oldHt over to ht, releasing oldHt once it is empty
+	 *
+	 * @param buckets	Maximum number of buckets of oldHt to examine
+	 */
+  void rehashStep(std::uint32_t buckets);
 
  public:
 	/**
+	 * returns a well mixed 64 bit hash value computed using file and pageNo. The buffer manager uses the
+	 * high bits to pick a partition and the table uses the low bits to pick a bucket.
+	 *
+	 * @param file   	File object
+	 * @param pageNo  Page number in the file
+	 * @return  			Hash value.
+	 */
+  static std::uint64_t hash(const File* file, const PageId pageNo)
+  {
+    std::uint64_t h = (std::uint64_t) (std::uintptr_t) file;
+    h ^= (std::uint64_t) pageNo * 0x9E3779B97F4A7C15ULL;
+    h ^= h >> 33;
+    h *= 0xFF51AFD7ED558CCDULL;
+    h ^= h >> 33;
+    return h;
+  }
+
+	/**
    * Constructor of BufHashTbl class
+	 *
+	 * @param maxEntries 	Maximum number of entries the table has to hold, normally the number of frames
 	 */
-	BufHashTbl(const int htSize);  // constructor
+	BufHashTbl(const std::uint32_t maxEntries);  // constructor
 
 	/**
    * Destructor of BufHashTbl class
@@ -81,12 +162,23 @@ class BufHashTbl
 	 * @param pageNo 	Page number in the file
 	 * @param frameNo Frame number assigned to that page of the file
    * @throws  HashAlreadyPresentException	if the corresponding page already exists in the hash table
-   * @throws  HashTableException (optional) if could not create a new bucket as running of memory
+   * @throws  HashTableException if the table already holds the maximum number of entries
 	 */
   void insert(const File* file, const PageId pageNo, const FrameId frameNo);
 
 	/**
    * Check if (file, pageNo) is currently in the buffer pool (ie. in
+   * the hash table). Does not throw; the buffer manager uses this on its hot paths.
+	 *
+	 * @param file  	File object
+	 * @param pageNo	Page number in the file
+	 * @param frameNo Frame number reference, only set if the entry is found
+	 * @return  			True if the page entry is in the hash table.
+	 */
+  bool find(const File* file, const PageId pageNo, FrameId &frameNo) const;
+
+	/**
+   * Check if (file, pageNo) is currently in the buffer pool (ie. in
    * the hash table).
 	 *
 	 * @param file  	File object
@@ -104,6 +196,20 @@ class BufHashTbl
    * @throws HashNotFoundException if the page entry is not found in the hash table 
 	 */
   void remove(const File* file, const PageId pageNo);  
+
+	/**
+   * Change the maximum number of entries. If this needs a table of a different size, the entries are
+   * moved over incrementally by later inserts and removes; a rehash still in progress is finished first.
+	 *
+	 * @param maxEntries 	New maximum number of entries
+   * @throws  HashTableException if the table currently holds more than maxEntries entries
+	 */
+  void resize(const std::uint32_t maxEntries);
+
+	/**
+   * Returns true while entries are still being moved over after a resize().
+	 */
+  bool rehashing() const { return oldHt != NULL; }
 };
 
 }
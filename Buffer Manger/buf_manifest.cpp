@@ -0,0 +1,96 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
+ */
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include "buf_manifest.h"
+#include "exceptions/bad_manifest_exception.h"
+#include "exceptions/file_not_found_exception.h"
+
+namespace badgerdb {
+
+namespace {
+
+const char MAGIC[4] = {'B', 'M', 'F', '1'};
+
+// Longest file name accepted when reading, so a corrupt length cannot
+// make load() allocate without bound.
+const std::uint32_t MAX_NAME_LENGTH = 4096;
+
+void writeInt(std::ofstream& out, std::uint32_t value)
+{
+  out.write(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+bool readInt(std::ifstream& in, std::uint32_t& value)
+{
+  return (bool) in.read(reinterpret_cast<char*>(&value), sizeof(value));
+}
+
+}
+
+void BufManifest::save(const std::string& path) const
+{
+  std::string tmpPath = path + ".tmp";
+  {
+    std::ofstream out(tmpPath.c_str(), std::ios::binary | std::ios::trunc);
+    out.write(MAGIC, sizeof(MAGIC));
+    writeInt(out, (std::uint32_t) files.size());
+    for (std::size_t f = 0; f < files.size(); f++) {
+      writeInt(out, (std::uint32_t) files[f].size());
+      out.write(files[f].data(), files[f].size());
+    }
+    writeInt(out, (std::uint32_t) entries.size());
+    for (std::size_t e = 0; e < entries.size(); e++) {
+      writeInt(out, entries[e].file);
+      writeInt(out, entries[e].pageNo);
+    }
+    out.flush();
+    if (!out) {
+      std::remove(tmpPath.c_str());
+      throw BadManifestException(path);
+    }
+  }
+  if (std::rename(tmpPath.c_str(), path.c_str()) != 0) {
+    std::remove(tmpPath.c_str());
+    throw BadManifestException(path);
+  }
+}
+
+BufManifest BufManifest::load(const std::string& path)
+{
+  std::ifstream in(path.c_str(), std::ios::binary);
+  if (!in)
+    throw FileNotFoundException(path);
+  BufManifest manifest;
+  char magic[sizeof(MAGIC)];
+  std::uint32_t numFiles, numEntries;
+  if (!in.read(magic, sizeof(magic)) || std::memcmp(magic, MAGIC, sizeof(MAGIC)) != 0 ||
+      !readInt(in, numFiles))
+    throw BadManifestException(path);
+  for (std::uint32_t f = 0; f < numFiles; f++) {
+    std::uint32_t length;
+    if (!readInt(in, length) || length > MAX_NAME_LENGTH)
+      throw BadManifestException(path);
+    std::string name(length, '\0');
+    if (length != 0 && !in.read(&name[0], length))
+      throw BadManifestException(path);
+    manifest.files.push_back(name);
+  }
+  if (!readInt(in, numEntries))
+    throw BadManifestException(path);
+  for (std::uint32_t e = 0; e < numEntries; e++) {
+    Entry entry;
+    if (!readInt(in, entry.file) || !readInt(in, entry.pageNo) || entry.file >= numFiles)
+      throw BadManifestException(path);
+    manifest.entries.push_back(entry);
+  }
+  return manifest;
+}
+
+}
@@ -0,0 +1,72 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "types.h"
+
+namespace badgerdb {
+
+/**
+* @brief List of the pages resident in a buffer pool, hottest first, saved so that a restarted pool can
+* load them again. See BufMgr::saveManifest() and BufMgr::warmUp().
+*
+* On disk a manifest is the magic "BMF1", the number of files and their names, each preceded by its
+* length, then the number of entries and the entries as pairs of file index and page number. Integers
+* are 32 bits in the byte order of the machine; a manifest is only meant for the machine that wrote it.
+*/
+struct BufManifest
+{
+	/**
+   * @brief A resident page
+	 */
+  struct Entry
+  {
+	/**
+   * Index of the file in files
+	 */
+    std::uint32_t file;
+
+	/**
+   * Page number within the file
+	 */
+    PageId pageNo;
+  };
+
+	/**
+   * Names of the files pages were resident of
+	 */
+  std::vector<std::string> files;
+
+	/**
+   * Resident pages, hottest first
+	 */
+  std::vector<Entry> entries;
+
+	/**
+	 * Writes the manifest to a file, replacing it atomically: the manifest is written next to it first
+	 * and renamed, so a crash leaves either the old or the new manifest.
+	 *
+	 * @param path   	Name of the manifest file
+	 * @throws BadManifestException If the file cannot be written
+	 */
+  void save(const std::string& path) const;
+
+	/**
+	 * Reads a manifest written by save().
+	 *
+	 * @param path   	Name of the manifest file
+	 * @throws FileNotFoundException If there is no such file
+	 * @throws BadManifestException If the file is not a valid manifest
+	 */
+  static BufManifest load(const std::string& path);
+};
+
+}
@@ -0,0 +1,139 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
+ */
+
+#include "buf_pool_set.h"
+#include "exceptions/pool_exists_exception.h"
+#include "exceptions/pool_not_found_exception.h"
+
+namespace badgerdb {
+
+BufPoolSet::BufPoolSet()
+  : defaultPool(NULL)
+{
+}
+
+BufPoolSet::~BufPoolSet()
+{
+  for (std::map<std::string, BufMgr*>::iterator it = pools.begin(); it != pools.end(); ++it)
+    delete it->second;
+}
+
+BufMgr& BufPoolSet::createPool(const std::string& name, std::uint32_t bufs, std::uint32_t parts,
+                               ReplacementPolicyType policy, bool hugePages, std::uint32_t maxBufs)
+{
+  std::lock_guard<std::mutex> guard(latch);
+  if (pools.count(name) != 0)
+    throw PoolExistsException(name);
+  BufMgr* pool = new BufMgr(bufs, parts, policy, hugePages, maxBufs);
+  pools[name] = pool;
+  if (defaultPool == NULL)
+    defaultPool = pool;
+  return *pool;
+}
+
+BufMgr& BufPoolSet::findPool(const std::string& name)
+{
+  std::map<std::string, BufMgr*>::iterator it = pools.find(name);
+  if (it == pools.end())
+    throw PoolNotFoundException(name);
+  return *it->second;
+}
+
+BufMgr& BufPoolSet::getPool(const std::string& name)
+{
+  std::lock_guard<std::mutex> guard(latch);
+  return findPool(name);
+}
+
+void BufPoolSet::bindFile(const std::string& pattern, const std::string& poolName)
+{
+  std::lock_guard<std::mutex> guard(latch);
+  Binding binding = {pattern, &findPool(poolName)};
+  bindings.push_back(binding);
+}
+
+void BufPoolSet::setDefaultPool(const std::string& poolName)
+{
+  std::lock_guard<std::mutex> guard(latch);
+  defaultPool = &findPool(poolName);
+}
+
+BufMgr& BufPoolSet::poolFor(const std::string& filename)
+{
+  std::lock_guard<std::mutex> guard(latch);
+  for (std::size_t b = 0; b < bindings.size(); b++)
+  {
+    if (matches(bindings[b].pattern, filename))
+      return *bindings[b].pool;
+  }
+  if (defaultPool == NULL)
+    throw PoolNotFoundException(filename);
+  return *defaultPool;
+}
+
+BufMgr& BufPoolSet::poolFor(const File* file)
+{
+  return poolFor(file->filename());
+}
+
+std::vector<std::string> BufPoolSet::poolNames()
+{
+  std::lock_guard<std::mutex> guard(latch);
+  std::vector<std::string> names;
+  for (std::map<std::string, BufMgr*>::iterator it = pools.begin(); it != pools.end(); ++it)
+    names.push_back(it->first);
+  return names;
+}
+
+std::map<std::string, BufStatsSnapshot> BufPoolSet::getStatsSnapshots()
+{
+  // Pools are never removed, so they can be visited without holding the
+  // latch while their partitions are.
+  std::vector<std::pair<std::string, BufMgr*> > all;
+  {
+    std::lock_guard<std::mutex> guard(latch);
+    all.assign(pools.begin(), pools.end());
+  }
+  std::map<std::string, BufStatsSnapshot> snapshots;
+  for (std::size_t p = 0; p < all.size(); p++)
+    snapshots[all[p].first] = all[p].second->getStatsSnapshot();
+  return snapshots;
+}
+
+bool BufPoolSet::matches(const std::string& pattern, const std::string& name)
+{
+  // Greedy matching with backtracking to the last '*', linear in practice.
+  std::size_t p = 0, n = 0;
+  std::size_t star = std::string::npos, starName = 0;
+  while (n < name.size())
+  {
+    if (p < pattern.size() && (pattern[p] == '?' || pattern[p] == name[n]))
+    {
+      p++;
+      n++;
+    }
+    else if (p < pattern.size() && pattern[p] == '*')
+    {
+      star = p++;
+      starName = n;
+    }
+    else if (star != std::string::npos)
+    {
+      p = star + 1;
+      n = ++starName;
+    }
+    else
+    {
+      return false;
+    }
+  }
+  while (p < pattern.size() && pattern[p] == '*')
+    p++;
+  return p == pattern.size();
+}
+
+}
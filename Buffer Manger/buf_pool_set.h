@@ -0,0 +1,168 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
+ */
+
+#pragma once
+
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "buffer.h"
+
+namespace badgerdb {
+
+/**
+* @brief A set of independently sized, named buffer pools, with files assigned to pools by name.
+*
+* Each pool is a BufMgr of its own, with its own frames, partitions and replacement policy, so pages
+* of files bound to different pools never compete for frames. For example, index files can be bound
+* to a small "index" pool that keeps the upper levels of the trees resident, while relation scans churn
+* a separate "data" pool:
+*
+*   BufPoolSet pools;
+*   pools.createPool("data", 1000);
+*   pools.createPool("index", 200);
+*   pools.bindFile("*.idx", "index");
+*   BufMgr& mgr = pools.poolFor(&file);
+*
+* Files are matched against the bindings in the order they were made; the first match wins. Files that
+* match no binding go to the default pool, which is the first pool created unless setDefaultPool() says
+* otherwise. A page must always be accessed through the pool of its file, so callers look the pool up
+* once per file and keep the reference.
+*
+* All methods are threadsafe. Pools live until the BufPoolSet is destroyed.
+*/
+class BufPoolSet
+{
+ public:
+	/**
+   * Constructor of BufPoolSet class, with no pools
+	 */
+  BufPoolSet();
+
+	/**
+   * Destroys every pool, which writes back their dirty pages
+	 */
+  ~BufPoolSet();
+
+  BufPoolSet(const BufPoolSet&) = delete;
+  BufPoolSet& operator=(const BufPoolSet&) = delete;
+
+	/**
+	 * Creates a pool. The parameters after the name are those of the BufMgr constructor.
+	 *
+	 * @param name   	Name of the new pool
+	 * @param bufs   	Number of frames in the pool
+	 * @param parts  	Number of partitions of the pool
+	 * @param policy 	Replacement policy of the pool
+	 * @param hugePages	Whether to back the pool with transparent huge pages
+	 * @param maxBufs	Largest size BufMgr::resize() may grow the pool to
+	 * @return  			The new pool.
+	 * @throws PoolExistsException If a pool with that name exists
+	 */
+  BufMgr& createPool(const std::string& name, std::uint32_t bufs, std::uint32_t parts = 1,
+                     ReplacementPolicyType policy = CLOCK, bool hugePages = false, std::uint32_t maxBufs = 0);
+
+	/**
+	 * Returns the pool with the given name.
+	 *
+	 * @param name   	Name of the pool
+	 * @throws PoolNotFoundException If there is no such pool
+	 */
+  BufMgr& getPool(const std::string& name);
+
+	/**
+	 * Binds files to a pool. Takes effect for files looked up afterwards.
+	 *
+	 * @param pattern 	File name, or a pattern in which '*' matches any sequence of characters and '?' any one character
+	 * @param poolName 	Name of the pool
+	 * @throws PoolNotFoundException If there is no such pool
+	 */
+  void bindFile(const std::string& pattern, const std::string& poolName);
+
+	/**
+	 * Chooses the pool of files that match no binding.
+	 *
+	 * @param poolName 	Name of the pool
+	 * @throws PoolNotFoundException If there is no such pool
+	 */
+  void setDefaultPool(const std::string& poolName);
+
+	/**
+	 * Returns the pool a file is bound to.
+	 *
+	 * @param filename 	Name of the file
+	 * @throws PoolNotFoundException If the file matches no binding and there is no pool yet
+	 */
+  BufMgr& poolFor(const std::string& filename);
+
+	/**
+	 * Returns the pool a file is bound to.
+	 *
+	 * @param file   	File object
+	 * @throws PoolNotFoundException If the file matches no binding and there is no pool yet
+	 */
+  BufMgr& poolFor(const File* file);
+
+	/**
+	 * Names of all pools, in alphabetical order
+	 */
+  std::vector<std::string> poolNames();
+
+	/**
+	 * Statistics of every pool, by pool name. See BufMgr::getStatsSnapshot().
+	 */
+  std::map<std::string, BufStatsSnapshot> getStatsSnapshots();
+
+	/**
+	 * Matches a file name against a binding pattern.
+	 *
+	 * @param pattern 	Pattern in which '*' matches any sequence of characters and '?' any one character
+	 * @param name   	File name
+	 * @return  			True if the whole name matches.
+	 */
+  static bool matches(const std::string& pattern, const std::string& name);
+
+ private:
+	/**
+   * @brief Files matching a pattern and the pool they are bound to
+	 */
+  struct Binding
+  {
+    std::string pattern;
+    BufMgr* pool;
+  };
+
+	/**
+   * Protects every member
+	 */
+  std::mutex latch;
+
+	/**
+   * Pools by name, owned by this object
+	 */
+  std::map<std::string, BufMgr*> pools;
+
+	/**
+   * Bindings in the order they were made
+	 */
+  std::vector<Binding> bindings;
+
+	/**
+   * Pool of files that match no binding, NULL until the first pool is created
+	 */
+  BufMgr* defaultPool;
+
+	/**
+	 * Returns the pool with the given name. Caller must hold the latch.
+	 *
+	 * @throws PoolNotFoundException If there is no such pool
+	 */
+  BufMgr& findPool(const std::string& name);
+};
+
+}
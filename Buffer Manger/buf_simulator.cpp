@@ -0,0 +1,127 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
+ */
+
+#include "buf_simulator.h"
+
+namespace badgerdb {
+
+BufSimulator::BufSimulator(std::uint32_t bufs, ReplacementPolicyType policyType)
+  : numBufs(bufs), descTable(new BufDesc[bufs]), pages(bufs),
+    policy(ReplacementPolicy::create(policyType, 0, bufs)), failed(0)
+{
+  for (FrameId f = 0; f < bufs; f++)
+    descTable[f].frameNo = f;
+}
+
+BufSimulator::~BufSimulator()
+{
+  delete policy;
+  delete[] descTable;
+}
+
+void BufSimulator::replay(const BufTrace& trace)
+{
+  for (std::size_t r = 0; r < trace.records.size(); r++)
+    apply(trace.records[r]);
+  flush();
+}
+
+void BufSimulator::apply(const BufTraceRecord& record)
+{
+  if (record.file >= fileTags.size())
+    fileTags.resize(record.file + 1);
+  PageKey page = {reinterpret_cast<const File*>(&fileTags[record.file]), record.pageNo};
+  std::unordered_map<PageKey, FrameId, PageKeyHash>::iterator it = frames.find(page);
+  switch (record.op) {
+  case TRACE_READ:
+    stats.accesses++;
+    if (it != frames.end()) {
+      descTable[it->second].refbit = true;
+      descTable[it->second].pinCnt++;
+      policy->frameAccessed(it->second);
+      stats.hits++;
+    } else if (load(page)) {
+      stats.misses++;
+      stats.diskreads++;
+    }
+    break;
+  case TRACE_ALLOC:
+    stats.accesses++;
+    // A page number is only reused after the page was disposed, which took
+    // it out of the pool, so the page cannot be resident.
+    if (load(page))
+      stats.allocs++;
+    break;
+  case TRACE_UNPIN:
+  case TRACE_UNPIN_DIRTY:
+    // Pages whose pin failed are not resident, or are pinned by an
+    // earlier call the unpin does not belong to.
+    if (it != frames.end() && descTable[it->second].pinCnt != 0) {
+      descTable[it->second].pinCnt--;
+      if (record.op == TRACE_UNPIN_DIRTY)
+        descTable[it->second].dirty = true;
+    }
+    break;
+  case TRACE_DISPOSE:
+    if (it != frames.end() && descTable[it->second].pinCnt == 0) {
+      descTable[it->second].Clear();
+      policy->frameFreed(it->second);
+      frames.erase(it);
+    }
+    break;
+  case TRACE_FLUSH:
+    for (FrameId f = 0; f < numBufs; f++) {
+      if (descTable[f].valid && pages[f].file == page.file) {
+        if (descTable[f].dirty)
+          stats.diskwrites++;
+        frames.erase(pages[f]);
+        descTable[f].Clear();
+        policy->frameFreed(f);
+      }
+    }
+    break;
+  }
+}
+
+void BufSimulator::flush()
+{
+  for (FrameId f = 0; f < numBufs; f++) {
+    if (descTable[f].valid && descTable[f].dirty) {
+      stats.diskwrites++;
+      descTable[f].dirty = false;
+    }
+  }
+}
+
+bool BufSimulator::load(const PageKey& page)
+{
+  FrameId frame;
+  if (!policy->pickVictim(descTable, frame)) {
+    failed++;
+    return false;
+  }
+  BufDesc& desc = descTable[frame];
+  if (desc.valid) {
+    if (desc.dirty) {
+      stats.diskwrites++;
+      stats.stalledevictions++;
+    }
+    stats.evictions++;
+    frames.erase(pages[frame]);
+  }
+  // Only the bits are set; the descriptor's file stays NULL.
+  desc.Clear();
+  desc.pinCnt = 1;
+  desc.valid = true;
+  desc.refbit = true;
+  pages[frame] = page;
+  frames[page] = frame;
+  policy->frameLoaded(frame, page.file, page.pageNo);
+  return true;
+}
+
+}
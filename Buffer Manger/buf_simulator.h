@@ -0,0 +1,130 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <unordered_map>
+#include <vector>
+#include "buf_stats.h"
+#include "buf_trace.h"
+#include "buffer.h"
+#include "replacement_policy.h"
+
+namespace badgerdb {
+
+/**
+* @brief Replays a page reference trace against a simulated buffer pool of any size and policy.
+*
+* The simulated pool keeps no pages, only buffer descriptors and a replacement policy of the same classes
+* BufMgr uses, so a trace of a long run replays in seconds and always gives the same result. Pins,
+* dirty bits and evictions are tracked like in a single-partition BufMgr, and the statistics count the
+* disk reads and writes the pool would have made:
+*
+*   BufSimulator sim(500, ARC);
+*   sim.replay(BufTrace::load("run.trace"));
+*   double hitRatio = (double) sim.getStats().hits / (sim.getStats().hits + sim.getStats().misses);
+*
+* A read or alloc that finds every frame pinned would make BufMgr throw BufferExceededException; the
+* simulator skips it and counts it in failedPins().
+*/
+class BufSimulator
+{
+ public:
+	/**
+	 * Creates an empty simulated pool.
+	 *
+	 * @param bufs   	Number of frames
+	 * @param policy 	Replacement policy
+	 */
+  BufSimulator(std::uint32_t bufs, ReplacementPolicyType policy = CLOCK);
+
+	/**
+   * Destructor of BufSimulator class
+	 */
+  ~BufSimulator();
+
+  BufSimulator(const BufSimulator&) = delete;
+  BufSimulator& operator=(const BufSimulator&) = delete;
+
+	/**
+	 * Applies every record of a trace, then writes back the dirty pages as flushing the files would.
+	 */
+  void replay(const BufTrace& trace);
+
+	/**
+	 * Applies one record.
+	 */
+  void apply(const BufTraceRecord& record);
+
+	/**
+	 * Counts the dirty resident pages as written back and marks them clean.
+	 */
+  void flush();
+
+	/**
+   * Statistics of the simulated pool. Latencies are not simulated.
+	 */
+  const BufStats& getStats() const { return stats; }
+
+	/**
+   * Number of reads and allocs skipped because every frame was pinned
+	 */
+  std::uint64_t failedPins() const { return failed; }
+
+ private:
+	/**
+   * Number of frames
+	 */
+  std::uint32_t numBufs;
+
+	/**
+   * Descriptors of the simulated frames; only the pin count, dirty, valid and reference bits are used
+	 */
+  BufDesc* descTable;
+
+	/**
+   * Page held by each frame
+	 */
+  std::vector<PageKey> pages;
+
+	/**
+   * Frame of each resident page
+	 */
+  std::unordered_map<PageKey, FrameId, PageKeyHash> frames;
+
+	/**
+   * The replacement policy
+	 */
+  ReplacementPolicy* policy;
+
+	/**
+   * One byte per file of the trace. Policies identify pages by file pointer, so the addresses of these
+   * bytes stand in for the files; a deque keeps them in place as files are added.
+	 */
+  std::deque<char> fileTags;
+
+	/**
+   * Statistics of the simulated pool
+	 */
+  BufStats stats;
+
+	/**
+   * Number of reads and allocs skipped because every frame was pinned
+	 */
+  std::uint64_t failed;
+
+	/**
+	 * Pins a page that is not resident, evicting a page if needed.
+	 *
+	 * @return  False if every frame is pinned.
+	 */
+  bool load(const PageKey& page);
+};
+
+}
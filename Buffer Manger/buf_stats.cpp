@@ -0,0 +1,210 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
+ */
+
+#include <cstdio>
+#include <sstream>
+#include "buf_stats.h"
+
+namespace badgerdb {
+
+namespace {
+
+/**
+ * Counters of BufStats with their exported names, in output order.
+ */
+struct CounterInfo
+{
+  const char* name;
+  const char* help;
+  std::uint64_t BufStats::*field;
+};
+
+const CounterInfo COUNTERS[] = {
+  {"accesses", "Calls to readPage() and allocPage().", &BufStats::accesses},
+  {"hits", "readPage() calls that found the page resident.", &BufStats::hits},
+  {"misses", "readPage() calls that read the page from disk.", &BufStats::misses},
+  {"allocs", "allocPage() calls.", &BufStats::allocs},
+  {"diskreads", "Pages read from disk, including prefetched ones.", &BufStats::diskreads},
+  {"victimhits", "Misses served from the compressed victim cache.", &BufStats::victimhits},
+  {"diskwrites", "Pages written back to disk.", &BufStats::diskwrites},
+  {"bgwrites", "Pages written back by the background flusher.", &BufStats::bgwrites},
+  {"evictions", "Pages evicted to reuse their frame.", &BufStats::evictions},
+  {"stalledevictions", "Evictions that had to write a dirty page first.", &BufStats::stalledevictions},
+  {"rejections", "Misses the admission filter kept out of the main pool.", &BufStats::rejections},
+  {"pinwaits", "Page requests that waited for a partition latch.", &BufStats::pinwaits},
+};
+
+const std::size_t NUM_COUNTERS = sizeof(COUNTERS) / sizeof(COUNTERS[0]);
+
+// Escapes a string for use inside double quotes in JSON.
+std::string jsonEscape(const std::string& s)
+{
+  std::string out;
+  for (std::size_t i = 0; i < s.size(); i++) {
+    unsigned char c = (unsigned char) s[i];
+    if (c == '"' || c == '\\') {
+      out += '\\';
+      out += (char) c;
+    } else if (c < 0x20) {
+      char buf[8];
+      std::snprintf(buf, sizeof(buf), "\\u%04x", c);
+      out += buf;
+    } else {
+      out += (char) c;
+    }
+  }
+  return out;
+}
+
+// Escapes a string for use as a Prometheus label value.
+std::string labelEscape(const std::string& s)
+{
+  std::string out;
+  for (std::size_t i = 0; i < s.size(); i++) {
+    if (s[i] == '"' || s[i] == '\\') {
+      out += '\\';
+      out += s[i];
+    } else if (s[i] == '\n') {
+      out += "\\n";
+    } else {
+      out += s[i];
+    }
+  }
+  return out;
+}
+
+void histogramJson(std::ostringstream& out, const LatencyHistogram& h)
+{
+  out << "{\"count\":" << h.count << ",\"totalNs\":" << h.totalNs << ",\"buckets\":[";
+  for (int b = 0; b < LatencyHistogram::NUM_BUCKETS; b++)
+    out << (b > 0 ? "," : "") << h.buckets[b];
+  out << "]}";
+}
+
+void statsJson(std::ostringstream& out, const BufStats& stats)
+{
+  out << "{";
+  for (std::size_t c = 0; c < NUM_COUNTERS; c++)
+    out << "\"" << COUNTERS[c].name << "\":" << stats.*COUNTERS[c].field << ",";
+  out << "\"readLatency\":";
+  histogramJson(out, stats.readLatency);
+  out << ",\"writeLatency\":";
+  histogramJson(out, stats.writeLatency);
+  out << "}";
+}
+
+void histogramPrometheus(std::ostringstream& out, const std::string& name, const char* help,
+                         const LatencyHistogram& h)
+{
+  out << "# HELP " << name << " " << help << "\n";
+  out << "# TYPE " << name << " histogram\n";
+  std::uint64_t cumulative = 0;
+  for (int b = 0; b < LatencyHistogram::NUM_BUCKETS - 1; b++) {
+    cumulative += h.buckets[b];
+    out << name << "_bucket{le=\"" << LatencyHistogram::bucketLimitUs(b) / 1e6 << "\"} " << cumulative << "\n";
+  }
+  out << name << "_bucket{le=\"+Inf\"} " << h.count << "\n";
+  out << name << "_sum " << h.totalNs / 1e9 << "\n";
+  out << name << "_count " << h.count << "\n";
+}
+
+}
+
+void LatencyHistogram::record(std::uint64_t ns)
+{
+  std::uint64_t us = ns / 1000;
+  int bucket = 0;
+  while (us != 0 && bucket < NUM_BUCKETS - 1) {
+    us >>= 1;
+    bucket++;
+  }
+  buckets[bucket]++;
+  count++;
+  totalNs += ns;
+}
+
+void LatencyHistogram::add(const LatencyHistogram& other)
+{
+  for (int b = 0; b < NUM_BUCKETS; b++)
+    buckets[b] += other.buckets[b];
+  count += other.count;
+  totalNs += other.totalNs;
+}
+
+std::uint64_t LatencyHistogram::bucketLimitUs(int bucket)
+{
+  return bucket < NUM_BUCKETS - 1 ? (std::uint64_t) 1 << bucket : 0;
+}
+
+void LatencyHistogram::clear()
+{
+  for (int b = 0; b < NUM_BUCKETS; b++)
+    buckets[b] = 0;
+  count = totalNs = 0;
+}
+
+void BufStats::add(const BufStats& other)
+{
+  for (std::size_t c = 0; c < NUM_COUNTERS; c++)
+    this->*COUNTERS[c].field += other.*COUNTERS[c].field;
+  readLatency.add(other.readLatency);
+  writeLatency.add(other.writeLatency);
+}
+
+std::string BufStatsSnapshot::toJson() const
+{
+  std::ostringstream out;
+  out << "{\"numBufs\":" << numBufs << ",\"numPartitions\":" << numPartitions << ",\"total\":";
+  statsJson(out, total);
+  out << ",\"files\":{";
+  for (std::map<std::string, BufStats>::const_iterator it = files.begin(); it != files.end(); ++it) {
+    out << (it != files.begin() ? "," : "") << "\"" << jsonEscape(it->first) << "\":";
+    statsJson(out, it->second);
+  }
+  out << "},\"hitRatioCurve\":[";
+  for (std::size_t e = 0; e < hitRatioCurve.size(); e++) {
+    out << (e != 0 ? "," : "") << "{\"numBufs\":" << hitRatioCurve[e].numBufs
+        << ",\"hitRatio\":" << hitRatioCurve[e].hitRatio << "}";
+  }
+  out << "]}";
+  return out.str();
+}
+
+std::string BufStatsSnapshot::toPrometheus(const std::string& prefix) const
+{
+  std::ostringstream out;
+  out << "# HELP " << prefix << "_frames Number of frames in the buffer pool.\n";
+  out << "# TYPE " << prefix << "_frames gauge\n";
+  out << prefix << "_frames " << numBufs << "\n";
+  out << "# HELP " << prefix << "_partitions Number of partitions of the buffer pool.\n";
+  out << "# TYPE " << prefix << "_partitions gauge\n";
+  out << prefix << "_partitions " << numPartitions << "\n";
+  for (std::size_t c = 0; c < NUM_COUNTERS; c++) {
+    std::string name = prefix + "_" + COUNTERS[c].name + "_total";
+    out << "# HELP " << name << " " << COUNTERS[c].help << "\n";
+    out << "# TYPE " << name << " counter\n";
+    out << name << " " << total.*COUNTERS[c].field << "\n";
+  }
+  histogramPrometheus(out, prefix + "_read_latency_seconds", "Latency of page reads.", total.readLatency);
+  histogramPrometheus(out, prefix + "_write_latency_seconds", "Latency of write operations.", total.writeLatency);
+  if (!hitRatioCurve.empty()) {
+    out << "# HELP " << prefix << "_estimated_hit_ratio Estimated hit ratio of page reads at other pool sizes.\n";
+    out << "# TYPE " << prefix << "_estimated_hit_ratio gauge\n";
+    for (std::size_t e = 0; e < hitRatioCurve.size(); e++)
+      out << prefix << "_estimated_hit_ratio{frames=\"" << hitRatioCurve[e].numBufs << "\"} " << hitRatioCurve[e].hitRatio << "\n";
+  }
+  for (std::size_t c = 0; c < NUM_COUNTERS; c++) {
+    std::string name = prefix + "_file_" + COUNTERS[c].name + "_total";
+    out << "# HELP " << name << " " << COUNTERS[c].help << " By file.\n";
+    out << "# TYPE " << name << " counter\n";
+    for (std::map<std::string, BufStats>::const_iterator it = files.begin(); it != files.end(); ++it)
+      out << name << "{file=\"" << labelEscape(it->first) << "\"} " << it->second.*COUNTERS[c].field << "\n";
+  }
+  return out.str();
+}
+
+}
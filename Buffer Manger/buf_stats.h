@@ -0,0 +1,244 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace badgerdb {
+
+/**
+* @brief Histogram of I/O latencies with power-of-two microsecond buckets
+*/
+struct LatencyHistogram
+{
+	/**
+   * Number of buckets. Bucket 0 counts latencies below 1 us, bucket b > 0 those in [2^(b-1), 2^b) us,
+   * and the last bucket everything from 2^(NUM_BUCKETS-2) us up.
+	 */
+  static const int NUM_BUCKETS = 22;
+
+	/**
+   * Number of samples in each bucket
+	 */
+  std::uint64_t buckets[NUM_BUCKETS];
+
+	/**
+   * Number of samples
+	 */
+  std::uint64_t count;
+
+	/**
+   * Sum of all samples in nanoseconds
+	 */
+  std::uint64_t totalNs;
+
+	/**
+   * Adds one sample.
+	 *
+	 * @param ns 	Latency in nanoseconds
+	 */
+  void record(std::uint64_t ns);
+
+	/**
+   * Adds all samples of another histogram.
+	 */
+  void add(const LatencyHistogram& other);
+
+	/**
+   * Upper bound of a bucket in microseconds; the last bucket has none and returns 0.
+	 */
+  static std::uint64_t bucketLimitUs(int bucket);
+
+	/**
+   * Clear all values
+	 */
+  void clear();
+
+	/**
+   * Constructor of LatencyHistogram class
+	 */
+  LatencyHistogram()
+  {
+		clear();
+  }
+};
+
+
+/**
+* @brief Class to maintain statistics of buffer usage
+*
+* Used both for the whole pool and for the pages of a single file. Each partition keeps its own counters
+* and updates them under its latch, so counting adds no synchronization to the hot path.
+*/
+struct BufStats
+{
+	/**
+   * Total number of accesses to buffer pool, one per readPage() and allocPage() call
+	 */
+  std::uint64_t accesses;
+
+	/**
+   * Number of readPage() calls that found the page resident
+	 */
+  std::uint64_t hits;
+
+	/**
+   * Number of readPage() calls that had to read the page from disk
+	 */
+  std::uint64_t misses;
+
+	/**
+   * Number of allocPage() calls
+	 */
+  std::uint64_t allocs;
+
+	/**
+   * Number of pages read from disk, including those loaded by prefetch()
+	 */
+  std::uint64_t diskreads;
+
+	/**
+   * Number of readPage() misses served from the compressed victim cache instead of the disk (included in misses)
+	 */
+  std::uint64_t victimhits;
+
+	/**
+   * Number of pages written back to disk
+	 */
+  std::uint64_t diskwrites;
+
+	/**
+   * Number of pages written back to disk by the background flusher (included in diskwrites)
+	 */
+  std::uint64_t bgwrites;
+
+	/**
+   * Number of pages evicted so that their frame could be reused
+	 */
+  std::uint64_t evictions;
+
+	/**
+   * Number of evictions that had to write a dirty victim before the frame could be reused
+	 */
+  std::uint64_t stalledevictions;
+
+	/**
+   * Number of readPage() misses whose page the admission filter rated below the victim, so that the page
+   * took a probationary frame and the victim stayed (see BufMgr::setAdmissionFilter())
+	 */
+  std::uint64_t rejections;
+
+	/**
+   * Number of readPage() and allocPage() calls that had to wait for the partition latch, for example
+   * behind another thread's disk read
+	 */
+  std::uint64_t pinwaits;
+
+	/**
+   * Latency of disk reads, one sample per read operation; a run read by BufMgr::readPages() counts once
+	 */
+  LatencyHistogram readLatency;
+
+	/**
+   * Latency of disk writes, one sample per write operation; a batched write-back counts once
+	 */
+  LatencyHistogram writeLatency;
+
+	/**
+   * Adds all counters of another BufStats.
+	 */
+  void add(const BufStats& other);
+
+	/**
+   * Clear all values
+	 */
+  void clear()
+  {
+		accesses = hits = misses = allocs = diskreads = victimhits = diskwrites = bgwrites = 0;
+		evictions = stalledevictions = rejections = pinwaits = 0;
+		readLatency.clear();
+		writeLatency.clear();
+  }
+
+	/**
+   * Constructor of BufStats class
+	 */
+  BufStats()
+  {
+		clear();
+  }
+};
+
+
+/**
+* @brief Estimated hit ratio of readPage() at one pool size, see BufStatsSnapshot::hitRatioCurve
+*/
+struct BufHitRatioEstimate
+{
+	/**
+   * Number of frames of the pool
+	 */
+  std::uint32_t numBufs;
+
+	/**
+   * Fraction of reads that would have found their page resident
+	 */
+  double hitRatio;
+};
+
+
+/**
+* @brief Consistent copy of the buffer pool statistics, returned by BufMgr::getStatsSnapshot()
+*/
+struct BufStatsSnapshot
+{
+	/**
+   * Number of frames in the buffer pool
+	 */
+  std::uint32_t numBufs;
+
+	/**
+   * Number of partitions of the buffer pool
+	 */
+  std::uint32_t numPartitions;
+
+	/**
+   * Statistics of the whole pool
+	 */
+  BufStats total;
+
+	/**
+   * Statistics of every file that has been accessed through the pool, by file name. A file whose pages have
+   * all left the pool is forgotten on clearBufStats(), or earlier once more than a few such files pile up.
+	 */
+  std::map<std::string, BufStats> files;
+
+	/**
+   * Estimated hit ratio of readPage() at half, the same, twice and four times the size of the pool, over
+   * the reads since the statistics were last cleared (see MrcEstimator). Empty before the first read.
+	 */
+  std::vector<BufHitRatioEstimate> hitRatioCurve;
+
+	/**
+   * Renders the snapshot as a JSON object.
+	 */
+  std::string toJson() const;
+
+	/**
+   * Renders the snapshot in the Prometheus text exposition format. Pool-wide counters and latency
+   * histograms are exported as is, per-file counters with a file label.
+	 *
+	 * @param prefix 	Prefix of every metric name
+	 */
+  std::string toPrometheus(const std::string& prefix = "badgerdb_buffer") const;
+};
+
+}
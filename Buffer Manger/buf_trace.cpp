@@ -0,0 +1,117 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
+ */
+
+#include <cstring>
+#include "buf_trace.h"
+#include "exceptions/bad_trace_exception.h"
+#include "exceptions/file_not_found_exception.h"
+
+namespace badgerdb {
+
+namespace {
+
+const char MAGIC[4] = {'B', 'T', 'R', '1'};
+
+const std::uint32_t FILE_MASK = 0xFFFFFF;
+const int OP_SHIFT = 24;
+
+void writeInt(std::ofstream& out, std::uint32_t value)
+{
+  out.write(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+bool readInt(std::ifstream& in, std::uint32_t& value)
+{
+  return (bool) in.read(reinterpret_cast<char*>(&value), sizeof(value));
+}
+
+}
+
+const std::uint32_t BufTraceWriter::MAX_FILES;
+
+BufTrace BufTrace::load(const std::string& path)
+{
+  std::ifstream in(path.c_str(), std::ios::binary);
+  if (!in)
+    throw FileNotFoundException(path);
+  BufTrace trace;
+  trace.numFiles = 0;
+  char magic[sizeof(MAGIC)];
+  if (!in.read(magic, sizeof(magic)) || std::memcmp(magic, MAGIC, sizeof(MAGIC)) != 0)
+    throw BadTraceException(path);
+  std::uint64_t time = 0;
+  std::uint32_t delta;
+  while (readInt(in, delta)) {
+    std::uint32_t pageNo, fileOp;
+    if (!readInt(in, pageNo) || !readInt(in, fileOp) || (fileOp >> OP_SHIFT) > TRACE_FLUSH)
+      throw BadTraceException(path);
+    time += delta;
+    BufTraceRecord record = {time, fileOp & FILE_MASK, pageNo, (BufTraceOp) (fileOp >> OP_SHIFT)};
+    // Files are numbered in order of appearance, so a gap means corruption.
+    if (record.file > trace.numFiles)
+      throw BadTraceException(path);
+    if (record.file == trace.numFiles)
+      trace.numFiles++;
+    trace.records.push_back(record);
+  }
+  // A partial record at the end is left by a crash while tracing.
+  if (in.gcount() != 0)
+    throw BadTraceException(path);
+  return trace;
+}
+
+BufTraceWriter::BufTraceWriter(const std::string& path)
+  : out(path.c_str(), std::ios::binary | std::ios::trunc),
+    last(std::chrono::steady_clock::now()), records(0)
+{
+  out.write(MAGIC, sizeof(MAGIC));
+  if (!out)
+    throw BadTraceException(path);
+}
+
+BufTraceWriter::~BufTraceWriter()
+{
+  out.flush();
+}
+
+void BufTraceWriter::record(BufTraceOp op, const File* file, PageId pageNo)
+{
+  std::unordered_map<const File*, std::uint32_t>::iterator it = fileIds.find(file);
+  std::uint32_t id;
+  if (it != fileIds.end()) {
+    id = it->second;
+  } else {
+    std::unordered_map<std::string, std::uint32_t>::iterator name = nameIds.find(file->filename());
+    if (name != nameIds.end()) {
+      id = name->second;
+    } else {
+      if (nameIds.size() == MAX_FILES)
+        return;
+      id = (std::uint32_t) nameIds.size();
+      nameIds[file->filename()] = id;
+    }
+    fileIds[file] = id;
+  }
+  std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+  std::uint64_t delta = std::chrono::duration_cast<std::chrono::microseconds>(now - last).count();
+  if (delta > 0xFFFFFFFF)
+    delta = 0xFFFFFFFF;
+  // Only whole microseconds are written, so the rest carries over to the
+  // next record and the times do not drift.
+  last += std::chrono::microseconds(delta);
+  writeInt(out, (std::uint32_t) delta);
+  writeInt(out, pageNo);
+  writeInt(out, id | (std::uint32_t) op << OP_SHIFT);
+  records++;
+}
+
+void BufTraceWriter::forgetFile(const File* file)
+{
+  fileIds.erase(file);
+}
+
+}
@@ -0,0 +1,163 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
+ */
+
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "file.h"
+#include "types.h"
+
+namespace badgerdb {
+
+/**
+ * @brief Buffer pool calls recorded in a page reference trace.
+ */
+enum BufTraceOp
+{
+	TRACE_READ = 0,		/* readPage() */
+	TRACE_ALLOC = 1,	/* allocPage() */
+	TRACE_UNPIN = 2,	/* unPinPage() of a clean page, or a PageHandle released without writes */
+	TRACE_UNPIN_DIRTY = 3,	/* unPinPage() of a dirty page, or a PageHandle released after a write */
+	TRACE_DISPOSE = 4,	/* disposePage() */
+	TRACE_FLUSH = 5		/* flushFile(), with page number 0 */
+};
+
+/**
+ * @brief One buffer pool call of a page reference trace.
+ */
+struct BufTraceRecord
+{
+	/**
+   * Microseconds since the trace was started
+	 */
+  std::uint64_t time;
+
+	/**
+   * Number of the file, assigned in the order files were first referenced
+	 */
+  std::uint32_t file;
+
+	/**
+   * Page number within the file
+	 */
+  PageId pageNo;
+
+	/**
+   * The call
+	 */
+  BufTraceOp op;
+};
+
+/**
+* @brief A page reference trace read back from disk. See BufMgr::startTrace().
+*
+* On disk a trace is the magic "BTR1" followed by one 12 byte record per call: the microseconds since
+* the previous record, the page number, and the file number in the low 24 bits of a third integer whose
+* high 8 bits hold the call. Integers are 32 bits in the byte order of the machine. Files are numbered
+* by name, so a file closed and opened again keeps its number, and two runs of the same workload give
+* the same trace apart from the times.
+*/
+struct BufTrace
+{
+	/**
+   * Number of distinct files referenced
+	 */
+  std::uint32_t numFiles;
+
+	/**
+   * The calls, in the order they were made
+	 */
+  std::vector<BufTraceRecord> records;
+
+	/**
+	 * Reads a trace written by BufTraceWriter.
+	 *
+	 * @param path   	Name of the trace file
+	 * @throws FileNotFoundException If there is no such file
+	 * @throws BadTraceException If the file is not a valid trace
+	 */
+  static BufTrace load(const std::string& path);
+};
+
+/**
+* @brief Appends the calls made to a buffer pool to a trace file.
+*
+* @warning This class is not threadsafe; BufMgr serializes calls to it.
+*/
+class BufTraceWriter
+{
+ public:
+	/**
+	 * Starts a trace, replacing the file if it exists.
+	 *
+	 * @param path   	Name of the trace file
+	 * @throws BadTraceException If the file cannot be created
+	 */
+  explicit BufTraceWriter(const std::string& path);
+
+	/**
+   * Writes out the buffered records and closes the file
+	 */
+  ~BufTraceWriter();
+
+  BufTraceWriter(const BufTraceWriter&) = delete;
+  BufTraceWriter& operator=(const BufTraceWriter&) = delete;
+
+	/**
+	 * Appends a record.
+	 *
+	 * @param op     	The call
+	 * @param file   	File the page belongs to
+	 * @param pageNo 	Page number within the file
+	 */
+  void record(BufTraceOp op, const File* file, PageId pageNo);
+
+	/**
+	 * Forgets the number of a File object, which may be closed and its address reused. The file keeps its
+	 * number should it be referenced again.
+	 */
+  void forgetFile(const File* file);
+
+	/**
+   * Number of records written
+	 */
+  std::uint64_t numRecords() const { return records; }
+
+ private:
+	/**
+   * Largest file number that fits into a record
+	 */
+  static const std::uint32_t MAX_FILES = 1 << 24;
+
+	/**
+   * The trace file
+	 */
+  std::ofstream out;
+
+	/**
+   * Time of the previous record
+	 */
+  std::chrono::steady_clock::time_point last;
+
+	/**
+   * Numbers of the File objects seen, and of the names of all files seen
+	 */
+  std::unordered_map<const File*, std::uint32_t> fileIds;
+  std::unordered_map<std::string, std::uint32_t> nameIds;
+
+	/**
+   * Number of records written
+	 */
+  std::uint64_t records;
+};
+
+}
@@ -17,229 +17,1792 @@
 
 #include <memory>
 #include <iostream>
+#include <vector>
+#include <unordered_set>
+#include <chrono>
+#include <cmath>
+#include <algorithm>
+#include <functional>
+#include <new>
+#include <sys/mman.h>
 #include "buffer.h"
+#include "buf_manifest.h"
 #include "exceptions/buffer_exceeded_exception.h"
 #include "exceptions/page_not_pinned_exception.h"
 #include "exceptions/page_pinned_exception.h"
 #include "exceptions/bad_buffer_exception.h"
-#include "exceptions/hash_not_found_exception.h"
+#include "exceptions/badgerdb_exception.h"
 
-namespace badgerdb { 
+namespace badgerdb {
 
-    BufMgr::BufMgr(std::uint32_t bufs)
-	: numBufs(bufs) {
-	    bufDescTable = new BufDesc[bufs];
+    namespace {
 
-	    for (FrameId i = 0; i < bufs; i++) 
+    // Nanoseconds since the given time, for the latency histograms.
+    std::uint64_t elapsedNs(std::chrono::steady_clock::time_point start) {
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    }
+
+    const FrameId BufDesc::NO_FRAME;
+    const FrameId OptimisticRead::NO_FRAME;
+
+    BufMgr::BufMgr(std::uint32_t bufs, std::uint32_t parts, ReplacementPolicyType policy, bool hugePages, std::uint32_t maxBufs)
+	: numBufs(bufs), maxBufs(maxBufs > bufs ? maxBufs : bufs), flusherRunning(false), numListeners(0),
+	  tracer(NULL), tracing(false), prefetchRunning(false) {
+	    bufDescTable = new BufDesc[this->maxBufs];
+
+	    for (FrameId i = 0; i < this->maxBufs; i++)
 	    {
 		bufDescTable[i].frameNo = i;
 		bufDescTable[i].valid = false;
 	    }
 
-	    bufPool = new Page[bufs];
+	    // Back the whole pool with a single page-aligned arena, so frames are
+	    // fixed offsets into one allocation instead of scattered objects. The
+	    // arena is sized for maxBufs up front but only reserves address space;
+	    // memory is committed for the frames actually in use, so resize() never
+	    // has to move a frame.
+	    std::size_t alignment = hugePages ? HUGE_PAGE_SIZE : ARENA_ALIGNMENT;
+	    arenaBytes = ((std::size_t) this->maxBufs * sizeof(Page) + alignment - 1) / alignment * alignment + alignment;
+	    arena = mmap(NULL, arenaBytes, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+	    if (arena == MAP_FAILED) {
+		delete[] bufDescTable;
+		throw std::bad_alloc();
+	    }
+	    std::uintptr_t start = ((std::uintptr_t) arena + alignment - 1) / alignment * alignment;
+	    bufPool = reinterpret_cast<Page*>(start);
+#ifdef MADV_HUGEPAGE
+	    if (hugePages) {
+		// Only a hint; the pool works the same if the kernel declines.
+		madvise(bufPool, arenaBytes - alignment, MADV_HUGEPAGE);
+	    }
+#endif
+
+	    // Every partition needs at least one frame.
+	    if (parts == 0) {
+		parts = 1;
+	    }
+	    if (parts > bufs) {
+		parts = bufs;
+	    }
+	    numPartitions = parts;
+	    partitions = new BufPartition[parts];
+
+	    // Hand out the frames in contiguous ranges; the first (bufs % parts)
+	    // partitions get one extra frame. Each range is followed by the frames
+	    // reserved for the partition to grow into.
+	    FrameId first = 0;
+	    for (std::uint32_t p = 0; p < parts; p++) {
+		BufPartition& part = partitions[p];
+		part.firstFrame = first;
+		part.numFrames = bufs / parts + (p < bufs % parts ? 1 : 0);
+		part.maxFrames = this->maxBufs / parts + (p < this->maxBufs % parts ? 1 : 0);
+		first += part.maxFrames;
+
+		commitFrames(part.firstFrame, part.numFrames);
 
-	    int htsize = ((((int) (bufs * 1.2))*2)/2)+1;
-	    hashTable = new BufHashTbl (htsize);  // allocate the buffer hash table
+		part.hashTable = new BufHashTbl (part.numFrames);  // allocate the buffer hash table, one entry per frame at most
 
-	    clockHand = bufs - 1;
+		part.policy = ReplacementPolicy::create(policy, part.firstFrame, part.numFrames);
+		part.victimCache = NULL;
+		part.mrc = new MrcEstimator(part.numFrames);
+		part.admission = NULL;
+		part.nextProbation = 0;
+	    }
 	}
 
 
     BufMgr::~BufMgr() {
-	for (std::uint32_t i = 0; i < numBufs; i++) {
+	stopFlusher();
+	stopTrace();
+	{
+	    std::lock_guard<std::mutex> guard(prefetchLatch);
+	    prefetchRunning = false;
+	    prefetchQueue.clear();
+	}
+	prefetchReady.notify_all();
+	for (std::size_t w = 0; w < prefetchWorkers.size(); w++) {
+	    prefetchWorkers[w].join();
+	}
+	// Frames beyond numFrames of a partition never hold a page.
+	for (std::uint32_t i = 0; i < maxBufs; i++) {
 	    if (bufDescTable[i].pinCnt != 0) {
 		// If the page is pinned, throw an PagePinnedException.
 		throw PagePinnedException(bufDescTable[i].file->filename(), bufDescTable[i].pageNo, i);
 	    }
 	}
-	for (std::uint32_t i = 0; i < numBufs; i++) {
-	    if (bufDescTable[i].dirty != 0) {
-		// Write to disk if the page is dirty.
-		bufDescTable[i].file->writePage(bufPool[i]);
+	// Write the dirty pages to disk in one batch.
+	std::vector<FrameId> dirty;
+	for (std::uint32_t i = 0; i < maxBufs; i++) {
+	    if (bufDescTable[i].dirty) {
+		dirty.push_back(i);
 	    }
 	}
+	writeFrames(dirty);
+	for (std::uint32_t p = 0; p < numPartitions; p++) {
+	    delete partitions[p].hashTable;
+	    delete partitions[p].policy;
+	    delete partitions[p].victimCache;
+	    delete partitions[p].mrc;
+	    delete partitions[p].admission;
+	}
+	delete[] partitions;
 	delete[] bufDescTable;
-	delete hashTable;
-	delete[] bufPool;
+	// Page has no resources of its own, so the arena can be released as is.
+	munmap(arena, arenaBytes);
     }
 
-    void BufMgr::advanceClock() {
-	// Increment the clockHand. If the value of clockHand is larger or
-	// equal to the numBufs, the clockHand is reset to zero.
-	if (++clockHand >= numBufs) {
-	    clockHand = 0;
+    void BufMgr::commitFrames(FrameId first, std::uint32_t count) {
+	if (mprotect(&bufPool[first], (std::size_t) count * sizeof(Page), PROT_READ | PROT_WRITE) != 0) {
+	    throw std::bad_alloc();
 	}
+	// The frames are left as the zero pages the kernel maps in. Every frame
+	// is overwritten as a whole when a page is loaded into it, so constructing
+	// Page objects here would only fault in memory of frames never used.
     }
 
-    void BufMgr::allocBuf(FrameId & frame) {
-	// The number of pinned pages.
-	std::uint32_t num = 0;
-	// Keep looping if the number of pinned pages is less than the number
-	// of frames.
-	while (num < numBufs) {
-	    advanceClock();
-	    // If the page in this frame is not valid, assign its frame number
-	    // to frame.
-	    if (!bufDescTable[clockHand].valid) { 
-		frame = bufDescTable[clockHand].frameNo;
-		return;
+    void BufMgr::releaseFrames(FrameId first, std::uint32_t count) {
+	// The frames stay mapped: an optimistic reader that looked at one of
+	// them just before it was given up may still read it, and has to see
+	// zero pages and fail validation rather than fault.
+	madvise(&bufPool[first], (std::size_t) count * sizeof(Page), MADV_DONTNEED);
+    }
+
+    std::uint32_t BufMgr::resize(std::uint32_t bufs) {
+	std::lock_guard<std::mutex> guard(resizeLatch);
+	if (bufs < numPartitions) {
+	    bufs = numPartitions;
+	}
+	if (bufs > maxBufs) {
+	    bufs = maxBufs;
+	}
+	// Same split as in the constructor, so every target fits the frames
+	// reserved for its partition.
+	std::uint32_t total = 0;
+	for (std::uint32_t p = 0; p < numPartitions; p++) {
+	    std::uint32_t target = bufs / numPartitions + (p < bufs % numPartitions ? 1 : 0);
+	    total += resizePartition(partitions[p], target);
+	}
+	numBufs = total;
+	return total;
+    }
+
+    std::uint32_t BufMgr::resizePartition(BufPartition& part, std::uint32_t target) {
+	std::lock_guard<std::mutex> guard(part.latch);
+	if (target > part.numFrames) {
+	    commitFrames(part.firstFrame + part.numFrames, target - part.numFrames);
+	    part.policy->resize(target);
+	    part.hashTable->resize(target);
+	    part.mrc->resize(target);
+	    if (part.admission != NULL) {
+		part.admission->resize(target);
 	    }
-	    if (bufDescTable[clockHand].refbit) {
-		bufDescTable[clockHand].refbit = false;
-		continue;
+	    part.probation.clear();
+	    part.nextProbation = 0;
+	    part.numFrames = target;
+	    return part.numFrames;
+	}
+	// Give up frames from the end of the range, moving their pages into free
+	// frames below the target, or evicting them once there are none.
+	FrameId end = part.firstFrame + part.numFrames;
+	while (end > part.firstFrame + target) {
+	    BufDesc& desc = bufDescTable[end - 1];
+	    if (desc.pinCnt != 0) {
+		break;
 	    }
-	    if (bufDescTable[clockHand].pinCnt != 0) {
-		// Increment the number of pinned pages.
-		num++;
-		continue;
+	    FrameId lower;
+	    if (desc.valid && part.policy->takeFreeFrame(part.firstFrame + target, lower)) {
+		// Keep the page in the pool by moving it into a free frame that
+		// stays. The frame gets a new version, so optimistic readers of
+		// the old one fail and look the page up again.
+		File* file = desc.file;
+		PageId pageNo = desc.pageNo;
+		bool dirty = desc.dirty;
+		bufPool[lower] = bufPool[end - 1];
+		part.hashTable->remove(file, pageNo);
+		unlinkFrame(part, end - 1);
+		desc.Clear();
+		part.policy->frameFreed(end - 1);
+		bufDescTable[lower].Set(file, pageNo);
+		bufDescTable[lower].pinCnt = 0;
+		bufDescTable[lower].dirty = dirty;
+		part.hashTable->insert(file, pageNo, lower);
+		linkFrame(part, lower);
+		part.policy->frameLoaded(lower, file, pageNo);
+	    } else if (desc.valid) {
+		if (desc.dirty) {
+		    writeFrame(part, end - 1);
+		}
+		part.bufStats.evictions++;
+		desc.fileStats->evictions++;
+		part.hashTable->remove(desc.file, desc.pageNo);
+		unlinkFrame(part, end - 1);
+		desc.Clear();
+		part.policy->frameFreed(end - 1);
+	    }
+	    end--;
+	}
+	std::uint32_t released = part.firstFrame + part.numFrames - end;
+	if (released > 0) {
+	    part.numFrames -= released;
+	    part.policy->resize(part.numFrames);
+	    part.hashTable->resize(part.numFrames);
+	    part.mrc->resize(part.numFrames);
+	    if (part.admission != NULL) {
+		part.admission->resize(part.numFrames);
+	    }
+	    part.probation.clear();
+	    part.nextProbation = 0;
+	    releaseFrames(end, released);
+	}
+	return part.numFrames;
+    }
+
+    BufPartition& BufMgr::partitionOf(const File* file, const PageId pageNo) {
+	// The hash table picks buckets with the low bits of the same hash, so
+	// use the high bits here to keep the two choices independent.
+	return partitions[(BufHashTbl::hash(file, pageNo) >> 32) % numPartitions];
+    }
+
+    BufPartition& BufMgr::partitionOfFrame(const FrameId frame) {
+	// The constructor gave the first (maxBufs % numPartitions) partitions
+	// one frame more than the others.
+	std::uint32_t size = maxBufs / numPartitions;
+	std::uint32_t larger = maxBufs % numPartitions;
+	FrameId boundary = larger * (size + 1);
+	if (frame < boundary) {
+	    return partitions[frame / (size + 1)];
+	}
+	return partitions[larger + (frame - boundary) / size];
+    }
+
+    std::mutex& BufMgr::ioLatchOf(const File* file) {
+	return ioLatches[std::hash<std::string>()(file->filename()) % IO_LATCHES];
+    }
+
+    void BufMgr::allocBuf(BufPartition& part, FrameId & frame, File* file, const PageId pageNo, EvictedPage* evicted) {
+	// Let the replacement policy pick a free frame or an unpinned victim.
+	if (!part.policy->pickVictim(bufDescTable, frame)) {
+	    // All the pages are pinned.
+	    throw BufferExceededException();
+	}
+	if (file != NULL && part.admission != NULL && bufDescTable[frame].valid &&
+	    !part.admission->admit(file, pageNo, bufDescTable[frame].file, bufDescTable[frame].pageNo)) {
+	    // The victim has been read more often than the new page. Load the
+	    // page into the next probationary frame and leave the victim be,
+	    // unless the probationary area is still filling up.
+	    std::uint32_t next = part.nextProbation;
+	    if (next < part.probation.size() && part.probation[next].first != frame &&
+		reclaimFrame(part, part.probation[next].first, part.probation[next].second)) {
+		part.policy->frameKept(frame);
+		frame = part.probation[next].first;
+		part.bufStats.rejections++;
+		part.statsByFile[file->filename()].rejections++;
+	    }
+	    PageKey page = {file, pageNo};
+	    if (next < part.probation.size()) {
+		part.probation[next] = std::make_pair(frame, page);
 	    } else {
-		// Flush the page to disk.
-		if (bufDescTable[clockHand].dirty) {
-		    bufDescTable[clockHand].file->writePage(bufPool[clockHand]);
-                    bufStats.diskwrites++;
-                    bufStats.accesses++;
-		}
-		frame = bufDescTable[clockHand].frameNo;
-		// Remove the entry of corresponding page from the hash table.   
-		hashTable->remove(bufDescTable[clockHand].file, bufDescTable[clockHand].pageNo);
-		bufDescTable[clockHand].Clear();
+		part.probation.push_back(std::make_pair(frame, page));
+	    }
+	    std::uint32_t size = part.numFrames / PROBATION_SHARE;
+	    part.nextProbation = (next + 1) % (size > 0 ? size : 1);
+	}
+	BufDesc& desc = bufDescTable[frame];
+	if (desc.valid) {
+	    // Flush the page to disk. The caller has to wait for the write, so
+	    // nudge the background flusher to get ahead of the replacement policy.
+	    if (desc.dirty && evicted != NULL) {
+		// Leave the write to the caller, from a copy of the page. Until
+		// it is done, loads of the page wait for it.
+		evicted->file = desc.file;
+		evicted->page.reset(new Page(bufPool[frame]));
+		PageKey key = {desc.file, desc.pageNo};
+		part.pendingWrites.insert(key);
+		desc.dirty = false;
+		part.bufStats.stalledevictions++;
+		desc.fileStats->stalledevictions++;
+		flusherWakeup.notify_one();
+	    } else if (desc.dirty) {
+		writeFrame(part, frame);
+		part.bufStats.stalledevictions++;
+		desc.fileStats->stalledevictions++;
+		flusherWakeup.notify_one();
+	    }
+	    part.bufStats.evictions++;
+	    desc.fileStats->evictions++;
+	    // The page is clean now; keep a compressed copy if the tier is on.
+	    if (part.victimCache != NULL) {
+		part.victimCache->insert(desc.file, desc.pageNo, bufPool[frame]);
+	    }
+	    // Remove the entry of corresponding page from the hash table.
+	    part.hashTable->remove(desc.file, desc.pageNo);
+	    unlinkFrame(part, frame);
+	    desc.Clear();
+	}
+    }
+
+    void BufMgr::writeFrame(BufPartition& part, FrameId frame) {
+	BufDesc& desc = bufDescTable[frame];
+	std::chrono::steady_clock::time_point start;
+	{
+	    std::lock_guard<std::mutex> io(ioLatchOf(desc.file));
+	    start = std::chrono::steady_clock::now();
+	    desc.file->writePage(bufPool[frame]);
+	}
+	std::uint64_t ns = elapsedNs(start);
+	desc.dirty = false;
+	part.bufStats.diskwrites++;
+	part.bufStats.writeLatency.record(ns);
+	desc.fileStats->diskwrites++;
+	desc.fileStats->writeLatency.record(ns);
+    }
+
+    void BufMgr::writeFrames(std::vector<FrameId>& frames) {
+	if (frames.empty()) {
+	    return;
+	}
+	std::sort(frames.begin(), frames.end(), [this](FrameId a, FrameId b) {
+	    const BufDesc& da = bufDescTable[a];
+	    const BufDesc& db = bufDescTable[b];
+	    return da.file != db.file ? std::less<File*>()(da.file, db.file) : da.pageNo < db.pageNo;
+	});
+	std::vector<const Page*> pages;
+	std::size_t begin = 0;
+	while (begin < frames.size()) {
+	    File* file = bufDescTable[frames[begin]].file;
+	    std::size_t end = begin;
+	    pages.clear();
+	    while (end < frames.size() && bufDescTable[frames[end]].file == file) {
+		pages.push_back(&bufPool[frames[end]]);
+		end++;
+	    }
+	    std::chrono::steady_clock::time_point start;
+	    {
+		std::lock_guard<std::mutex> io(ioLatchOf(file));
+		start = std::chrono::steady_clock::now();
+		file->writePages(pages);
+	    }
+	    std::uint64_t ns = elapsedNs(start);
+	    for (std::size_t f = begin; f < end; f++) {
+		BufDesc& desc = bufDescTable[frames[f]];
+		BufPartition& part = partitionOf(desc.file, desc.pageNo);
+		part.bufStats.diskwrites++;
+		desc.fileStats->diskwrites++;
+		if (f == begin) {
+		    // The batch is a single write operation.
+		    part.bufStats.writeLatency.record(ns);
+		    desc.fileStats->writeLatency.record(ns);
+		}
+		desc.dirty = false;
+	    }
+	    begin = end;
+	}
+    }
+
+    void BufMgr::writeEvicted(BufPartition& part, EvictedPage& evicted) {
+	if (evicted.file == NULL) {
+	    return;
+	}
+	PageKey key = {evicted.file, evicted.page->page_number()};
+	std::chrono::steady_clock::time_point start;
+	try {
+	    std::lock_guard<std::mutex> io(ioLatchOf(evicted.file));
+	    start = std::chrono::steady_clock::now();
+	    evicted.file->writePage(*evicted.page);
+	} catch (...) {
+	    std::lock_guard<std::mutex> guard(part.latch);
+	    part.pendingWrites.erase(key);
+	    part.ioDone.notify_all();
+	    throw;
+	}
+	std::uint64_t ns = elapsedNs(start);
+	std::lock_guard<std::mutex> guard(part.latch);
+	part.pendingWrites.erase(key);
+	part.ioDone.notify_all();
+	// The page has left the pool, so its file's entry may be gone too.
+	BufStats& fileStats = part.statsByFile[evicted.file->filename()];
+	part.bufStats.diskwrites++;
+	part.bufStats.writeLatency.record(ns);
+	fileStats.diskwrites++;
+	fileStats.writeLatency.record(ns);
+    }
+
+    void BufMgr::lockPartitions(const File* file) {
+	std::function<bool(const BufPartition&)> writing = [file](const BufPartition& part) {
+	    for (std::unordered_set<PageKey, PageKeyHash>::const_iterator it = part.pendingWrites.begin();
+		 it != part.pendingWrites.end(); ++it) {
+		if (file == NULL || it->file == file) {
+		    return true;
+		}
+	    }
+	    return false;
+	};
+	for (;;) {
+	    for (std::uint32_t p = 0; p < numPartitions; p++) {
+		partitions[p].latch.lock();
+	    }
+	    std::uint32_t busy = 0;
+	    while (busy < numPartitions && !writing(partitions[busy])) {
+		busy++;
+	    }
+	    if (busy == numPartitions) {
 		return;
-	    }           
+	    }
+	    for (std::uint32_t p = numPartitions; p > 0; p--) {
+		partitions[p - 1].latch.unlock();
+	    }
+	    // Wait with that latch alone, which the writer needs to finish.
+	    // More writes may start meanwhile, so check all partitions again.
+	    BufPartition& part = partitions[busy];
+	    std::unique_lock<std::mutex> guard(part.latch);
+	    part.ioDone.wait(guard, [&writing, &part]() { return !writing(part); });
 	}
-	// All the pages are pinned.
-	throw BufferExceededException();
     }
 
+    void BufMgr::linkFrame(BufPartition& part, FrameId frame) {
+	BufDesc& desc = bufDescTable[frame];
+	std::unordered_map<const File*, FrameId>::iterator head = part.fileFrames.find(desc.file);
+	desc.prevInFile = BufDesc::NO_FRAME;
+	if (head == part.fileFrames.end()) {
+	    desc.nextInFile = BufDesc::NO_FRAME;
+	    part.fileFrames[desc.file] = frame;
+	} else {
+	    desc.nextInFile = head->second;
+	    bufDescTable[head->second].prevInFile = frame;
+	    head->second = frame;
+	}
+	std::size_t files = part.statsByFile.size();
+	desc.fileStats = &part.statsByFile[desc.file->filename()];
+	if (part.statsByFile.size() > files &&
+	    part.statsByFile.size() > 2 * part.fileFrames.size() + IDLE_FILE_STATS) {
+	    // Files that come and go would grow the map without bound. Prune it
+	    // when idle entries outnumber the files with pages, so the cost of a
+	    // pass is spread over as many new files.
+	    pruneFileStats(part);
+	}
+    }
 
-    void BufMgr::readPage(File* file, const PageId pageNo, Page*& page) {
+    void BufMgr::unlinkFrame(BufPartition& part, FrameId frame) {
+	BufDesc& desc = bufDescTable[frame];
+	if (numListeners.load(std::memory_order_acquire) != 0) {
+	    std::lock_guard<std::mutex> guard(listenerLatch);
+	    std::unordered_map<const File*, BufEvictionListener*>::iterator it = evictionListeners.find(desc.file);
+	    if (it != evictionListeners.end()) {
+		it->second->pageEvicted(desc.file, desc.pageNo, frame);
+	    }
+	}
+	if (desc.nextInFile != BufDesc::NO_FRAME) {
+	    bufDescTable[desc.nextInFile].prevInFile = desc.prevInFile;
+	}
+	if (desc.prevInFile != BufDesc::NO_FRAME) {
+	    bufDescTable[desc.prevInFile].nextInFile = desc.nextInFile;
+	} else if (desc.nextInFile != BufDesc::NO_FRAME) {
+	    part.fileFrames[desc.file] = desc.nextInFile;
+	} else {
+	    // Last frame of the file; drop the entry so a later File object at
+	    // the same address starts out empty.
+	    part.fileFrames.erase(desc.file);
+	}
+	desc.prevInFile = desc.nextInFile = BufDesc::NO_FRAME;
+	desc.fileStats = NULL;
+    }
+
+    void BufMgr::pruneFileStats(BufPartition& part) {
+	// Several File objects may have the same file open; keep the entry
+	// while any of them has pages here.
+	std::unordered_set<std::string> resident;
+	for (std::unordered_map<const File*, FrameId>::const_iterator it = part.fileFrames.begin();
+	     it != part.fileFrames.end(); ++it) {
+	    resident.insert(it->first->filename());
+	}
+	std::unordered_map<std::string, BufStats>::iterator it = part.statsByFile.begin();
+	while (it != part.statsByFile.end()) {
+	    if (resident.count(it->first) == 0) {
+		it = part.statsByFile.erase(it);
+	    } else {
+		++it;
+	    }
+	}
+    }
+
+
+    void BufMgr::readPage(File* file, const PageId pageNo, Page*& page, BufferAccessStrategy* strategy) {
 	// *&: a reference to a pointer to a Page.
+	FrameId frameNo = pinPage(file, pageNo, strategy);
+	// The caller may write through the pointer until unPinPage(), so it
+	// counts as a writer for optimistic readers until then.
+	beginWrite(frameNo);
+	page = &bufPool[frameNo];
+    }
+
+    PageHandle BufMgr::readPage(File* file, const PageId pageNo, BufferAccessStrategy* strategy) {
+	FrameId frameNo = pinPage(file, pageNo, strategy);
+	return PageHandle(this, frameNo, pageNo, &bufPool[frameNo]);
+    }
+
+    void BufMgr::readPages(File* file, const std::vector<PageId>& pageNos, std::vector<Page*>& pages) {
+	std::vector<FrameId> frames;
+	pinPages(file, pageNos, frames);
+	pages.resize(frames.size());
+	for (std::size_t i = 0; i < frames.size(); i++) {
+	    // A writer until unPinPage(), as in readPage().
+	    beginWrite(frames[i]);
+	    pages[i] = &bufPool[frames[i]];
+	}
+    }
+
+    std::vector<PageHandle> BufMgr::readPages(File* file, const std::vector<PageId>& pageNos) {
+	std::vector<FrameId> frames;
+	pinPages(file, pageNos, frames);
+	std::vector<PageHandle> handles;
+	handles.reserve(frames.size());
+	for (std::size_t i = 0; i < frames.size(); i++) {
+	    handles.push_back(PageHandle(this, frames[i], pageNos[i], &bufPool[frames[i]]));
+	}
+	return handles;
+    }
+
+    FrameId BufMgr::pinPage(File* file, const PageId pageNo, BufferAccessStrategy* strategy) {
+	BufPartition& part = partitionOf(file, pageNo);
+	std::unique_lock<std::mutex> guard(part.latch, std::try_to_lock);
+	bool waited = !guard.owns_lock();
+	if (waited) {
+	    guard.lock();
+	}
+	trace(TRACE_READ, file, pageNo);
+	part.mrc->pageRead(file, pageNo);
+	if (part.admission != NULL) {
+	    part.admission->pageRead(file, pageNo);
+	}
 	FrameId frameNo;
+	PageKey key = {file, pageNo};
+	for (;;) {
+	    // Check whether the page is already in the buffer pool.
+	    if (part.hashTable->find(file, pageNo, frameNo)) {
+		if (!bufDescTable[frameNo].loading) {
+		    pinResident(part, frameNo);
+		    break;
+		}
+	    } else if (part.pendingWrites.count(key) == 0) {
+		frameNo = loadPage(part, guard, file, pageNo, strategy);
+		part.bufStats.misses++;
+		bufDescTable[frameNo].fileStats->misses++;
+		break;
+	    }
+	    // Another thread is reading the page, or writing back its last
+	    // version; wait for it rather than for the disk.
+	    waited = true;
+	    part.ioDone.wait(guard);
+	}
+	countAccess(part, bufDescTable[frameNo], waited);
+	return frameNo;
+    }
+
+    PageHandle BufMgr::readPageHinted(File* file, const PageId pageNo, const FrameId frameNo) {
+	if (frameNo < maxBufs) {
+	    // If the frame holds the page it belongs to the page's partition,
+	    // so its latch is the right one.
+	    BufPartition& part = partitionOfFrame(frameNo);
+	    std::unique_lock<std::mutex> guard(part.latch, std::try_to_lock);
+	    bool waited = !guard.owns_lock();
+	    if (waited) {
+		guard.lock();
+	    }
+	    BufDesc& desc = bufDescTable[frameNo];
+	    if (desc.valid && !desc.loading && desc.file == file && desc.pageNo == pageNo) {
+		trace(TRACE_READ, file, pageNo);
+		part.mrc->pageRead(file, pageNo);
+		if (part.admission != NULL) {
+		    part.admission->pageRead(file, pageNo);
+		}
+		pinResident(part, frameNo);
+		countAccess(part, desc, waited);
+		return PageHandle(this, frameNo, pageNo, &bufPool[frameNo]);
+	    }
+	}
+	return readPage(file, pageNo);
+    }
+
+    bool BufMgr::pinIfResident(File* file, const PageId pageNo, FrameId& frameNo) {
+	BufPartition& part = partitionOf(file, pageNo);
+	std::unique_lock<std::mutex> guard(part.latch, std::try_to_lock);
+	bool waited = !guard.owns_lock();
+	if (waited) {
+	    guard.lock();
+	}
+	// A page still being read counts as missing; the caller then waits for
+	// it in pinPage().
+	if (!part.hashTable->find(file, pageNo, frameNo) || bufDescTable[frameNo].loading) {
+	    return false;
+	}
+	trace(TRACE_READ, file, pageNo);
+	part.mrc->pageRead(file, pageNo);
+	if (part.admission != NULL) {
+	    part.admission->pageRead(file, pageNo);
+	}
+	pinResident(part, frameNo);
+	countAccess(part, bufDescTable[frameNo], waited);
+	return true;
+    }
+
+    void BufMgr::pinResident(BufPartition& part, const FrameId frameNo) {
+	bufDescTable[frameNo].refbit = true;
+	bufDescTable[frameNo].pinCnt++;
+	part.policy->frameAccessed(frameNo);
+	part.bufStats.hits++;
+	bufDescTable[frameNo].fileStats->hits++;
+    }
+
+    void BufMgr::trace(BufTraceOp op, const File* file, PageId pageNo) {
+	if (tracing.load(std::memory_order_relaxed)) {
+	    std::lock_guard<std::mutex> guard(traceLatch);
+	    if (tracer != NULL) {
+		tracer->record(op, file, pageNo);
+	    }
+	}
+    }
+
+    void BufMgr::countAccess(BufPartition& part, BufDesc& desc, bool waited) {
+	part.bufStats.accesses++;
+	desc.fileStats->accesses++;
+	if (waited) {
+	    part.bufStats.pinwaits++;
+	    desc.fileStats->pinwaits++;
+	}
+    }
+
+
+    FrameId BufMgr::loadPage(BufPartition& part, std::unique_lock<std::mutex>& guard, File* file, const PageId pageNo,
+			     BufferAccessStrategy* strategy) {
+	FrameId frameNo;
+	EvictedPage evicted;
+	// Allocate a buffer frame, from the strategy's ring if possible.
+	if (strategy == NULL || !reclaimRingFrame(part, *strategy, frameNo)) {
+	    allocBuf(part, frameNo, file, pageNo, &evicted);
+	}
+	// Take the page from the compressed tier if it is there, otherwise read
+	// it from the disk to the buffer pool frame.
+	bool fromTier = part.victimCache != NULL && part.victimCache->take(file, pageNo, bufPool[frameNo]);
+	installPage(part, frameNo, file, pageNo);
+	BufDesc& desc = bufDescTable[frameNo];
+	std::uint64_t ns = 0;
+	if (!fromTier || evicted.file != NULL) {
+	    // Release the latch for the I/O, so that it does not hold up the
+	    // rest of the partition. The frame is registered already, marked
+	    // loading; threads wanting the page wait for it in pinPage().
+	    desc.loading = true;
+	    desc.beginWrite();
+	    guard.unlock();
+	    try {
+		writeEvicted(part, evicted);
+		if (!fromTier) {
+		    std::lock_guard<std::mutex> io(ioLatchOf(file));
+		    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		    file->readPage(pageNo, bufPool[frameNo]);
+		    ns = elapsedNs(start);
+		}
+	    } catch (...) {
+		// The frame stays empty; hand it back to the policy.
+		guard.lock();
+		desc.endWrite();
+		part.hashTable->remove(file, pageNo);
+		unlinkFrame(part, frameNo);
+		desc.Clear();
+		part.policy->frameFreed(frameNo);
+		part.ioDone.notify_all();
+		throw;
+	    }
+	    guard.lock();
+	    desc.loading = false;
+	    desc.endWrite();
+	    part.ioDone.notify_all();
+	}
+	if (fromTier) {
+	    part.bufStats.victimhits++;
+	    bufDescTable[frameNo].fileStats->victimhits++;
+	} else {
+	    part.bufStats.diskreads++;
+	    part.bufStats.readLatency.record(ns);
+	    bufDescTable[frameNo].fileStats->diskreads++;
+	    bufDescTable[frameNo].fileStats->readLatency.record(ns);
+	}
+	if (strategy != NULL) {
+	    // Remember the frame in the current ring slot and move on.
+	    std::uint32_t p = &part - partitions;
+	    BufferAccessStrategy::RingSlot slot = {frameNo, file, pageNo};
+	    std::vector<BufferAccessStrategy::RingSlot>& ring = strategy->rings[p];
+	    std::uint32_t& next = strategy->nextSlot[p];
+	    if (next < ring.size()) {
+		ring[next] = slot;
+	    } else {
+		ring.push_back(slot);
+	    }
+	    std::uint32_t share = strategy->ringSize / numPartitions;
+	    next = (next + 1) % (share > 0 ? share : 1);
+	}
+	return frameNo;
+    }
+
+
+    void BufMgr::installPage(BufPartition& part, FrameId frameNo, File* file, const PageId pageNo) {
+	// Insert the page into the hashtable.
+	part.hashTable->insert(file, pageNo, frameNo);
+	// Set up the frame properly.
+	bufDescTable[frameNo].Set(file, pageNo);
+	linkFrame(part, frameNo);
+	part.policy->frameLoaded(frameNo, file, pageNo);
+    }
+
+
+    void BufMgr::pinPages(File* file, const std::vector<PageId>& pageNos, std::vector<FrameId>& frames) {
+	frames.assign(pageNos.size(), BufDesc::NO_FRAME);
+	std::unordered_map<PageId, FrameId> loaded;
 	try {
-	    // Check whether the page is already in the buffer pool. 
-	    hashTable->lookup(file, pageNo, frameNo);
-	    bufDescTable[frameNo].refbit = true;
-	    bufDescTable[frameNo].pinCnt++;
-	    page = &bufPool[frameNo];
-            bufStats.accesses++;
-	} catch (HashNotFoundException& e) {
-	    // Allocate a buffer frame.
-	    allocBuf(frameNo);
-	    // Read the page from the disk to the buffer pool frame.
-	    bufPool[frameNo] = file->readPage(pageNo);
-            bufStats.accesses++;
-            bufStats.diskreads++;
-	    // Insert the page into the hashtable.
-	    hashTable->insert(file, pageNo, frameNo);
-	    // Set up the frame properly.
-	    bufDescTable[frameNo].Set(file, pageNo);
-	    page = &bufPool[frameNo];
-            bufStats.accesses++;
-	} catch (BufferExceededException& e) {
-	    /* All the pages are pinned currently */
+	    // Pin the hits in one pass.
+	    std::vector<PageId> misses;
+	    for (std::size_t i = 0; i < pageNos.size(); i++) {
+		if (!pinIfResident(file, pageNos[i], frames[i])) {
+		    frames[i] = BufDesc::NO_FRAME;
+		    misses.push_back(pageNos[i]);
+		}
+	    }
+	    // Read each missing page once, and neighbouring ones together.
+	    std::sort(misses.begin(), misses.end());
+	    misses.erase(std::unique(misses.begin(), misses.end()), misses.end());
+	    std::vector<PageId> run;
+	    std::size_t begin = 0;
+	    while (begin < misses.size()) {
+		std::size_t end = begin + 1;
+		while (end < misses.size() && misses[end] - misses[end - 1] <= MAX_COALESCED_GAP + 1 &&
+		       misses[end] - misses[begin] < File::MAX_READ_RUN) {
+		    end++;
+		}
+		run.assign(misses.begin() + begin, misses.begin() + end);
+		loadRun(file, run, loaded);
+		begin = end;
+	    }
+	    // Each loaded page is pinned once; pin it again for every further
+	    // entry listing it.
+	    for (std::size_t i = 0; i < pageNos.size(); i++) {
+		if (frames[i] != BufDesc::NO_FRAME) {
+		    continue;
+		}
+		std::unordered_map<PageId, FrameId>::iterator it = loaded.find(pageNos[i]);
+		if (it != loaded.end()) {
+		    frames[i] = it->second;
+		    loaded.erase(it);
+		} else {
+		    frames[i] = pinPage(file, pageNos[i], NULL);
+		}
+	    }
+	} catch (...) {
+	    for (std::size_t i = 0; i < frames.size(); i++) {
+		if (frames[i] != BufDesc::NO_FRAME) {
+		    unPinFrame(frames[i], false);
+		}
+	    }
+	    for (std::unordered_map<PageId, FrameId>::iterator it = loaded.begin(); it != loaded.end(); ++it) {
+		unPinFrame(it->second, false);
+	    }
+	    throw;
+	}
+    }
+
+
+    void BufMgr::loadRun(File* file, const std::vector<PageId>& pageNos, std::unordered_map<PageId, FrameId>& loaded,
+			 const bool demand) {
+	// Latch the partitions of the pages in partition order, as flushFile()
+	// does, which keeps this deadlock free.
+	std::vector<std::uint32_t> parts;
+	for (std::size_t k = 0; k < pageNos.size(); k++) {
+	    parts.push_back(&partitionOf(file, pageNos[k]) - partitions);
+	}
+	std::sort(parts.begin(), parts.end());
+	parts.erase(std::unique(parts.begin(), parts.end()), parts.end());
+	for (std::size_t p = 0; p < parts.size(); p++) {
+	    partitions[parts[p]].latch.lock();
+	}
+	PageId first = pageNos.front();
+	// The pages to read from the disk, and their frames. Pages between
+	// them are read along but not kept.
+	std::vector<Page*> targets(pageNos.back() - first + 1, NULL);
+	std::vector<std::pair<PageId, FrameId> > reading;
+	// Dirty victims of the frames, written back before the read.
+	std::vector<EvictedPage> evicted;
+	std::exception_ptr failure;
+	try {
+	    for (std::size_t k = 0; k < pageNos.size(); k++) {
+		PageId pageNo = pageNos[k];
+		BufPartition& part = partitionOf(file, pageNo);
+		if (demand) {
+		    trace(TRACE_READ, file, pageNo);
+		    part.mrc->pageRead(file, pageNo);
+		    if (part.admission != NULL) {
+			part.admission->pageRead(file, pageNo);
+		    }
+		}
+		FrameId frameNo;
+		PageKey key = {file, pageNo};
+		if (part.hashTable->find(file, pageNo, frameNo)) {
+		    // A page another thread is still reading is left to the
+		    // caller, as is one being written back below.
+		    if (!demand || bufDescTable[frameNo].loading) {
+			continue;
+		    }
+		    // Loaded by another thread since the caller looked.
+		    pinResident(part, frameNo);
+		    countAccess(part, bufDescTable[frameNo], false);
+		    loaded[pageNo] = frameNo;
+		    continue;
+		}
+		if (part.pendingWrites.count(key) != 0) {
+		    continue;
+		}
+		evicted.push_back(EvictedPage());
+		allocBuf(part, frameNo, file, pageNo, &evicted.back());
+		if (part.victimCache != NULL && part.victimCache->take(file, pageNo, bufPool[frameNo])) {
+		    installPage(part, frameNo, file, pageNo);
+		    part.bufStats.victimhits++;
+		    bufDescTable[frameNo].fileStats->victimhits++;
+		    if (demand) {
+			part.bufStats.misses++;
+			bufDescTable[frameNo].fileStats->misses++;
+			countAccess(part, bufDescTable[frameNo], false);
+		    }
+		    loaded[pageNo] = frameNo;
+		} else {
+		    // Register the frame now, marked loading as in loadPage(), so
+		    // that the latches can be released for the read.
+		    installPage(part, frameNo, file, pageNo);
+		    bufDescTable[frameNo].loading = true;
+		    bufDescTable[frameNo].beginWrite();
+		    targets[pageNo - first] = &bufPool[frameNo];
+		    reading.push_back(std::make_pair(pageNo, frameNo));
+		}
+	    }
+	} catch (...) {
+	    failure = std::current_exception();
+	}
+	for (std::size_t p = parts.size(); p > 0; p--) {
+	    partitions[parts[p - 1]].latch.unlock();
+	}
+	// Every evicted page is written back, even after a failure, so that
+	// none is lost or left in pendingWrites.
+	for (std::size_t e = 0; e < evicted.size(); e++) {
+	    if (evicted[e].file == NULL) {
+		continue;
+	    }
+	    try {
+		writeEvicted(partitionOf(evicted[e].file, evicted[e].page->page_number()), evicted[e]);
+	    } catch (...) {
+		if (!failure) {
+		    failure = std::current_exception();
+		}
+	    }
+	}
+	std::uint64_t ns = 0;
+	if (!failure && !reading.empty()) {
+	    try {
+		std::lock_guard<std::mutex> io(ioLatchOf(file));
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		file->readPages(first, targets);
+		ns = elapsedNs(start);
+	    } catch (...) {
+		failure = std::current_exception();
+	    }
+	}
+	for (std::size_t p = 0; p < parts.size(); p++) {
+	    partitions[parts[p]].latch.lock();
+	}
+	for (std::size_t r = 0; r < reading.size(); r++) {
+	    PageId pageNo = reading[r].first;
+	    FrameId frameNo = reading[r].second;
+	    BufPartition& part = partitionOf(file, pageNo);
+	    BufDesc& desc = bufDescTable[frameNo];
+	    desc.loading = false;
+	    desc.endWrite();
+	    if (failure) {
+		// The frame stays empty; hand it back to the policy.
+		part.hashTable->remove(file, pageNo);
+		unlinkFrame(part, frameNo);
+		desc.Clear();
+		part.policy->frameFreed(frameNo);
+		continue;
+	    }
+	    part.bufStats.diskreads++;
+	    desc.fileStats->diskreads++;
+	    if (r == 0) {
+		// The run is a single read operation.
+		part.bufStats.readLatency.record(ns);
+		desc.fileStats->readLatency.record(ns);
+	    }
+	    if (demand) {
+		part.bufStats.misses++;
+		desc.fileStats->misses++;
+		countAccess(part, desc, false);
+	    }
+	    loaded[pageNo] = frameNo;
+	}
+	for (std::size_t p = parts.size(); p > 0; p--) {
+	    partitions[parts[p - 1]].ioDone.notify_all();
+	    partitions[parts[p - 1]].latch.unlock();
+	}
+	if (failure) {
+	    std::rethrow_exception(failure);
 	}
     }
 
 
-    void BufMgr::unPinPage(File* file, const PageId pageNo, const bool dirty) {
+    bool BufMgr::reclaimRingFrame(BufPartition& part, BufferAccessStrategy& strategy, FrameId& frame) {
+	if (strategy.rings.size() != numPartitions) {
+	    strategy.rings.resize(numPartitions);
+	    strategy.nextSlot.resize(numPartitions, 0);
+	}
+	std::uint32_t p = &part - partitions;
+	std::uint32_t next = strategy.nextSlot[p];
+	if (next >= strategy.rings[p].size()) {
+	    // The ring is still filling up.
+	    return false;
+	}
+	const BufferAccessStrategy::RingSlot& slot = strategy.rings[p][next];
+	PageKey page = {slot.file, slot.pageNo};
+	if (!reclaimFrame(part, slot.frameNo, page)) {
+	    return false;
+	}
+	frame = slot.frameNo;
+	return true;
+    }
+
+
+    bool BufMgr::reclaimFrame(BufPartition& part, FrameId frame, const PageKey& page) {
+	BufDesc& desc = bufDescTable[frame];
+	// Someone else may have taken over the page or the frame since it was
+	// loaded; then it is no longer there to recycle.
+	if (!desc.valid || desc.file != page.file || desc.pageNo != page.pageNo ||
+	    desc.pinCnt != 0 || desc.dirty) {
+	    return false;
+	}
+	part.bufStats.evictions++;
+	desc.fileStats->evictions++;
+	part.hashTable->remove(desc.file, desc.pageNo);
+	unlinkFrame(part, frame);
+	desc.Clear();
+	part.policy->frameReclaimed(frame);
+	return true;
+    }
+
+
+    void BufMgr::prefetch(File* file, const PageId firstPageNo, const PageId numPages) {
+	std::vector<PageId> pageNos;
+	for (PageId p = 0; p < numPages; p++) {
+	    pageNos.push_back(firstPageNo + p);
+	}
+	prefetch(file, pageNos);
+    }
+
+
+    void BufMgr::prefetch(File* file, const std::vector<PageId>& pageNos) {
+	{
+	    std::lock_guard<std::mutex> guard(prefetchLatch);
+	    startPrefetchWorkers();
+	    for (std::size_t p = 0; p < pageNos.size(); p++) {
+		PrefetchRequest request = {file, pageNos[p], PageCallback()};
+		prefetchQueue.push_back(request);
+	    }
+	}
+	prefetchReady.notify_all();
+    }
+
+
+    void BufMgr::readPageAsync(File* file, const PageId pageNo, PageCallback done) {
 	FrameId frameNo;
+	if (pinIfResident(file, pageNo, frameNo)) {
+	    done(PageHandle(this, frameNo, pageNo, &bufPool[frameNo]), std::exception_ptr());
+	    return;
+	}
+	{
+	    std::lock_guard<std::mutex> guard(prefetchLatch);
+	    startPrefetchWorkers();
+	    PrefetchRequest request = {file, pageNo, done};
+	    prefetchQueue.push_back(request);
+	}
+	prefetchReady.notify_one();
+    }
+
+
+    void BufMgr::startPrefetchWorkers() {
+	// Start the I/O workers on first use.
+	if (!prefetchRunning) {
+	    prefetchRunning = true;
+	    for (unsigned int w = 0; w < PREFETCH_THREADS; w++) {
+		prefetchWorkers.push_back(std::thread(&BufMgr::prefetchLoop, this));
+	    }
+	}
+    }
+
+
+    void BufMgr::prefetchLoop() {
+	std::unique_lock<std::mutex> guard(prefetchLatch);
+	for (;;) {
+	    while (prefetchRunning && prefetchQueue.empty()) {
+		prefetchReady.wait(guard);
+	    }
+	    if (!prefetchRunning) {
+		return;
+	    }
+	    PrefetchRequest request = prefetchQueue.front();
+	    prefetchQueue.pop_front();
+	    prefetchBusy.insert(request.file);
+	    guard.unlock();
+
+	    if (request.done) {
+		PageHandle page;
+		std::exception_ptr error;
+		try {
+		    page = readPage(request.file, request.pageNo);
+		} catch (...) {
+		    error = std::current_exception();
+		}
+		request.done(std::move(page), error);
+	    } else {
+		loadUnpinned(request.file, request.pageNo);
+	    }
+
+	    guard.lock();
+	    prefetchBusy.erase(prefetchBusy.find(request.file));
+	    prefetchDone.notify_all();
+	}
+    }
+
+
+    bool BufMgr::loadUnpinned(File* file, const PageId pageNo) {
+	BufPartition& part = partitionOf(file, pageNo);
+	std::unique_lock<std::mutex> guard(part.latch);
+	FrameId frameNo;
+	PageKey key = {file, pageNo};
+	// A page being written back left the pool just now; no need to wait.
+	if (part.hashTable->find(file, pageNo, frameNo) || part.pendingWrites.count(key) != 0) {
+	    return false;
+	}
 	try {
-	    // Find the frame containing file and pageNo.
-	    hashTable->lookup(file, pageNo, frameNo);
-	    if (bufDescTable[frameNo].pinCnt == 0) {
-		// The pin count of this frame is already zero.
-		throw PageNotPinnedException(bufDescTable[frameNo].file->filename(), pageNo, frameNo);
+	    frameNo = loadPage(part, guard, file, pageNo);
+	} catch (BadgerDbException& e) {
+	    /* Page does not exist or every frame is pinned; it is only a hint. */
+	    return false;
+	}
+	// Leave the page resident but unpinned.
+	bufDescTable[frameNo].pinCnt = 0;
+	return true;
+    }
+
+
+    void BufMgr::cancelPrefetch(const File* file) {
+	std::unique_lock<std::mutex> guard(prefetchLatch);
+	bool waiting = false;
+	for (std::deque<PrefetchRequest>::iterator it = prefetchQueue.begin(); it != prefetchQueue.end(); ) {
+	    if (it->file != file) {
+		++it;
+	    } else if (it->done) {
+		// Someone waits for the page; let the workers get to it.
+		waiting = true;
+		++it;
 	    } else {
-		// Decrement pin count.
-		bufDescTable[frameNo].pinCnt--;
+		it = prefetchQueue.erase(it);
 	    }
-	    if (dirty) {
-		bufDescTable[frameNo].dirty = true;
+	}
+	while (waiting || prefetchBusy.count(file) != 0) {
+	    prefetchDone.wait(guard);
+	    waiting = false;
+	    for (std::size_t r = 0; r < prefetchQueue.size() && !waiting; r++) {
+		waiting = prefetchQueue[r].file == file;
 	    }
-	} catch (HashNotFoundException& e) {
-	    /* Do nothing if page is not found in the hash table lookup. */
 	}
     }
 
+
+    void BufMgr::unPinPage(File* file, const PageId pageNo, const bool dirty, AccessHint hint) {
+	BufPartition& part = partitionOf(file, pageNo);
+	std::lock_guard<std::mutex> guard(part.latch);
+	FrameId frameNo;
+	// Find the frame containing file and pageNo. Do nothing if the page is
+	// not in the buffer pool.
+	if (!part.hashTable->find(file, pageNo, frameNo)) {
+	    return;
+	}
+	if (bufDescTable[frameNo].pinCnt == 0) {
+	    // The pin count of this frame is already zero.
+	    throw PageNotPinnedException(bufDescTable[frameNo].file->filename(), pageNo, frameNo);
+	} else {
+	    // Decrement pin count.
+	    bufDescTable[frameNo].pinCnt--;
+	}
+	part.policy->frameUnpinned(bufDescTable, frameNo, hint);
+	trace(dirty ? TRACE_UNPIN_DIRTY : TRACE_UNPIN, file, pageNo);
+	if (dirty) {
+	    bufDescTable[frameNo].dirty = true;
+	}
+	// Retire the writer announced when the page was pinned through a Page*.
+	bufDescTable[frameNo].endWrite();
+    }
+
+    void BufMgr::unPinFrame(const FrameId frameNo, const bool dirty, const bool writing, AccessHint hint) {
+	// The caller holds a pin, so the frame still holds its page and the
+	// partition can be found without the hash table.
+	BufPartition& part = partitionOfFrame(frameNo);
+	std::lock_guard<std::mutex> guard(part.latch);
+	if (bufDescTable[frameNo].pinCnt == 0) {
+	    throw PageNotPinnedException(bufDescTable[frameNo].file->filename(), bufDescTable[frameNo].pageNo, frameNo);
+	}
+	bufDescTable[frameNo].pinCnt--;
+	part.policy->frameUnpinned(bufDescTable, frameNo, hint);
+	trace(dirty ? TRACE_UNPIN_DIRTY : TRACE_UNPIN, bufDescTable[frameNo].file, bufDescTable[frameNo].pageNo);
+	if (dirty) {
+	    bufDescTable[frameNo].dirty = true;
+	}
+	if (writing) {
+	    // The handle announced itself as a writer on its first write.
+	    bufDescTable[frameNo].endWrite();
+	}
+    }
+
+    void BufMgr::beginWrite(const FrameId frameNo) {
+	bufDescTable[frameNo].beginWrite();
+    }
+
+    bool BufMgr::readOptimistic(File* file, const PageId pageNo, OptimisticRead& read) {
+	if (read.frame < maxBufs) {
+	    // The descriptors never move and the frames stay mapped, so the
+	    // hint can be checked without a latch. If the frame is reused
+	    // while the caller reads it, validate() notices.
+	    BufDesc& desc = bufDescTable[read.frame];
+	    std::uint64_t version = desc.version.load(std::memory_order_acquire);
+	    if ((version & BufDesc::WRITERS) == 0 && desc.valid && desc.file == file && desc.pageNo == pageNo) {
+		read.version = version;
+		read.page = &bufPool[read.frame];
+		return true;
+	    }
+	}
+	BufPartition& part = partitionOf(file, pageNo);
+	std::lock_guard<std::mutex> guard(part.latch);
+	FrameId frameNo;
+	if (!part.hashTable->find(file, pageNo, frameNo)) {
+	    return false;
+	}
+	std::uint64_t version = bufDescTable[frameNo].version.load(std::memory_order_acquire);
+	if ((version & BufDesc::WRITERS) != 0) {
+	    return false;
+	}
+	read.frame = frameNo;
+	read.version = version;
+	read.page = &bufPool[frameNo];
+	return true;
+    }
+
+    bool BufMgr::validate(const OptimisticRead& read) {
+	std::atomic_thread_fence(std::memory_order_acquire);
+	return bufDescTable[read.frame].version.load(std::memory_order_relaxed) == read.version;
+    }
+
     void BufMgr::flushFile(const File* file) {
-	for (std::uint32_t i = 0; i < numBufs; i++) {
-	    if (bufDescTable[i].file == file) {
-		// The page is pinned.
-		if (bufDescTable[i].pinCnt != 0) {
-		    throw PagePinnedException(bufDescTable[i].file->filename(), bufDescTable[i].pageNo, i);
+	cancelPrefetch(file);
+	// Take every partition latch up front so that the pinned check and the
+	// write back see the same state. Latches are always taken in partition
+	// order, which keeps this deadlock free. Evicted pages of the file still
+	// being written back are waited for, so the file may be closed next.
+	lockPartitions(file);
+	try {
+	    // Only the frames on the file's lists are visited, so the cost does
+	    // not depend on the size of the pool.
+	    std::vector<FrameId> dirty;
+	    for (std::uint32_t p = 0; p < numPartitions; p++) {
+		std::unordered_map<const File*, FrameId>::iterator head = partitions[p].fileFrames.find(file);
+		if (head == partitions[p].fileFrames.end()) {
+		    continue;
 		}
-		// The page is not valid.
-		if (!bufDescTable[i].valid) {
-		    throw BadBufferException(i, bufDescTable[i].dirty, bufDescTable[i].valid, bufDescTable[i].refbit);
+		for (FrameId i = head->second; i != BufDesc::NO_FRAME; i = bufDescTable[i].nextInFile) {
+		    // The page is pinned.
+		    if (bufDescTable[i].pinCnt != 0) {
+			throw PagePinnedException(bufDescTable[i].file->filename(), bufDescTable[i].pageNo, i);
+		    }
+		    // The page is not valid.
+		    if (!bufDescTable[i].valid) {
+			throw BadBufferException(i, bufDescTable[i].dirty, bufDescTable[i].valid, bufDescTable[i].refbit);
+		    }
+		    if (bufDescTable[i].dirty) {
+			dirty.push_back(i);
+		    }
+		}
+	    }
+	    // Flush the dirty pages to disk in one batch.
+	    writeFrames(dirty);
+	    for (std::uint32_t p = 0; p < numPartitions; p++) {
+		BufPartition& part = partitions[p];
+		// The file may be closed next, and another File object could
+		// then get its address.
+		if (part.victimCache != NULL) {
+		    part.victimCache->removeFile(file);
+		}
+		std::unordered_map<const File*, FrameId>::iterator head = part.fileFrames.find(file);
+		if (head == part.fileFrames.end()) {
+		    continue;
+		}
+		FrameId i = head->second;
+		while (i != BufDesc::NO_FRAME) {
+		    FrameId next = bufDescTable[i].nextInFile;
+		    // Remove the corresponding entry from the hash table.
+		    part.hashTable->remove(bufDescTable[i].file, bufDescTable[i].pageNo);
+		    unlinkFrame(part, i);
+		    bufDescTable[i].Clear();
+		    part.policy->frameFreed(i);
+		    i = next;
+		}
+	    }
+	    if (tracing.load(std::memory_order_relaxed)) {
+		std::lock_guard<std::mutex> guard(traceLatch);
+		if (tracer != NULL) {
+		    tracer->record(TRACE_FLUSH, file, 0);
+		    tracer->forgetFile(file);
 		}
 	    }
+	} catch (...) {
+	    for (std::uint32_t p = 0; p < numPartitions; p++) {
+		partitions[p].latch.unlock();
+	    }
+	    throw;
+	}
+	for (std::uint32_t p = 0; p < numPartitions; p++) {
+	    partitions[p].latch.unlock();
 	}
-	// Scan bufDescTable for pages belonging to the file.
-	for (std::uint32_t i = 0; i < numBufs; i++) {
-	    if (bufDescTable[i].file == file) {
-		// Flush the page to disk if the page is dirty.
-		if (bufDescTable[i].dirty) {
-		    bufDescTable[i].file->writePage(bufPool[i]);
-                    bufStats.accesses++;
-                    bufStats.diskwrites++;
-		    bufDescTable[i].dirty = false;
+    }
+
+    void BufMgr::checkpoint() {
+	lockPartitions(NULL);
+	try {
+	    std::vector<FrameId> dirty;
+	    for (std::uint32_t p = 0; p < numPartitions; p++) {
+		for (FrameId i = partitions[p].firstFrame; i < partitions[p].firstFrame + partitions[p].numFrames; i++) {
+		    if (bufDescTable[i].valid && bufDescTable[i].dirty && bufDescTable[i].pinCnt == 0) {
+			dirty.push_back(i);
+		    }
 		}
-		// Remove the corresponding entry from the hash table.
-		hashTable->remove(bufDescTable[i].file, bufDescTable[i].pageNo);
-		bufDescTable[i].Clear();
 	    }
-	}               
+	    writeFrames(dirty);
+	} catch (...) {
+	    for (std::uint32_t p = 0; p < numPartitions; p++) {
+		partitions[p].latch.unlock();
+	    }
+	    throw;
+	}
+	for (std::uint32_t p = 0; p < numPartitions; p++) {
+	    partitions[p].latch.unlock();
+	}
     }
 
     void BufMgr::allocPage(File* file, PageId &pageNo, Page*& page) {
+	FrameId frameNo = pinNewPage(file, pageNo);
+	// A writer until unPinPage(), as in readPage().
+	beginWrite(frameNo);
+	page = &bufPool[frameNo];
+    }
+
+    PageHandle BufMgr::allocPage(File* file, PageId &pageNo) {
+	FrameId frameNo = pinNewPage(file, pageNo);
+	return PageHandle(this, frameNo, pageNo, &bufPool[frameNo]);
+    }
+
+    FrameId BufMgr::pinNewPage(File* file, PageId &pageNo) {
+	// The page number decides the partition, so the page has to be
+	// allocated in the file before a frame can be picked for it.
+	Page newPage;
+	{
+	    std::lock_guard<std::mutex> io(ioLatchOf(file));
+	    newPage = file->allocatePage();
+	}
+	pageNo = newPage.page_number();
+	BufPartition& part = partitionOf(file, pageNo);
+	std::unique_lock<std::mutex> guard(part.latch, std::try_to_lock);
+	bool waited = !guard.owns_lock();
+	if (waited) {
+	    guard.lock();
+	}
 	FrameId frameNo;
-	allocBuf(frameNo);
+	EvictedPage evicted;
+	try {
+	    allocBuf(part, frameNo, NULL, 0, &evicted);
+	} catch (BufferExceededException& e) {
+	    // Give the page back to the file so a failed call leaves no trace.
+	    guard.unlock();
+	    std::lock_guard<std::mutex> io(ioLatchOf(file));
+	    file->deletePage(pageNo);
+	    throw;
+	}
+	trace(TRACE_ALLOC, file, pageNo);
+	part.mrc->pageAllocated(file, pageNo);
 	// Allocate an empty page.
-	bufPool[frameNo] = file->allocatePage();
-        bufStats.accesses++;
-	page = &bufPool[frameNo];
-        bufStats.accesses++;
+	bufPool[frameNo] = newPage;
 	// Insert the corresponding entry to the hash table.
-	pageNo = bufPool[frameNo].page_number();
-        bufStats.accesses++;
-        hashTable->insert(file, pageNo, frameNo);
+        part.hashTable->insert(file, pageNo, frameNo);
 	bufDescTable[frameNo].Set(file, pageNo);
+	linkFrame(part, frameNo);
+	part.policy->frameLoaded(frameNo, file, pageNo);
+	part.bufStats.allocs++;
+	bufDescTable[frameNo].fileStats->allocs++;
+	countAccess(part, bufDescTable[frameNo], waited);
+	// The new page needs no read, so only a dirty victim is left to write,
+	// once the latch is released.
+	guard.unlock();
+	try {
+	    writeEvicted(part, evicted);
+	} catch (...) {
+	    unPinFrame(frameNo, false);
+	    throw;
+	}
+	return frameNo;
     }
 
     void BufMgr::disposePage(File* file, const PageId PageNo) {
+	BufPartition& part = partitionOf(file, PageNo);
+	std::unique_lock<std::mutex> guard(part.latch);
+	// A write-back still under way would find the page deleted.
+	PageKey key = {file, PageNo};
+	while (part.pendingWrites.count(key) != 0) {
+	    part.ioDone.wait(guard);
+	}
 	FrameId frameNo;
-	try {
-	    // Check if the page to be deleted is in the buffer pool.
-	    hashTable->lookup(file, PageNo, frameNo);
+	// Check if the page to be deleted is in the buffer pool.
+	if (part.hashTable->find(file, PageNo, frameNo)) {
 	    if (bufDescTable[frameNo].pinCnt != 0) {
 		throw PagePinnedException(bufDescTable[frameNo].file->filename(), bufDescTable[frameNo].pageNo, frameNo);
 	    }
 	    // Free the frame.
+	    unlinkFrame(part, frameNo);
 	    bufDescTable[frameNo].Clear();
+	    part.policy->frameFreed(frameNo);
 	    // Delete the corresponding entry from the hashtable.
-	    hashTable->remove(file, PageNo);
-	} catch (HashNotFoundException& e) {
-	    /* Do nothing */
+	    part.hashTable->remove(file, PageNo);
+	}
+	if (part.victimCache != NULL) {
+	    part.victimCache->remove(file, PageNo);
 	}
+	trace(TRACE_DISPOSE, file, PageNo);
 	// Delete the page from the file.
+	std::lock_guard<std::mutex> io(ioLatchOf(file));
 	file->deletePage(PageNo);
     }
 
-    void BufMgr::printSelf(void) 
+    void BufMgr::setHitRatioSampleRate(double rate) {
+	for (std::uint32_t p = 0; p < numPartitions; p++) {
+	    std::lock_guard<std::mutex> guard(partitions[p].latch);
+	    partitions[p].mrc->setMaxRate(rate);
+	}
+    }
+
+    void BufMgr::startTrace(const std::string& path) {
+	// Open the file first so a failure leaves the current trace running.
+	BufTraceWriter* writer = new BufTraceWriter(path);
+	BufTraceWriter* old;
+	{
+	    std::lock_guard<std::mutex> guard(traceLatch);
+	    old = tracer;
+	    tracer = writer;
+	    tracing.store(true, std::memory_order_relaxed);
+	}
+	delete old;
+    }
+
+    std::uint64_t BufMgr::stopTrace() {
+	BufTraceWriter* old;
+	{
+	    std::lock_guard<std::mutex> guard(traceLatch);
+	    old = tracer;
+	    tracer = NULL;
+	    tracing.store(false, std::memory_order_relaxed);
+	}
+	if (old == NULL) {
+	    return 0;
+	}
+	std::uint64_t records = old->numRecords();
+	delete old;
+	return records;
+    }
+
+    void BufMgr::setVictimCacheSize(std::size_t bytes) {
+	for (std::uint32_t p = 0; p < numPartitions; p++) {
+	    BufPartition& part = partitions[p];
+	    std::lock_guard<std::mutex> guard(part.latch);
+	    if (bytes == 0) {
+		delete part.victimCache;
+		part.victimCache = NULL;
+	    } else if (part.victimCache == NULL) {
+		part.victimCache = new VictimCache(bytes / numPartitions);
+	    } else {
+		part.victimCache->setCapacity(bytes / numPartitions);
+	    }
+	}
+    }
+
+    void BufMgr::setAdmissionFilter(bool on) {
+	for (std::uint32_t p = 0; p < numPartitions; p++) {
+	    BufPartition& part = partitions[p];
+	    std::lock_guard<std::mutex> guard(part.latch);
+	    if (!on) {
+		delete part.admission;
+		part.admission = NULL;
+	    } else if (part.admission == NULL) {
+		part.admission = new AdmissionFilter(part.numFrames);
+	    }
+	    part.probation.clear();
+	    part.nextProbation = 0;
+	}
+    }
+
+    void BufMgr::setEvictionListener(const File* file, BufEvictionListener* listener) {
+	std::lock_guard<std::mutex> guard(listenerLatch);
+	if (listener != NULL) {
+	    evictionListeners[file] = listener;
+	} else {
+	    evictionListeners.erase(file);
+	}
+	numListeners.store(evictionListeners.size(), std::memory_order_release);
+    }
+
+    void BufMgr::startFlusher(const BufFlusherConfig& config) {
+	stopFlusher();
+	std::lock_guard<std::mutex> guard(flusherLatch);
+	flusherConfig = config;
+	flusherRunning = true;
+	flusher = std::thread(&BufMgr::flusherLoop, this);
+    }
+
+    void BufMgr::stopFlusher() {
+	{
+	    std::lock_guard<std::mutex> guard(flusherLatch);
+	    if (!flusherRunning) {
+		return;
+	    }
+	    flusherRunning = false;
+	}
+	flusherWakeup.notify_all();
+	flusher.join();
+    }
+
+    void BufMgr::flusherLoop() {
+	std::unique_lock<std::mutex> guard(flusherLatch);
+	std::chrono::steady_clock::time_point lastManifest = std::chrono::steady_clock::now();
+	while (flusherRunning) {
+	    BufFlusherConfig config = flusherConfig;
+	    guard.unlock();
+	    for (std::uint32_t p = 0; p < numPartitions; p++) {
+		cleanPartition(partitions[p], config);
+	    }
+	    if (!config.manifestPath.empty() &&
+		std::chrono::steady_clock::now() - lastManifest >= std::chrono::milliseconds(config.manifestIntervalMs)) {
+		saveManifestQuietly(config.manifestPath);
+		lastManifest = std::chrono::steady_clock::now();
+	    }
+	    guard.lock();
+	    if (flusherRunning) {
+		flusherWakeup.wait_for(guard, std::chrono::milliseconds(config.intervalMs));
+	    }
+	}
+	// Leave the latest resident set behind on a clean shutdown.
+	std::string manifestPath = flusherConfig.manifestPath;
+	guard.unlock();
+	if (!manifestPath.empty()) {
+	    saveManifestQuietly(manifestPath);
+	}
+    }
+
+    void BufMgr::saveManifestQuietly(const std::string& path) {
+	try {
+	    saveManifest(path);
+	} catch (BadgerDbException& e) {
+	    /* The previous manifest stays in place. */
+	}
+    }
+
+    std::size_t BufMgr::saveManifest(const std::string& path) {
+	BufManifest manifest;
+	std::unordered_map<const File*, std::uint32_t> fileIndex;
+	std::vector<std::vector<BufManifest::Entry> > ranked(numPartitions);
+	for (std::uint32_t p = 0; p < numPartitions; p++) {
+	    BufPartition& part = partitions[p];
+	    std::lock_guard<std::mutex> guard(part.latch);
+	    std::vector<FrameId> frames;
+	    part.policy->rankFrames(bufDescTable, frames);
+	    for (std::size_t f = 0; f < frames.size(); f++) {
+		const BufDesc& desc = bufDescTable[frames[f]];
+		if (!desc.valid) {
+		    continue;
+		}
+		std::unordered_map<const File*, std::uint32_t>::iterator it = fileIndex.find(desc.file);
+		if (it == fileIndex.end()) {
+		    it = fileIndex.insert(std::make_pair(desc.file, (std::uint32_t) manifest.files.size())).first;
+		    manifest.files.push_back(desc.file->filename());
+		}
+		BufManifest::Entry entry = {it->second, desc.pageNo};
+		ranked[p].push_back(entry);
+	    }
+	}
+	// Interleave the partitions so that the hottest pages of all of them
+	// come first and a smaller pool loading a prefix gets a fair share.
+	bool more = true;
+	for (std::size_t r = 0; more; r++) {
+	    more = false;
+	    for (std::uint32_t p = 0; p < numPartitions; p++) {
+		if (r < ranked[p].size()) {
+		    manifest.entries.push_back(ranked[p][r]);
+		    more = true;
+		}
+	    }
+	}
+	manifest.save(path);
+	return manifest.entries.size();
+    }
+
+    std::size_t BufMgr::warmUp(const std::string& path, const std::vector<File*>& files, bool background) {
+	BufManifest manifest = BufManifest::load(path);
+	std::vector<File*> byIndex(manifest.files.size(), NULL);
+	for (std::size_t f = 0; f < files.size(); f++) {
+	    for (std::size_t i = 0; i < manifest.files.size(); i++) {
+		if (manifest.files[i] == files[f]->filename()) {
+		    byIndex[i] = files[f];
+		}
+	    }
+	}
+	// Loading more pages than fit would only evict the hottest ones again.
+	std::vector<PrefetchRequest> requests;
+	for (std::size_t e = 0; e < manifest.entries.size() && requests.size() < numBufs; e++) {
+	    File* file = byIndex[manifest.entries[e].file];
+	    if (file != NULL) {
+		PrefetchRequest request = {file, manifest.entries[e].pageNo};
+		requests.push_back(request);
+	    }
+	}
+	std::sort(requests.begin(), requests.end(), [](const PrefetchRequest& a, const PrefetchRequest& b) {
+	    return a.file != b.file ? std::less<File*>()(a.file, b.file) : a.pageNo < b.pageNo;
+	});
+	if (background) {
+	    for (std::size_t begin = 0, end; begin < requests.size(); begin = end) {
+		std::vector<PageId> pageNos;
+		for (end = begin; end < requests.size() && requests[end].file == requests[begin].file; end++) {
+		    pageNos.push_back(requests[end].pageNo);
+		}
+		prefetch(requests[begin].file, pageNos);
+	    }
+	    return requests.size();
+	}
+	// Load neighbouring pages with one read, split into runs as readPages()
+	// does.
+	std::size_t loaded = 0;
+	for (std::size_t begin = 0, end; begin < requests.size(); begin = end) {
+	    File* file = requests[begin].file;
+	    std::vector<PageId> run(1, requests[begin].pageNo);
+	    for (end = begin + 1; end < requests.size() && requests[end].file == file &&
+		     requests[end].pageNo - run.back() <= MAX_COALESCED_GAP + 1 &&
+		     requests[end].pageNo - run.front() < File::MAX_READ_RUN; end++) {
+		if (requests[end].pageNo != run.back()) {
+		    run.push_back(requests[end].pageNo);
+		}
+	    }
+	    std::unordered_map<PageId, FrameId> frames;
+	    bool failed = false;
+	    try {
+		loadRun(file, run, frames, false);
+	    } catch (BadgerDbException& e) {
+		// A page that no longer exists, or a partition with every frame
+		// pinned, fails the run; its other pages are loaded one by one.
+		failed = true;
+	    }
+	    for (std::unordered_map<PageId, FrameId>::iterator it = frames.begin(); it != frames.end(); ++it) {
+		unPinFrame(it->second, false);
+	    }
+	    loaded += frames.size();
+	    for (std::size_t k = 0; failed && k < run.size(); k++) {
+		if (frames.count(run[k]) == 0 && loadUnpinned(file, run[k])) {
+		    loaded++;
+		}
+	    }
+	}
+	return loaded;
+    }
+
+    void BufMgr::cleanPartition(BufPartition& part, const BufFlusherConfig& config) {
+	std::uint32_t low, high;
+	std::uint32_t clean = 0;
+	std::vector<FrameId> candidates;
+	{
+	    std::lock_guard<std::mutex> guard(part.latch);
+	    low = (std::uint32_t) std::ceil(config.lowWatermark * part.numFrames);
+	    high = (std::uint32_t) std::ceil(config.highWatermark * part.numFrames);
+	    std::vector<FrameId> referenced;
+	    for (FrameId i = part.firstFrame; i < part.firstFrame + part.numFrames; i++) {
+		const BufDesc& desc = bufDescTable[i];
+		if (!desc.valid || (desc.pinCnt == 0 && !desc.dirty)) {
+		    clean++;
+		} else if (desc.pinCnt == 0) {
+		    (desc.refbit ? referenced : candidates).push_back(i);
+		}
+	    }
+	    if (clean >= low) {
+		return;
+	    }
+	    candidates.insert(candidates.end(), referenced.begin(), referenced.end());
+	}
+	// Write one frame at a time so that requests for the partition can get
+	// in between the writes.
+	for (std::size_t c = 0; c < candidates.size() && clean < high; c++) {
+	    std::lock_guard<std::mutex> guard(part.latch);
+	    BufDesc& desc = bufDescTable[candidates[c]];
+	    // The frame may have been pinned, cleaned or reused in the meantime.
+	    if (!desc.valid || desc.pinCnt != 0 || !desc.dirty) {
+		continue;
+	    }
+	    writeFrame(part, candidates[c]);
+	    part.bufStats.bgwrites++;
+	    desc.fileStats->bgwrites++;
+	    clean++;
+	}
+    }
+
+    std::uint32_t BufMgr::getNumBufs() {
+	std::lock_guard<std::mutex> guard(resizeLatch);
+	return numBufs;
+    }
+
+    BufStats BufMgr::getBufStats() {
+	BufStats total;
+	for (std::uint32_t p = 0; p < numPartitions; p++) {
+	    std::lock_guard<std::mutex> guard(partitions[p].latch);
+	    total.add(partitions[p].bufStats);
+	}
+	return total;
+    }
+
+    BufStatsSnapshot BufMgr::getStatsSnapshot() {
+	BufStatsSnapshot snapshot;
+	snapshot.numBufs = 0;
+	snapshot.numPartitions = numPartitions;
+	// Partitions sample at rates of their own, so the estimates are summed
+	// after scaling.
+	std::vector<BufHitRatioEstimate> curve(MrcEstimator::NUM_SIZES);
+	std::vector<double> hits(MrcEstimator::NUM_SIZES);
+	double reads = 0;
+	for (std::uint32_t p = 0; p < numPartitions; p++) {
+	    std::lock_guard<std::mutex> guard(partitions[p].latch);
+	    snapshot.numBufs += partitions[p].numFrames;
+	    snapshot.total.add(partitions[p].bufStats);
+	    reads += partitions[p].mrc->estimatedReads();
+	    for (int s = 0; s < MrcEstimator::NUM_SIZES; s++) {
+		curve[s].numBufs += partitions[p].mrc->poolSize(s);
+		hits[s] += partitions[p].mrc->estimatedHits(s);
+	    }
+	    for (std::unordered_map<std::string, BufStats>::const_iterator it = partitions[p].statsByFile.begin();
+		 it != partitions[p].statsByFile.end(); ++it) {
+		snapshot.files[it->first].add(it->second);
+	    }
+	}
+	if (reads > 0) {
+	    for (int s = 0; s < MrcEstimator::NUM_SIZES; s++) {
+		curve[s].hitRatio = hits[s] / reads;
+	    }
+	    snapshot.hitRatioCurve = curve;
+	}
+	return snapshot;
+    }
+
+    void BufMgr::clearBufStats() {
+	for (std::uint32_t p = 0; p < numPartitions; p++) {
+	    std::lock_guard<std::mutex> guard(partitions[p].latch);
+	    partitions[p].bufStats.clear();
+	    partitions[p].mrc->clearCounts();
+	    // Keep the entries of files with pages; descriptors point at them.
+	    pruneFileStats(partitions[p]);
+	    for (std::unordered_map<std::string, BufStats>::iterator it = partitions[p].statsByFile.begin();
+		 it != partitions[p].statsByFile.end(); ++it) {
+		it->second.clear();
+	    }
+	}
+    }
+
+    void BufMgr::printSelf(void)
     {
 	BufDesc* tmpbuf;
 	int validFrames = 0;
 
-	for (std::uint32_t i = 0; i < numBufs; i++)
+	for (std::uint32_t p = 0; p < numPartitions; p++) {
+	    partitions[p].latch.lock();
+	}
+	for (std::uint32_t p = 0; p < numPartitions; p++)
 	{
-	    tmpbuf = &(bufDescTable[i]);
-	    std::cout << "FrameNo:" << i << " ";
-	    tmpbuf->Print();
+	    for (FrameId i = partitions[p].firstFrame; i < partitions[p].firstFrame + partitions[p].numFrames; i++)
+	    {
+		tmpbuf = &(bufDescTable[i]);
+		std::cout << "FrameNo:" << i << " ";
+		tmpbuf->Print();
 
-	    if (tmpbuf->valid == true)
-		validFrames++;
+		if (tmpbuf->valid == true)
+		    validFrames++;
+	    }
+	}
+	for (std::uint32_t p = 0; p < numPartitions; p++) {
+	    partitions[p].latch.unlock();
 	}
 
 	std::cout << "Total Number of Valid Frames:" << validFrames << "\n";
     }
 
+    PageHandle::PageHandle(PageHandle&& other)
+	: bufMgr(other.bufMgr), frameNo(other.frameNo), pageNumber(other.pageNumber), page(other.page), dirty(other.dirty),
+	  writing(other.writing), accessHint(other.accessHint) {
+	other.bufMgr = NULL;
+	other.page = NULL;
+	other.dirty = false;
+	other.writing = false;
+	other.accessHint = NORMAL;
+    }
+
+    PageHandle& PageHandle::operator=(PageHandle&& other) {
+	if (this != &other) {
+	    release();
+	    bufMgr = other.bufMgr;
+	    frameNo = other.frameNo;
+	    pageNumber = other.pageNumber;
+	    page = other.page;
+	    dirty = other.dirty;
+	    writing = other.writing;
+	    accessHint = other.accessHint;
+	    other.bufMgr = NULL;
+	    other.page = NULL;
+	    other.dirty = false;
+	    other.writing = false;
+	    other.accessHint = NORMAL;
+	}
+	return *this;
+    }
+
+    PageHandle::~PageHandle() {
+	try {
+	    release();
+	} catch (PageNotPinnedException& e) {
+	    // Only possible if the page was also unpinned by hand; a destructor
+	    // has no way to report it.
+	}
+    }
+
+    void PageHandle::release() {
+	if (bufMgr == NULL) {
+	    return;
+	}
+	BufMgr* mgr = bufMgr;
+	bufMgr = NULL;
+	page = NULL;
+	mgr->unPinFrame(frameNo, dirty, writing, accessHint);
+	dirty = false;
+	writing = false;
+	accessHint = NORMAL;
+    }
+
 }
@@ -7,8 +7,27 @@
 
 #pragma once
 
+#include <iostream>
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <vector>
+#include <deque>
+#include <set>
+#include <memory>
+#include <unordered_map>
+#include <unordered_set>
 #include "file.h"
 #include "bufHashTbl.h"
+#include "replacement_policy.h"
+#include "buf_stats.h"
+#include "victim_cache.h"
+#include "buf_trace.h"
+#include "mrc_estimator.h"
+#include "admission_filter.h"
 
 namespace badgerdb {
 
@@ -23,6 +42,8 @@ class BufMgr;
 class BufDesc {
 
 	friend class BufMgr;
+	friend class BufSimulator;
+	friend class ReplacementPolicy;
 
  private:
 	/**
@@ -60,17 +81,73 @@ class BufDesc {
 	 */
   bool refbit;
 
+	/**
+   * True while the page is being read into the frame by a thread that released the partition latch for
+   * the read. That thread holds a pin and a writer on the frame meanwhile; others wanting the page wait on
+   * BufPartition::ioDone instead of reading it a second time.
+	 */
+  bool loading;
+
+	/**
+   * Marks the end of a per-file frame list
+	 */
+  static const FrameId NO_FRAME = 0xFFFFFFFF;
+
+	/**
+   * Neighbours in the list of frames of the same partition holding pages of the same file, see
+   * BufPartition::fileFrames. Only meaningful while the frame is valid.
+	 */
+  FrameId prevInFile;
+  FrameId nextInFile;
+
+	/**
+   * Statistics of the file the page belongs to, kept by the partition owning the frame. Only
+   * meaningful while the frame is valid.
+	 */
+  BufStats* fileStats;
+
+	/**
+   * Version of the frame for optimistic reads, see BufMgr::readOptimistic(). The bits in WRITERS count
+   * the writers currently changing the frame or the page in it; the rest is advanced by VERSION_STEP
+   * every time a writer finishes. A reader that sees the same value before and after reading, with no
+   * writers, has read a consistent page.
+	 */
+  std::atomic<std::uint64_t> version;
+
+  static const std::uint64_t WRITERS = 0xFFFF;
+  static const std::uint64_t VERSION_STEP = 0x10000;
+
+	/**
+   * Announces a writer to optimistic readers; must be followed by endWrite()
+	 */
+  void beginWrite()
+	{
+		version.fetch_add(1, std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_release);
+  }
+
+	/**
+   * Retires a writer and advances the version
+	 */
+  void endWrite()
+	{
+		version.fetch_add(VERSION_STEP - 1, std::memory_order_release);
+  }
+
 	/**
    * Initialize buffer frame for a new user
 	 */
   void Clear()
 	{
+		beginWrite();
     pinCnt = 0;
 		file = NULL;
 		pageNo = Page::INVALID_NUMBER;
     dirty = false;
     refbit = false;
 		valid = false;
+		loading = false;
+		endWrite();
   };
 
 	/**
@@ -82,12 +159,15 @@ class BufDesc {
 	 */
   void Set(File* filePtr, PageId pageNum)
 	{ 
+		beginWrite();
 		file = filePtr;
     pageNo = pageNum;
     pinCnt = 1;
     dirty = false;
     valid = true;
     refbit = true;
+		loading = false;
+		endWrite();
   }
 
   void Print()
@@ -110,181 +190,1341 @@ class BufDesc {
    * Constructor of BufDesc class 
 	 */
   BufDesc()
+		: version(0)
 	{
   	Clear();
+		prevInFile = nextInFile = NO_FRAME;
+		fileStats = NULL;
   }
 };
 
 
 /**
-* @brief Class to maintain statistics of buffer usage 
+* @brief Settings of the background flusher, see BufMgr::startFlusher()
 */
-struct BufStats
+struct BufFlusherConfig
 {
 	/**
-   * Total number of accesses to buffer pool
+   * The flusher starts cleaning a partition when less than this fraction of its frames is free or clean and unpinned
+	 */
+  double lowWatermark;
+
+	/**
+   * The flusher keeps cleaning a partition until this fraction of its frames is free or clean and unpinned
+	 */
+  double highWatermark;
+
+	/**
+   * Time in milliseconds between two passes over the partitions
 	 */
-  int accesses;
+  unsigned int intervalMs;
 
 	/**
-   * Number of pages read from disk (including allocs)
+   * File the flusher saves a manifest of the resident pages to, see BufMgr::saveManifest(); empty for
+   * none. The manifest is saved every manifestIntervalMs and once more when the flusher stops, which
+   * includes the destruction of the BufMgr.
 	 */
-  int diskreads;
+  std::string manifestPath;
 
 	/**
-   * Number of pages written back to disk
+   * Time in milliseconds between two manifests
 	 */
-  int diskwrites;
+  unsigned int manifestIntervalMs;
 
 	/**
-   * Clear all values 
+   * Constructor of BufFlusherConfig class 
 	 */
-  void clear()
+  BufFlusherConfig()
+		: lowWatermark(0.1), highWatermark(0.25), intervalMs(10), manifestIntervalMs(60000)
   {
-		accesses = diskreads = diskwrites = 0;
   }
-      
+};
+
+
+/**
+* @brief Access strategy for large sequential scans, passed to BufMgr::readPage().
+*
+* Pages read through a strategy are loaded into a small private ring of frames: once the ring is full,
+* a miss reuses the frame the scan loaded ringSize pages ago if nobody else has pinned or dirtied it in
+* the meantime, instead of evicting a page through the replacement policy. A scan over a relation larger
+* than the pool therefore only ever occupies about ringSize frames and leaves the rest of the pool alone.
+* Pages that are already resident are used in place.
+*
+* @warning This class is not threadsafe; use one object per scan.
+*/
+class BufferAccessStrategy
+{
+	friend class BufMgr;
+
+ public:
+	/**
+   * Default number of frames in the ring
+	 */
+  static const std::uint32_t DEFAULT_RING_SIZE = 16;
+
 	/**
-   * Constructor of BufStats class 
+   * Constructor of BufferAccessStrategy class
+	 *
+	 * @param ringSize 	Number of frames the scan may occupy in the buffer pool
 	 */
-  BufStats()
+  BufferAccessStrategy(std::uint32_t ringSize = DEFAULT_RING_SIZE)
+		: ringSize(ringSize == 0 ? 1 : ringSize)
   {
-		clear();
   }
+
+ private:
+	/**
+   * @brief Frame loaded by the scan and the page it was loaded with
+	 */
+  struct RingSlot
+  {
+    FrameId frameNo;
+    const File* file;
+    PageId pageNo;
+  };
+
+	/**
+   * Number of frames the scan may occupy in the whole pool
+	 */
+  std::uint32_t ringSize;
+
+	/**
+   * One ring per buffer pool partition, each holding its share of ringSize, filled lazily
+	 */
+  std::vector<std::vector<RingSlot> > rings;
+
+	/**
+   * Slot of each ring that the next miss replaces
+	 */
+  std::vector<std::uint32_t> nextSlot;
 };
 
 
 /**
-* @brief The central class which manages the buffer pool including frame allocation and deallocation to pages in the file 
+* @brief A pinned page, returned by BufMgr::readPage() and BufMgr::allocPage().
+*
+* The handle owns one pin on the page and releases it when it goes out of scope, also when an exception
+* unwinds the stack. It remembers the frame holding the page, so unpinning needs no hash table lookup.
+* Write access through getMutable() marks the page dirty and makes optimistic readers of the page (see
+* BufMgr::readOptimistic()) retry until the handle is released. Handles can be moved but not copied; do
+* not call BufMgr::unPinPage() for a page held by a handle.
+*
+* @warning A handle must be released before the BufMgr it came from is destroyed.
 */
-class BufMgr 
+class PageHandle
 {
- private:
+	friend class BufMgr;
+
+ public:
 	/**
-   * Current position of clockhand in our buffer pool
+   * Constructs an empty handle that holds no page
 	 */
-  FrameId clockHand;
+  PageHandle()
+		: bufMgr(NULL), frameNo(0), pageNumber(Page::INVALID_NUMBER), page(NULL), dirty(false), writing(false),
+		  accessHint(NORMAL)
+  {
+  }
+
+  PageHandle(PageHandle&& other);
+  PageHandle& operator=(PageHandle&& other);
+  PageHandle(const PageHandle&) = delete;
+  PageHandle& operator=(const PageHandle&) = delete;
 
 	/**
-   * Number of frames in the buffer pool
+   * Unpins the page, if the handle holds one
 	 */
-  std::uint32_t numBufs;
-	
+  ~PageHandle();
+
 	/**
-   * Hash table mapping (File, page) to frame
+   * True if the handle holds a page
 	 */
-  BufHashTbl *hashTable;
+  explicit operator bool() const
+  {
+		return page != NULL;
+  }
 
 	/**
-   * Array of BufDesc objects to hold information corresponding to every frame allocation from 'bufPool' (the buffer pool)
+   * Read-only access to the page
 	 */
-  BufDesc *bufDescTable;
+  const Page* get() const
+  {
+		return page;
+  }
+
+  const Page* operator->() const
+  {
+		return page;
+  }
+
+  const Page& operator*() const
+  {
+		return *page;
+  }
 
 	/**
-   * Maintains Buffer pool usage statistics 
+   * Write access to the page. Marks the page dirty, so it is written back after the handle is released.
 	 */
-  BufStats bufStats;
+  Page* getMutable()
+  {
+		markDirty();
+		return page;
+  }
 
 	/**
-   * Advance clock to next frame in the buffer pool
+   * Marks the page dirty without accessing it
 	 */
-  void advanceClock();
+  void markDirty();
 
 	/**
-	 * Allocate a free frame.  
-	 *
-	 * @param frame   	Frame reference, frame ID of allocated frame returned via this variable
-	 * @throws BufferExceededException If no such buffer is found which can be allocated
+   * Write access for changes that are undone before the page may be written back, such as swizzled
+   * pointers. Optimistic readers are held off as with getMutable(), but the page is not marked dirty, so
+   * a page changed only through this is never written to disk.
 	 */
-  void allocBuf(FrameId & frame);
+  Page* getTransient();
 
- public:
 	/**
-   * Actual buffer pool from which frames are allocated
+   * Page number of the page in its file. Kept in the handle since callers may overwrite the page header.
 	 */
-  Page* bufPool;
+  PageId pageNo() const
+  {
+		return pageNumber;
+  }
 
 	/**
-   * Constructor of BufMgr class
+   * Frame of the buffer pool holding the page
 	 */
-  BufMgr(std::uint32_t bufs);
-	
+  FrameId frame() const
+  {
+		return frameNo;
+  }
+
 	/**
-   * Destructor of BufMgr class
+	 * Sets the hint passed to the replacement policy when the page is unpinned, see AccessHint.
 	 */
-  ~BufMgr();
+  void setHint(AccessHint hint)
+  {
+		accessHint = hint;
+  }
 
 	/**
-	 * Reads the given page from the file into a frame and returns the pointer to page.
-	 * If the requested page is already present in the buffer pool pointer to that frame is returned
-	 * otherwise a new frame is allocated from the buffer pool for reading the page.
+	 * Unpins the page before the handle goes out of scope. The handle is empty afterwards.
 	 *
-	 * @param file   	File object
-	 * @param PageNo  Page number in the file to be read
-	 * @param page  	Reference to page pointer. Used to fetch the Page object in which requested page from file is read in.
+   * @throws  PageNotPinnedException If the page was unpinned behind the handle's back
 	 */
-  void readPage(File* file, const PageId PageNo, Page*& page);
+  void release();
 
+ private:
 	/**
-	 * Unpin a page from memory since it is no longer required for it to remain in memory.
-	 *
-	 * @param file   	File object
-	 * @param PageNo  Page number
-	 * @param dirty		True if the page to be unpinned needs to be marked dirty	
-   * @throws  PageNotPinnedException If the page is not already pinned
+   * Constructs a handle for a frame that was just pinned by the buffer manager
 	 */
-  void unPinPage(File* file, const PageId PageNo, const bool dirty);
+  PageHandle(BufMgr* mgr, FrameId frame, PageId pageNo, Page* page)
+		: bufMgr(mgr), frameNo(frame), pageNumber(pageNo), page(page), dirty(false), writing(false),
+		  accessHint(NORMAL)
+  {
+  }
 
 	/**
-	 * Allocates a new, empty page in the file and returns the Page object.
-	 * The newly allocated page is also assigned a frame in the buffer pool.
-	 *
-	 * @param file   	File object
-	 * @param PageNo  Page number. The number assigned to the page in the file is returned via this reference.
-	 * @param page  	Reference to page pointer. The newly allocated in-memory Page object is returned via this reference.
+   * Buffer manager the page is pinned in, NULL for an empty handle
 	 */
-  void allocPage(File* file, PageId &PageNo, Page*& page); 
+  BufMgr* bufMgr;
 
 	/**
-	 * Writes out all dirty pages of the file to disk.
-	 * All the frames assigned to the file need to be unpinned from buffer pool before this function can be successfully called.
-	 * Otherwise Error returned.
-	 *
-	 * @param file   	File object
-   * @throws  PagePinnedException If any page of the file is pinned in the buffer pool 
-   * @throws BadBufferException If any frame allocated to the file is found to be invalid
+   * Frame holding the page
 	 */
-  void flushFile(const File* file);
+  FrameId frameNo;
 
 	/**
-	 * Delete page from file and also from buffer pool if present.
-	 * Since the page is entirely deleted from file, its unnecessary to see if the page is dirty.
-	 *
-	 * @param file   	File object
-	 * @param PageNo  Page number
+   * Page number of the page in its file
 	 */
-  void disposePage(File* file, const PageId PageNo);
+  PageId pageNumber;
 
 	/**
-   * Print member variable values. 
+   * The pinned page
 	 */
-  void  printSelf();
+  Page* page;
+
+	/**
+   * Whether the page was written to through getMutable(), and has to be written back
+	 */
+  bool dirty;
+
+	/**
+   * Whether the handle announced itself as a writer. Optimistic readers are held off from the first
+   * write until the handle is released.
+	 */
+  bool writing;
+
+	/**
+   * Hint passed on when the page is unpinned
+	 */
+  AccessHint accessHint;
+};
+
+
+/**
+* @brief Receives the page of a BufMgr::readPageAsync() call: a handle holding the page, or an empty
+* handle and the exception the read threw.
+*/
+typedef std::function<void(PageHandle page, std::exception_ptr error)> PageCallback;
+
+
+/**
+* @brief A page queued for background loading by BufMgr::prefetch() or BufMgr::readPageAsync()
+*/
+struct PrefetchRequest
+{
+	/**
+   * File the page belongs to
+	 */
+  File* file;
+
+	/**
+   * Page number within the file
+	 */
+  PageId pageNo;
+
+	/**
+   * Receives the pinned page of a readPageAsync() call; empty for a prefetch, which leaves the page unpinned
+	 */
+  PageCallback done;
+};
+
+
+/**
+* @brief A dirty page evicted by BufMgr::allocBuf(), copied out of its frame so that the frame can take the
+* new page at once while the page is written back without the partition latch
+*/
+struct EvictedPage
+{
+	/**
+   * File the page belongs to; NULL if no page was evicted dirty
+	 */
+  File* file;
 
 	/**
-   * Get buffer pool usage statistics
+   * Copy of the page
 	 */
-  BufStats & getBufStats()
+  std::unique_ptr<Page> page;
+
+  EvictedPage()
+		: file(NULL)
   {
-		return bufStats;
   }
+};
+
+
+/**
+* @brief Receives notice of pages of a file leaving the buffer pool, see BufMgr::setEvictionListener()
+*/
+class BufEvictionListener
+{
+ public:
+  virtual ~BufEvictionListener() {}
+
+	/**
+	 * Called when a page leaves its frame: when it is evicted, flushed by flushFile(), disposed of or given up
+	 * by resize(). The frame no longer holds the page once the call returns. Called with partition latches
+	 * held, possibly from another thread, so it must be quick and must not call back into the BufMgr.
+	 *
+	 * @param file   	File the page belongs to
+	 * @param pageNo  Page number in the file
+	 * @param frame   	Frame the page was in
+	 */
+  virtual void pageEvicted(const File* file, PageId pageNo, FrameId frame) = 0;
+};
+
+
+/**
+* @brief State of an optimistic read of a page, see BufMgr::readOptimistic()
+*/
+struct OptimisticRead
+{
+	/**
+   * Marks an unknown frame
+	 */
+  static const FrameId NO_FRAME = 0xFFFFFFFF;
+
+	/**
+   * Frame the page was found in. Callers that read the same page repeatedly keep it and pass it back
+   * in as a hint, which lets the next read skip the hash table and the partition latch.
+	 */
+  FrameId frame;
+
+	/**
+   * Version of the frame when the read started
+	 */
+  std::uint64_t version;
+
+	/**
+   * The page. Its contents may change at any time and are only trustworthy once BufMgr::validate()
+   * has succeeded.
+	 */
+  const Page* page;
 
 	/**
-   * Clear buffer pool usage statistics
+   * Constructor of OptimisticRead class
+	 *
+	 * @param hint 	Frame the page was found in last time, if known
 	 */
-  void clearBufStats() 
+  OptimisticRead(FrameId hint = NO_FRAME)
+		: frame(hint), version(0), page(NULL)
   {
-		bufStats.clear();
   }
 };
 
+
+/**
+* @brief One shard of the buffer pool. A partition owns a contiguous range of frames, the hash table
+* for the pages that map to it and its own replacement policy, all guarded by a single latch so that
+* threads working on pages of different partitions do not contend with each other.
+*/
+struct BufPartition
+{
+	/**
+   * Latch protecting every member of this partition and the descriptors of its frames. Not held while
+   * pages are read into frames or evicted pages written back, see BufDesc::loading and pendingWrites.
+	 */
+  std::mutex latch;
+
+	/**
+   * Signalled when a read of a loading frame or the write-back of a page in pendingWrites completes
+	 */
+  std::condition_variable ioDone;
+
+	/**
+   * Pages evicted dirty whose write-back is still under way. They are not resident; loads of them wait on
+   * ioDone until the write is done, so that the disk is not read before it has the last version.
+	 */
+  std::unordered_set<PageKey, PageKeyHash> pendingWrites;
+
+	/**
+   * Hash table mapping (File, page) to frame for pages that belong to this partition
+	 */
+  BufHashTbl *hashTable;
+
+	/**
+   * First frame of the buffer pool owned by this partition
+	 */
+  FrameId firstFrame;
+
+	/**
+   * Number of frames owned by this partition, the frames [firstFrame, firstFrame + numFrames)
+	 */
+  std::uint32_t numFrames;
+
+	/**
+   * Number of frames reserved for this partition, the most BufMgr::resize() can grow it to
+	 */
+  std::uint32_t maxFrames;
+
+	/**
+   * Replacement policy choosing which frame of this partition gets reused
+	 */
+  ReplacementPolicy *policy;
+
+	/**
+   * Compressed copies of clean pages evicted from this partition, NULL unless BufMgr::setVictimCacheSize()
+   * enabled the tier
+	 */
+  VictimCache *victimCache;
+
+	/**
+   * Estimates the hit ratio of the partition at other sizes
+	 */
+  MrcEstimator *mrc;
+
+	/**
+   * Rates pages read on a miss against the victim of the replacement policy, NULL unless
+   * BufMgr::setAdmissionFilter() enabled it
+	 */
+  AdmissionFilter *admission;
+
+	/**
+   * Frames holding the pages the admission filter turned away, and the page each was loaded with. Pages
+   * turned away later reuse these frames round robin, so they displace one another instead of the pages
+   * read more often. Empty unless the filter is on.
+	 */
+  std::vector<std::pair<FrameId, PageKey> > probation;
+
+	/**
+   * Slot of probation that the next page turned away replaces
+	 */
+  std::uint32_t nextProbation;
+
+	/**
+   * First frame of the list of frames holding pages of each file, linked through BufDesc::nextInFile.
+   * Files without a page in this partition have no entry.
+	 */
+  std::unordered_map<const File*, FrameId> fileFrames;
+
+	/**
+   * Buffer usage statistics of this partition
+	 */
+  BufStats bufStats;
+
+	/**
+   * Buffer usage statistics of the pages of each file that belong to this partition, by file name.
+   * The entry of a file with pages in the partition is never removed, so BufDesc::fileStats stays valid;
+   * entries of files whose pages have all left are dropped by BufMgr::pruneFileStats().
+	 */
+  std::unordered_map<std::string, BufStats> statsByFile;
+};
+
+
+/**
+* @brief The central class which manages the buffer pool including frame allocation and deallocation to pages in the file 
+*
+* The pool is split into partitions (see BufPartition). All public methods are threadsafe; a page is
+* always handled by the partition it hashes to, so only requests for pages of the same partition serialize.
+*/
+class BufMgr 
+{
+	friend class PageHandle;
+
+ private:
+	/**
+   * Number of frames in the buffer pool
+	 */
+  std::uint32_t numBufs;
+
+	/**
+   * Number of frames address space and descriptors are reserved for, the most the pool can grow to
+	 */
+  std::uint32_t maxBufs;
+
+	/**
+   * Serializes calls to resize(). Always acquired before a partition latch.
+	 */
+  std::mutex resizeLatch;
+
+	/**
+   * Alignment of the frame arena; frames start on virtual memory page boundaries so they can be used for direct I/O
+	 */
+  static const std::size_t ARENA_ALIGNMENT = 4096;
+
+	/**
+   * Alignment of the frame arena when transparent huge pages are requested
+	 */
+  static const std::size_t HUGE_PAGE_SIZE = 2 * 1024 * 1024;
+
+	/**
+   * Start and size in bytes of the address space reservation holding the arena. Only the frames of
+   * the partitions are backed by memory; the rest of the reservation is inaccessible.
+	 */
+  void* arena;
+  std::size_t arenaBytes;
+
+	/**
+   * Number of independently latched partitions the buffer pool is split into
+	 */
+  std::uint32_t numPartitions;
+
+	/**
+   * Array of partitions, each one owning a range of frames and a hash table
+	 */
+  BufPartition *partitions;
+
+	/**
+   * Number of I/O latches, see ioLatchOf()
+	 */
+  static const std::size_t IO_LATCHES = 16;
+
+	/**
+   * Serialize calls into File objects, which are not threadsafe. A file is guarded by one of them, picked
+   * by its name, as File objects of the same name share a stream. Acquired after a partition latch if
+   * one is held; no partition latch is acquired while holding one.
+	 */
+  std::mutex ioLatches[IO_LATCHES];
+
+	/**
+   * Array of BufDesc objects to hold information corresponding to every frame allocation from 'bufPool' (the buffer pool)
+	 */
+  BufDesc *bufDescTable;
+
+	/**
+   * Background thread writing back dirty, unpinned frames
+	 */
+  std::thread flusher;
+
+	/**
+   * Protects flusherRunning and flusherConfig
+	 */
+  std::mutex flusherLatch;
+
+	/**
+   * Wakes the flusher up early when an eviction stalled, or when it has to stop
+	 */
+  std::condition_variable flusherWakeup;
+
+	/**
+   * True while the flusher thread should keep running
+	 */
+  bool flusherRunning;
+
+	/**
+   * Watermarks and interval of the flusher
+	 */
+  BufFlusherConfig flusherConfig;
+
+	/**
+   * Listeners registered with setEvictionListener(), by file. Protected by listenerLatch, which is
+   * always acquired after partition latches; numListeners lets evictions skip the latch while there are none.
+	 */
+  std::unordered_map<const File*, BufEvictionListener*> evictionListeners;
+  std::mutex listenerLatch;
+  std::atomic<std::uint32_t> numListeners;
+
+	/**
+   * Trace being recorded, NULL if none. Protected by traceLatch, which is always acquired after partition
+   * latches; tracing lets calls skip the latch while there is no trace.
+	 */
+  BufTraceWriter* tracer;
+  std::mutex traceLatch;
+  std::atomic<bool> tracing;
+
+	/**
+   * Most pages readPages() reads and discards between two misses to read them with one I/O
+	 */
+  static const PageId MAX_COALESCED_GAP = 3;
+
+	/**
+   * Share of the frames of a partition that pages turned away by the admission filter may occupy, as a divisor
+	 */
+  static const std::uint32_t PROBATION_SHARE = 32;
+
+	/**
+   * Entries of files without pages a partition keeps in statsByFile beyond the number of files with pages
+	 */
+  static const std::size_t IDLE_FILE_STATS = 16;
+
+	/**
+   * Number of I/O worker threads started by the first call to prefetch()
+	 */
+  static const unsigned int PREFETCH_THREADS = 2;
+
+	/**
+   * I/O worker threads loading prefetched pages
+	 */
+  std::vector<std::thread> prefetchWorkers;
+
+	/**
+   * Protects the prefetch queue, prefetchBusy and prefetchRunning
+	 */
+  std::mutex prefetchLatch;
+
+	/**
+   * Signalled when requests are queued or the workers have to stop
+	 */
+  std::condition_variable prefetchReady;
+
+	/**
+   * Signalled whenever a worker finishes a request
+	 */
+  std::condition_variable prefetchDone;
+
+	/**
+   * Pages waiting to be loaded, oldest first
+	 */
+  std::deque<PrefetchRequest> prefetchQueue;
+
+	/**
+   * Files of the requests the workers are loading right now
+	 */
+  std::multiset<const File*> prefetchBusy;
+
+	/**
+   * True while the worker threads should keep running
+	 */
+  bool prefetchRunning;
+
+	/**
+	 * Main loop of an I/O worker thread.
+	 */
+  void prefetchLoop();
+
+	/**
+	 * Starts the I/O workers unless they are running. Caller must hold prefetchLatch.
+	 */
+  void startPrefetchWorkers();
+
+	/**
+	 * Drops queued prefetch requests for a file and waits for its readPageAsync() requests and for those
+	 * being loaded, so the file can be flushed and closed safely.
+	 *
+	 * @param file   	File object
+	 */
+  void cancelPrefetch(const File* file);
+
+	/**
+	 * Reads a page that is not in the buffer pool into a newly allocated frame of its partition and
+	 * registers it in the hash table and replacement policy. The frame is returned pinned once.
+	 *
+	 * The partition latch is released for the disk I/O, the write-back of a dirty victim included, and
+	 * the frame is marked loading meanwhile. The page must be neither resident nor in pendingWrites.
+	 *
+	 * @param part   	Partition the page belongs to
+	 * @param guard  	Holds the partition latch, on return as well
+	 * @param file   	File object
+	 * @param pageNo  Page number in the file
+	 * @return  			Frame now holding the page.
+	 * @throws BufferExceededException If every frame of the partition is pinned
+	 */
+  FrameId loadPage(BufPartition & part, std::unique_lock<std::mutex> & guard, File* file, const PageId pageNo,
+                   BufferAccessStrategy* strategy = NULL);
+
+	/**
+	 * Registers a page just read into a newly allocated frame in the hash table, the file's frame list
+	 * and the replacement policy. The frame is left pinned once. Caller must hold the partition latch.
+	 */
+  void installPage(BufPartition & part, FrameId frameNo, File* file, const PageId pageNo);
+
+	/**
+	 * Pins a list of pages like readPages(), unpinning the pages pinned so far if an exception is thrown.
+	 *
+	 * @param frames  	Frames of the pages, one per page number, returned via this variable
+	 */
+  void pinPages(File* file, const std::vector<PageId> & pageNos, std::vector<FrameId> & frames);
+
+	/**
+	 * Loads a run of missing pages of a file with one read, pinning each once. The partitions of the
+	 * pages are latched in partition order, and released for the I/O as in loadPage(). Pages loaded by
+	 * another thread in the meantime are pinned as they are; pages another thread is still reading or
+	 * writing back are skipped and left to the caller.
+	 *
+	 * @param file   	File object
+	 * @param pageNos	Sorted, distinct page numbers, with at most MAX_COALESCED_GAP pages between two
+	 *               	and spanning at most File::MAX_READ_RUN pages
+	 * @param loaded  Frames of the pages are added to this map, even if an exception is thrown
+	 * @param demand  False for pages loaded ahead of use, as by warmUp(): they count as disk reads but not
+	 *               	as accesses or misses, and pages found resident are skipped rather than pinned
+	 */
+  void loadRun(File* file, const std::vector<PageId> & pageNos, std::unordered_map<PageId, FrameId> & loaded,
+               const bool demand = true);
+
+	/**
+	 * Takes the frame in the current slot of a strategy's ring for reuse, if it still holds the page the
+	 * strategy loaded into it and is neither pinned nor dirty. Caller must hold the partition latch.
+	 *
+	 * @param part   	Partition the new page belongs to
+	 * @param strategy Access strategy of the caller
+	 * @param frame   	Frame ID of the reclaimed frame returned via this variable
+	 * @return  			True if a frame was reclaimed.
+	 */
+  bool reclaimRingFrame(BufPartition & part, BufferAccessStrategy & strategy, FrameId & frame);
+
+	/**
+	 * Main loop of the flusher thread.
+	 */
+  void flusherLoop();
+
+	/**
+	 * Saves a manifest for the flusher, which has no caller to report a failure to; the manifest is only
+	 * a hint, so a failure just leaves the previous one in place.
+	 *
+	 * @param path   	Name of the manifest file
+	 */
+  void saveManifestQuietly(const std::string & path);
+
+	/**
+	 * Reads a page that is not resident into a frame and leaves it unpinned, as done for prefetched
+	 * pages. Takes the partition latch.
+	 *
+	 * @param file   	File object
+	 * @param pageNo  Page number in the file
+	 * @return  			False if the page was resident already, does not exist or found every frame of its
+	 *              	partition pinned.
+	 */
+  bool loadUnpinned(File* file, const PageId pageNo);
+
+	/**
+	 * Writes back dirty, unpinned frames of a partition if it is below the low watermark of clean frames,
+	 * until it reaches the high watermark. Frames that were not referenced recently are cleaned first,
+	 * since they are the next ones the replacement policy will look at.
+	 *
+	 * @param part   	Partition to clean
+	 * @param config 	Watermarks to apply
+	 */
+  void cleanPartition(BufPartition & part, const BufFlusherConfig & config);
+
+	/**
+	 * Returns the partition responsible for the given page of the file.
+	 *
+	 * @param file   	File object
+	 * @param pageNo  Page number in the file
+	 * @return  			Partition owning the page.
+	 */
+  BufPartition & partitionOf(const File* file, const PageId pageNo);
+
+	/**
+	 * Returns the partition owning the given frame.
+	 *
+	 * @param frame   	Frame ID
+	 * @return  			Partition owning the frame.
+	 */
+  BufPartition & partitionOfFrame(const FrameId frame);
+
+	/**
+	 * Pins the given page, reading it into a frame if it is not resident. Shared by both forms of readPage().
+	 *
+	 * @param file   	File object
+	 * @param pageNo  Page number in the file
+	 * @param strategy Optional access strategy of the caller
+	 * @return  			Frame holding the page.
+	 */
+  FrameId pinPage(File* file, const PageId pageNo, BufferAccessStrategy* strategy);
+
+	/**
+	 * Allocates a new page in the file and pins it in a frame. Shared by both forms of allocPage().
+	 *
+	 * @param file   	File object
+	 * @param pageNo  Page number assigned to the new page returned via this variable
+	 * @return  			Frame holding the page.
+	 */
+  FrameId pinNewPage(File* file, PageId & pageNo);
+
+	/**
+	 * Pins a resident page whose frame is known and counts the hit. Caller must hold the partition latch.
+	 *
+	 * @param part   	Partition owning the frame
+	 * @param frame   	Frame holding the page
+	 */
+  void pinResident(BufPartition & part, const FrameId frame);
+
+	/**
+	 * Drops one pin of a frame, as done by PageHandle. Unlike unPinPage() this needs no hash table lookup.
+	 *
+	 * @param frame   	Frame holding the pinned page
+	 * @param dirty		True if the page needs to be marked dirty
+	 * @param writing	True if the caller announced itself as a writer with beginWrite()
+	 * @param hint		What the caller expects of the page
+   * @throws  PageNotPinnedException If the frame is not pinned
+	 */
+  void unPinFrame(const FrameId frame, const bool dirty, const bool writing = false, AccessHint hint = NORMAL);
+
+	/**
+	 * Announces a writer of a pinned frame to optimistic readers, as done by PageHandle. unPinFrame()
+	 * retires the writer when called with writing set.
+	 *
+	 * @param frame   	Frame holding the pinned page
+	 */
+  void beginWrite(const FrameId frame);
+
+	/**
+	 * Allocate a free frame from the given partition. Caller must hold the partition latch.
+	 *
+	 * If the admission filter of the partition is on and rates the page read below the victim, the page
+	 * gets a frame of the probationary area instead, and the victim stays.
+	 *
+	 * @param part   	Partition to allocate the frame from
+	 * @param frame   	Frame reference, frame ID of allocated frame returned via this variable
+	 * @param file   	File of the page read on a miss, or NULL for a new page, which is always admitted
+	 * @param pageNo  Page number of the page read on a miss
+	 * @param evicted	If not NULL, a dirty victim is not written back here but copied into this variable and
+	 *               	added to pendingWrites; the caller passes it to writeEvicted() once it has released
+	 *               	the partition latch. If NULL, the victim is written back with the latch held.
+	 * @throws BufferExceededException If no such buffer is found which can be allocated
+	 */
+  void allocBuf(BufPartition & part, FrameId & frame, File* file = NULL, const PageId pageNo = 0,
+                EvictedPage* evicted = NULL);
+
+	/**
+	 * Writes back a page evicted by allocBuf(), removes it from pendingWrites and wakes the threads
+	 * waiting for it. Does nothing if no page was evicted dirty. Caller must not hold the partition latch.
+	 *
+	 * @param part   	Partition the page belongs to
+	 * @param evicted	The evicted page
+	 */
+  void writeEvicted(BufPartition & part, EvictedPage & evicted);
+
+	/**
+	 * Latches every partition, in partition order, at a moment when no page of the given file is in the
+	 * pendingWrites of any of them, so that the caller sees every page of the file written back.
+	 *
+	 * @param file   	File object, or NULL for all files
+	 */
+  void lockPartitions(const File* file);
+
+	/**
+	 * Returns the I/O latch guarding a file, see ioLatches.
+	 *
+	 * @param file   	File object
+	 * @return  			Latch to hold while calling into the file.
+	 */
+  std::mutex & ioLatchOf(const File* file);
+
+	/**
+	 * Takes a frame holding a page for immediate reuse without asking the replacement policy, if the frame
+	 * still holds the given page and the page is neither pinned nor dirty. Caller must hold the partition
+	 * latch.
+	 *
+	 * @param part   	Partition owning the frame
+	 * @param frame   	Frame to take
+	 * @param page   	Page the frame is expected to hold
+	 * @return  			True if the frame was taken.
+	 */
+  bool reclaimFrame(BufPartition & part, FrameId frame, const PageKey & page);
+
+	/**
+	 * Writes back the dirty page in a frame, marks it clean and counts the write in the statistics of the
+	 * partition and the file. Caller must hold the partition latch, which stays held for the write.
+	 *
+	 * @param part   	Partition owning the frame
+	 * @param frame   	Dirty frame to write back
+	 */
+  void writeFrame(BufPartition & part, FrameId frame);
+
+	/**
+	 * Pins the given page if it is resident, like a readPage() hit.
+	 *
+	 * @return  			False if the page is not resident.
+	 */
+  bool pinIfResident(File* file, const PageId pageNo, FrameId& frameNo);
+
+	/**
+	 * Counts a readPage() or allocPage() call in the statistics of the partition and the file.
+	 *
+	 * @param part   	Partition owning the frame
+	 * @param desc   	Descriptor of the frame handed out
+	 * @param waited 	Whether the call had to wait for the partition latch
+	 */
+  void countAccess(BufPartition & part, BufDesc & desc, bool waited);
+
+	/**
+	 * Appends a call to the trace, if one is being recorded. Called with the partition latch of the page held,
+	 * so the calls on each page are recorded in the order they were made.
+	 */
+  void trace(BufTraceOp op, const File* file, PageId pageNo);
+
+	/**
+	 * Writes back a batch of dirty frames and marks them clean. The frames are sorted by file and page
+	 * number and handed to File::writePages() once per file, so adjacent pages go out in a single write.
+	 * Caller must hold the latches of the partitions owning the frames.
+	 *
+	 * @param frames 	Dirty frames to write back, in any order
+	 */
+  void writeFrames(std::vector<FrameId> & frames);
+
+	/**
+	 * Adds a frame that was just Set() to the frame list of its file and attaches the statistics of the
+	 * file. Caller must hold the partition latch.
+	 *
+	 * @param part   	Partition owning the frame
+	 * @param frame   	Frame now holding a page
+	 */
+  void linkFrame(BufPartition & part, FrameId frame);
+
+	/**
+	 * Removes a frame from the frame list of its file and tells the eviction listener of the file, if any;
+	 * call before Clear(). Caller must hold the partition latch.
+	 *
+	 * @param part   	Partition owning the frame
+	 * @param frame   	Frame about to be cleared
+	 */
+  void unlinkFrame(BufPartition & part, FrameId frame);
+
+	/**
+	 * Drops the statistics of the files that have no page left in a partition. Caller must hold the
+	 * partition latch.
+	 *
+	 * @param part   	Partition to prune
+	 */
+  void pruneFileStats(BufPartition & part);
+
+	/**
+	 * Backs a range of frames of the arena with zeroed memory.
+	 *
+	 * @param first   First frame of the range
+	 * @param count   Number of frames
+	 * @throws std::bad_alloc If the memory cannot be committed
+	 */
+  void commitFrames(FrameId first, std::uint32_t count);
+
+	/**
+	 * Returns the memory of a range of frames to the operating system. The frames must hold no page.
+	 *
+	 * @param first   First frame of the range
+	 * @param count   Number of frames
+	 */
+  void releaseFrames(FrameId first, std::uint32_t count);
+
+	/**
+	 * Grows or shrinks a partition towards the given number of frames. Shrinking moves the pages in the
+	 * frames given up into free frames below the target, writes back and evicts those that find none,
+	 * and stops early at a pinned frame. Takes the partition latch.
+	 *
+	 * @param part   	Partition to resize
+	 * @param target 	Number of frames wanted, between 1 and part.maxFrames
+	 * @return  			Number of frames of the partition afterwards.
+	 */
+  std::uint32_t resizePartition(BufPartition & part, std::uint32_t target);
+
+ public:
+	/**
+   * Actual buffer pool from which frames are allocated. All frames live in one page-aligned arena,
+   * frame i at byte offset i * Page::SIZE. Each partition has a range of maxFrames frames reserved,
+   * of which the first numFrames are in use; the arena never moves when the pool is resized.
+	 */
+  Page* bufPool;
+
+	/**
+   * Constructor of BufMgr class
+	 *
+	 * @param bufs   	Number of frames in the buffer pool
+	 * @param parts  	Number of partitions the frames and hash table are split into. More partitions let
+	 *              	concurrent requests for different pages proceed in parallel. Clamped to [1, bufs].
+	 *              	A page always goes to the partition its hash picks, so that a lookup only latches
+	 *              	one partition. The price is that a partition whose frames are all pinned throws
+	 *              	BufferExceededException while other partitions still have free frames: with many
+	 *              	partitions, keep the number of pages pinned at once well below bufs / parts.
+	 * @param policy 	Replacement policy used by every partition
+	 * @param hugePages	If true, align the frame arena to huge pages and ask the kernel to back it with
+	 *              	transparent huge pages, reducing TLB misses for large pools
+	 * @param maxBufs	Largest size resize() may grow the pool to. Only address space is reserved for it up front.
+	 *              	Values below bufs, such as the default, mean the pool can only shrink.
+	 */
+  BufMgr(std::uint32_t bufs, std::uint32_t parts = 1, ReplacementPolicyType policy = CLOCK, bool hugePages = false,
+         std::uint32_t maxBufs = 0);
+	
+	/**
+   * Destructor of BufMgr class
+	 */
+  ~BufMgr();
+
+	/**
+	 * Reads the given page from the file into a frame and returns the pointer to page.
+	 * If the requested page is already present in the buffer pool pointer to that frame is returned
+	 * otherwise a new frame is allocated from the buffer pool for reading the page.
+	 *
+	 * @param file   	File object
+	 * @param PageNo  Page number in the file to be read
+	 * @param page  	Reference to page pointer. Used to fetch the Page object in which requested page from file is read in.
+	 * @param strategy Optional access strategy; large sequential scans pass one to recycle a small ring of frames
+	 */
+  void readPage(File* file, const PageId PageNo, Page*& page, BufferAccessStrategy* strategy = NULL);
+
+	/**
+	 * Reads the given page like readPage() above, but returns a handle that unpins it when it goes out of scope.
+	 *
+	 * @param file   	File object
+	 * @param PageNo  Page number in the file to be read
+	 * @param strategy Optional access strategy; large sequential scans pass one to recycle a small ring of frames
+	 * @return  			Handle holding the pinned page.
+	 */
+  PageHandle readPage(File* file, const PageId PageNo, BufferAccessStrategy* strategy = NULL);
+
+	/**
+	 * Reads and pins a list of pages, such as the pages of the records an index scan returned, with
+	 * fewer I/Os than reading them one by one. The resident pages are pinned in one pass; the others are
+	 * sorted, each read once however often it is listed, and neighbouring ones are read together in runs
+	 * of up to File::MAX_READ_RUN pages. A page listed several times is pinned once per entry, and each
+	 * pin has to be released with unPinPage().
+	 *
+	 * @param file   	File object
+	 * @param pageNos	Page numbers in the file, in any order
+	 * @param pages  	Pointers to the pages, one per page number, returned via this variable
+	 * @throws InvalidPageException If a page does not exist; no page is left pinned
+	 * @throws BufferExceededException If the pages do not fit the pool; no page is left pinned
+	 */
+  void readPages(File* file, const std::vector<PageId> & pageNos, std::vector<Page*> & pages);
+
+	/**
+	 * Reads a list of pages like readPages() above, but returns handles that unpin them.
+	 *
+	 * @param file   	File object
+	 * @param pageNos	Page numbers in the file, in any order
+	 * @return  			Handles holding the pinned pages, one per page number.
+	 */
+  std::vector<PageHandle> readPages(File* file, const std::vector<PageId> & pageNos);
+
+	/**
+	 * Reads the given page without blocking on the disk. A resident page is pinned and passed to the
+	 * callback before the call returns. Otherwise the read is queued for the I/O workers that load
+	 * prefetched pages, and the call returns at once; a worker reads the page like readPage() and calls
+	 * the callback on its own thread. AsyncPageScheduler runs the callbacks on a thread of the caller's
+	 * choosing instead, so that one thread can keep many reads outstanding. There are only
+	 * PREFETCH_THREADS workers, so at most that many misses are read from disk at a time however many are
+	 * outstanding, and reads of the same file are serialized on its I/O latch (see ioLatchOf()).
+	 *
+	 * @param file   	File object
+	 * @param pageNo  Page number
+	 * @param done   	Receives the page or the exception thrown while reading it; must not throw
+	 */
+  void readPageAsync(File* file, const PageId pageNo, PageCallback done);
+
+	/**
+	 * Reads the given page like readPage(), starting from the frame it was last seen in. If the frame still
+	 * holds the page, the page is pinned without a hash table lookup; otherwise this is a plain readPage().
+	 * Used to follow references that remember frames, such as swizzled pointers.
+	 *
+	 * @param file   	File object
+	 * @param pageNo  Page number in the file to be read
+	 * @param frame   	Frame the page was last seen in
+	 * @return  			Handle holding the pinned page.
+	 */
+  PageHandle readPageHinted(File* file, const PageId pageNo, const FrameId frame);
+
+	/**
+	 * Unpin a page from memory since it is no longer required for it to remain in memory.
+	 *
+	 * @param file   	File object
+	 * @param PageNo  Page number
+	 * @param dirty		True if the page to be unpinned needs to be marked dirty	
+	 * @param hint		What the caller expects of the page, passed on to the replacement policy
+   * @throws  PageNotPinnedException If the page is not already pinned
+	 */
+  void unPinPage(File* file, const PageId PageNo, const bool dirty, AccessHint hint = NORMAL);
+
+	/**
+	 * Allocates a new, empty page in the file and returns the Page object.
+	 * The newly allocated page is also assigned a frame in the buffer pool.
+	 *
+	 * @param file   	File object
+	 * @param PageNo  Page number. The number assigned to the page in the file is returned via this reference.
+	 * @param page  	Reference to page pointer. The newly allocated in-memory Page object is returned via this reference.
+	 */
+  void allocPage(File* file, PageId &PageNo, Page*& page); 
+
+	/**
+	 * Allocates a new, empty page like allocPage() above, but returns a handle that unpins it when it goes out
+	 * of scope.
+	 *
+	 * @param file   	File object
+	 * @param PageNo  Page number. The number assigned to the page in the file is returned via this reference.
+	 * @return  			Handle holding the pinned page.
+	 */
+  PageHandle allocPage(File* file, PageId &PageNo);
+
+	/**
+	 * Writes out all dirty pages of the file to disk.
+	 * All the frames assigned to the file need to be unpinned from buffer pool before this function can be successfully called.
+	 * Otherwise Error returned. Pending prefetch requests for the file are dropped.
+	 *
+	 * @param file   	File object
+   * @throws  PagePinnedException If any page of the file is pinned in the buffer pool 
+   * @throws BadBufferException If any frame allocated to the file is found to be invalid
+	 */
+  void flushFile(const File* file);
+
+	/**
+	 * Writes back every dirty, unpinned page in the buffer pool as one batch. The pages stay resident.
+	 * All partitions are latched for the duration so the batch can coalesce adjacent pages across them.
+	 */
+  void checkpoint();
+
+	/**
+	 * Delete page from file and also from buffer pool if present.
+	 * Since the page is entirely deleted from file, its unnecessary to see if the page is dirty.
+	 *
+	 * @param file   	File object
+	 * @param PageNo  Page number
+	 */
+  void disposePage(File* file, const PageId PageNo);
+
+	/**
+	 * Starts a background thread that keeps a share of every partition clean, so that evictions rarely
+	 * have to write a dirty page on the caller's critical path. Restarts the thread if it is running.
+	 *
+	 * @param config 	Watermarks and interval of the flusher
+	 */
+  void startFlusher(const BufFlusherConfig & config = BufFlusherConfig());
+
+	/**
+	 * Stops the background flusher and waits for it to exit. Does nothing if it is not running.
+	 */
+  void stopFlusher();
+
+	/**
+	 * Asks for pages to be read into the buffer pool in the background because they will be needed
+	 * soon. The pages are loaded unpinned by a pool of I/O worker threads; a later readPage() finds them
+	 * resident. Pages that are already resident, do not exist or find every frame pinned are skipped.
+	 * Returns immediately.
+	 *
+	 * @param file   	File object
+	 * @param firstPageNo  First page number of the range
+	 * @param numPages  	Number of consecutive pages to load
+	 */
+  void prefetch(File* file, const PageId firstPageNo, const PageId numPages = 1);
+
+	/**
+	 * Asks for a list of pages to be read into the buffer pool in the background.
+	 *
+	 * @param file   	File object
+	 * @param pageNos	Page numbers in the file
+	 */
+  void prefetch(File* file, const std::vector<PageId> & pageNos);
+
+	/**
+	 * Writes a manifest of the pages resident in the buffer pool, hottest first as ranked by the replacement
+	 * policy, so that warmUp() can load them again after a restart. Partitions are latched one at a time,
+	 * and the manifest interleaves their rankings. The flusher can save manifests periodically, see
+	 * BufFlusherConfig::manifestPath.
+	 *
+	 * @param path   	Name of the manifest file, which is replaced atomically
+	 * @return  			Number of pages in the manifest.
+	 * @throws BadManifestException If the file cannot be written
+	 */
+  std::size_t saveManifest(const std::string & path);
+
+	/**
+	 * Loads the pages listed in a manifest written by saveManifest(), typically before a restarted server
+	 * admits traffic. The hottest pages are taken, up to the size of the pool, and read in file and page
+	 * number order, neighbouring pages with one read as in readPages(). Pages are left unpinned. Pages
+	 * of files that are not passed in, pages that no longer exist and pages that find every frame of their
+	 * partition pinned are skipped.
+	 *
+	 * @param path   	Name of the manifest file
+	 * @param files  	Open files whose pages may be loaded, matched with the manifest by file name
+	 * @param background If true, the pages are queued for the prefetch workers and the call returns at once,
+	 *              	so the pool warms up while serving; otherwise it returns once they are loaded
+	 * @return  			Number of pages loaded, or queued if background is set.
+	 * @throws FileNotFoundException If there is no such manifest
+	 * @throws BadManifestException If the file is not a valid manifest
+	 */
+  std::size_t warmUp(const std::string & path, const std::vector<File*> & files, bool background = false);
+
+	/**
+	 * Grows or shrinks the buffer pool while it is in use. Partitions are resized one at a time under
+	 * their own latch, so other requests only wait for the partition being changed. Growing backs more
+	 * frames of the reserved arena with memory; shrinking gives up the frames at the end of each
+	 * partition and returns their memory. Unpinned pages in those frames move into free frames that stay,
+	 * and once there are none they are written back and evicted. A pinned page cannot move, so a pinned
+	 * frame stops the shrink of its partition there, however many frames below it are free: one long-lived
+	 * pin near the end of a partition keeps the partition at that size until it is released and resize()
+	 * is called again. The hash tables are rehashed incrementally by subsequent requests.
+	 *
+	 * @param bufs   	Number of frames wanted, clamped to [number of partitions, maxBufs]
+	 * @return  			Number of frames in the buffer pool afterwards, more than bufs if pinned frames
+	 *              	stopped a shrink short of its target.
+	 */
+  std::uint32_t resize(std::uint32_t bufs);
+
+	/**
+	 * Starts an optimistic read of a resident page: neither pins the page nor writes to memory shared
+	 * with other threads. The caller reads the page through read.page and then calls validate(); only if
+	 * that succeeds was what it read consistent, otherwise it starts over. If read.frame holds the page,
+	 * no latch is taken; otherwise the frame is looked up under the partition latch and stored in
+	 * read.frame for the next time. Optimistic reads are not counted in the statistics and do not
+	 * reference the page for the replacement policy.
+	 *
+	 * A pin taken through the Page* versions of readPage(), readPages() and allocPage() counts as a
+	 * writer from the pin to unPinPage(), since the caller may write through the pointer at any time:
+	 * optimistic reads of the page fail meanwhile. Pages read optimistically should be written through
+	 * PageHandle::getMutable(), which only announces a writer once the page is actually written.
+	 *
+	 * @param file   	File object
+	 * @param pageNo  Page number in the file
+	 * @param read   	Frame hint on input; frame, version and page of the read on output
+	 * @return  			False if the page is not resident or is being written; the caller falls back to readPage().
+	 */
+  bool readOptimistic(File* file, const PageId pageNo, OptimisticRead & read);
+
+	/**
+	 * Checks that the frame of an optimistic read still holds the same version of the page, i.e. that
+	 * nothing was written to it or loaded into it since readOptimistic().
+	 *
+	 * @param read   	Read started by readOptimistic()
+	 * @return  			True if everything read from read.page since then is consistent.
+	 */
+  bool validate(const OptimisticRead & read);
+
+	/**
+	 * Registers an object to be told whenever a page of the file leaves the buffer pool, so that it can drop
+	 * references to the frame it was in. A file has at most one listener.
+	 *
+	 * @param file   	File object
+	 * @param listener	Listener, or NULL to remove the current one
+	 */
+  void setEvictionListener(const File* file, BufEvictionListener* listener);
+
+	/**
+	 * Sets the highest fraction of pages whose reads are tracked to estimate the hit ratio at other pool
+	 * sizes (see BufStatsSnapshot::hitRatioCurve and MrcEstimator). Pools too small for the default rate
+	 * to sample enough pages can raise it at some cost per read. The estimates start over.
+	 *
+	 * @param rate   	Highest fraction of pages to sample, up to 1; 0 turns the estimates off
+	 */
+  void setHitRatioSampleRate(double rate);
+
+	/**
+	 * Starts recording every readPage(), allocPage(), unPinPage(), disposePage() and flushFile() call, and
+	 * every pin and release of a PageHandle, to a trace file (see BufTrace). Replaying the trace with BufSimulator shows
+	 * how the workload would fare with other pool sizes and replacement policies. A trace that is being
+	 * recorded is replaced.
+	 *
+	 * @param path   	Name of the trace file
+	 * @throws BadTraceException If the file cannot be created
+	 */
+  void startTrace(const std::string& path);
+
+	/**
+	 * Stops recording and closes the trace file. Does nothing if no trace is being recorded.
+	 *
+	 * @return  			Number of calls recorded.
+	 */
+  std::uint64_t stopTrace();
+
+	/**
+	 * Enables, resizes or disables the compressed victim cache, a second tier holding compressed copies of
+	 * clean pages evicted from the pool (see VictimCache). A readPage() miss that finds its page there
+	 * decompresses it instead of reading it from disk. Sparse pages compress well, so the tier holds many
+	 * more pages than frames of the same size would. Each partition gets an equal share of the bytes.
+	 *
+	 * @param bytes   Memory for compressed pages; 0 disables the tier and drops its pages
+	 */
+  void setVictimCacheSize(std::size_t bytes);
+
+	/**
+	 * Turns the admission filter on or off (see AdmissionFilter). With the filter on, a readPage() miss
+	 * only evicts the victim of the replacement policy if its page has been read more often lately than
+	 * the victim; otherwise the page is loaded into a small probationary area of each partition, where
+	 * such pages displace one another. A burst of pages read once, such as lookups of old records, then
+	 * leaves the pages read again and again in place. Pages allocated with allocPage() are always
+	 * admitted. Off by default.
+	 *
+	 * @param on     	Whether to filter
+	 */
+  void setAdmissionFilter(bool on);
+
+	/**
+   * Print member variable values. 
+	 */
+  void  printSelf();
+
+	/**
+   * Number of frames in the buffer pool, as last set by the constructor or resize()
+	 */
+  std::uint32_t getNumBufs();
+
+	/**
+   * Get buffer pool usage statistics, summed over all partitions
+	 */
+  BufStats getBufStats();
+
+	/**
+   * Get a copy of the statistics of the whole pool and of every file. Partitions are latched one at a
+   * time, so this can be called from a monitoring thread while the pool is in use.
+	 */
+  BufStatsSnapshot getStatsSnapshot();
+
+	/**
+   * Clear buffer pool usage statistics, and forget the files that have no page in the pool any more
+	 */
+  void clearBufStats();
+};
+
+inline void PageHandle::markDirty()
+{
+	getTransient();
+	dirty = true;
+}
+
+inline Page* PageHandle::getTransient()
+{
+	if (!writing) {
+		bufMgr->beginWrite(frameNo);
+		writing = true;
+	}
+	return page;
+}
+
 }
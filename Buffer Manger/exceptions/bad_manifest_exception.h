@@ -0,0 +1,41 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
+ */
+
+#pragma once
+
+#include <string>
+
+#include "badgerdb_exception.h"
+
+namespace badgerdb {
+
+/**
+ * @brief An exception that is thrown when a buffer pool manifest cannot be
+ *        written, or a file read as a manifest is not one.
+ */
+class BadManifestException : public BadgerDbException {
+ public:
+  /**
+   * Constructs a bad manifest exception for the given manifest file.
+   *
+   * @param name  Name of the manifest file.
+   */
+  explicit BadManifestException(const std::string& name);
+
+  /**
+   * Returns the name of the manifest file that caused this exception.
+   */
+  virtual const std::string& name() const { return name_; }
+
+ protected:
+  /**
+   * Name of the manifest file that caused this exception.
+   */
+  const std::string name_;
+};
+
+}
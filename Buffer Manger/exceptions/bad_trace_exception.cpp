@@ -0,0 +1,22 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
+ */
+
+#include "bad_trace_exception.h"
+
+#include <sstream>
+#include <string>
+
+namespace badgerdb {
+
+BadTraceException::BadTraceException(const std::string& name)
+    : BadgerDbException(""), name_(name) {
+  std::stringstream ss;
+  ss << "Bad buffer trace: " << name_;
+  message_.assign(ss.str());
+}
+
+}
@@ -0,0 +1,41 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
+ */
+
+#pragma once
+
+#include <string>
+
+#include "badgerdb_exception.h"
+
+namespace badgerdb {
+
+/**
+ * @brief An exception that is thrown when a buffer pool is created with a name
+ *        that another pool already has.
+ */
+class PoolExistsException : public BadgerDbException {
+ public:
+  /**
+   * Constructs a pool exists exception for the given name.
+   *
+   * @param name  Name of the pool that already exists.
+   */
+  explicit PoolExistsException(const std::string& name);
+
+  /**
+   * Returns the name that caused this exception.
+   */
+  virtual const std::string& name() const { return name_; }
+
+ protected:
+  /**
+   * Name that caused this exception.
+   */
+  const std::string name_;
+};
+
+}
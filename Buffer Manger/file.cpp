@@ -13,6 +13,8 @@
 #include <string>
 #include <cstdio>
 #include <cassert>
+#include <cstring>
+#include <algorithm>
 
 #include "exceptions/file_exists_exception.h"
 #include "exceptions/file_not_found_exception.h"
@@ -154,16 +156,68 @@ Page File::readPage(const PageId page_number) const {
   return readPage(page_number, false /* allow_free */);
 }
 
+void File::readPage(const PageId page_number, Page& page) const {
+  // The file header is not read: a page that was never allocated lies past
+  // the end of the file, which the short read reports.
+  readPage(page_number, false /* allow_free */, page);
+}
+
 Page File::readPage(const PageId page_number, const bool allow_free) const {
   Page page;
+  readPage(page_number, allow_free, page);
+  return page;
+}
+
+void File::readPage(const PageId page_number, const bool allow_free,
+                    Page& page) const {
+  // A Page is laid out exactly like a page on disk (header followed by data),
+  // so the whole page is read in one go.
   stream_->seekg(pagePosition(page_number), std::ios::beg);
-  stream_->read(reinterpret_cast<char*>(&page.header_), sizeof(page.header_));
-  stream_->read(reinterpret_cast<char*>(&page.data_[0]), Page::DATA_SIZE);
+  stream_->read(reinterpret_cast<char*>(&page), Page::SIZE);
+  if (stream_->gcount() != static_cast<std::streamsize>(Page::SIZE)) {
+    // Past the end of the file. Clear the error so the stream stays usable.
+    stream_->clear();
+    throw InvalidPageException(page_number, filename_);
+  }
   if (!allow_free && !page.isUsed()) {
     throw InvalidPageException(page_number, filename_);
   }
+}
 
-  return page;
+void File::readPages(const PageId first_page_number,
+                     const std::vector<Page*>& pages) const {
+  if (pages.empty()) {
+    return;
+  }
+  // Only the pages read into have to exist; the read stops after the last.
+  std::size_t count = pages.size();
+  while (pages[count - 1] == NULL) {
+    if (--count == 0) {
+      return;
+    }
+  }
+  std::vector<char> staging(count * Page::SIZE);
+  stream_->seekg(pagePosition(first_page_number), std::ios::beg);
+  stream_->read(&staging[0], staging.size());
+  // As in readPage(), pages past the end of the file are found by the short
+  // read rather than by reading the file header first.
+  std::size_t available = static_cast<std::size_t>(stream_->gcount()) / Page::SIZE;
+  if (available < count) {
+    stream_->clear();
+  }
+  for (std::size_t i = 0; i < count; ++i) {
+    if (pages[i] == NULL) {
+      continue;
+    }
+    if (i >= available) {
+      throw InvalidPageException(first_page_number + i, filename_);
+    }
+    // Same layout as on disk, as in readPage().
+    std::memcpy(reinterpret_cast<char*>(pages[i]), &staging[i * Page::SIZE], Page::SIZE);
+    if (!pages[i]->isUsed()) {
+      throw InvalidPageException(first_page_number + i, filename_);
+    }
+  }
 }
 
 void File::writePage(const Page& new_page) {
@@ -181,6 +235,53 @@ void File::writePage(const Page& new_page) {
   writePage(new_page.page_number(), header, new_page);
 }
 
+namespace {
+
+bool pageNumberLess(const Page* a, const Page* b) {
+  return a->page_number() < b->page_number();
+}
+
+}
+
+void File::writePages(const std::vector<const Page*>& pages) {
+  std::vector<const Page*> sorted(pages);
+  std::sort(sorted.begin(), sorted.end(), pageNumberLess);
+
+  std::vector<char> staging;
+  std::size_t begin = 0;
+  while (begin < sorted.size()) {
+    std::size_t end = begin + 1;
+    while (end < sorted.size() && end - begin < MAX_WRITE_RUN &&
+           sorted[end]->page_number() == sorted[end - 1]->page_number() + 1) {
+      ++end;
+    }
+    // Read the run as it is on disk first. As in writePage(), the next page
+    // pointers on disk may have changed since the pages were read and are
+    // kept; this gets all of them with one read instead of one per page.
+    staging.resize((end - begin) * Page::SIZE);
+    stream_->seekg(pagePosition(sorted[begin]->page_number()), std::ios::beg);
+    stream_->read(&staging[0], staging.size());
+    for (std::size_t i = begin; i < end; ++i) {
+      char* slot = &staging[(i - begin) * Page::SIZE];
+      PageHeader header;
+      std::memcpy(&header, slot, sizeof(header));
+      if (header.current_page_number == Page::INVALID_NUMBER) {
+        // Page has been deleted since it was read.
+        throw InvalidPageException(sorted[i]->page_number(), filename_);
+      }
+      const PageId next_page_number = header.next_page_number;
+      header = sorted[i]->header_;
+      header.next_page_number = next_page_number;
+      std::memcpy(slot, &header, sizeof(header));
+      std::memcpy(slot + sizeof(header), sorted[i]->data_, Page::DATA_SIZE);
+    }
+    stream_->seekp(pagePosition(sorted[begin]->page_number()), std::ios::beg);
+    stream_->write(&staging[0], staging.size());
+    begin = end;
+  }
+  stream_->flush();
+}
+
 void File::deletePage(const PageId page_number) {
   FileHeader header = readHeader();
   Page existing_page = readPage(page_number);
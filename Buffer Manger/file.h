@@ -10,6 +10,7 @@
 #include <fstream>
 #include <string>
 #include <map>
+#include <vector>
 #include <memory>
 
 #include "page.h"
@@ -155,6 +156,41 @@ class File {
    */
   Page readPage(const PageId page_number) const;
 
+  /**
+   * Reads an existing page from the file straight into a caller-provided
+   * page, such as a frame of the buffer pool, without a temporary copy.
+   * Takes a single read and does not read the file header.  If an exception
+   * is thrown, the contents of <page> are undefined.
+   *
+   * @param page_number   Number of page to read.
+   * @param page          Page to read into.
+   * @throws  InvalidPageException  If the page doesn't exist in the file or is
+   *                                not currently used.
+   */
+  void readPage(const PageId page_number, Page& page) const;
+
+  /**
+   * Reads a run of consecutive pages with a single read of the whole run,
+   * copying each into a caller-provided page.  A NULL entry skips its page,
+   * which is read along with the others but not checked or copied, so
+   * that a run with a few gaps still takes one read.
+   *
+   * @param first_page_number   Number of the first page of the run.
+   * @param pages   Pages to read into, one per page of the run.
+   * @throws  InvalidPageException  If a page read into doesn't exist in the
+   *                                file or is not currently used.  Pages
+   *                                before it have been read.
+   */
+  void readPages(const PageId first_page_number,
+                 const std::vector<Page*>& pages) const;
+
+  /**
+   * Longest run readPages() is meant to be given.  Callers coalescing reads
+   * split longer runs, which keeps the staging buffer small enough to stay
+   * in cache.
+   */
+  static const std::size_t MAX_READ_RUN = 32;
+
   /**
    * Writes a page into the file, replacing any existing contents.  The page
    * must have been already allocated in this file by a call to allocatePage().
@@ -164,6 +200,20 @@ class File {
    */
   void writePage(const Page& new_page);
 
+  /**
+   * Writes several pages of this file, replacing their existing contents.
+   * The pages are written in page number order; runs of up to MAX_WRITE_RUN
+   * consecutive page numbers are staged and written with a single write, and
+   * the stream is flushed once at the end.  Each page must have been
+   * allocated in this file, as for writePage().
+   *
+   * @see writePage()
+   * @param pages   Pages to write, in any order.
+   * @throws  InvalidPageException  If a page is not currently used.  Runs
+   *                                before the one holding it are written.
+   */
+  void writePages(const std::vector<const Page*>& pages);
+
   /**
    * Deletes a page from the file.
    *
@@ -194,6 +244,12 @@ class File {
   FileIterator end();
 
  private:
+  /**
+   * Maximum number of pages writePages() stages for a single write.  Keeps
+   * the staging buffer small enough to stay in cache.
+   */
+  static const std::size_t MAX_WRITE_RUN = 32;
+
   /**
    * Returns the position of the page with the given number in the file (as an
    * offset from the beginning of the file).
@@ -256,6 +312,20 @@ class File {
    */
   Page readPage(const PageId page_number, const bool allow_free) const;
 
+  /**
+   * Reads a page from the file into <page> with a single read of Page::SIZE
+   * bytes.  Same checks as readPage(page_number, allow_free), except that a
+   * page past the end of the file is detected from the short read.
+   *
+   * @param page_number   Number of page to read.
+   * @param allow_free    Whether to allow reading a free (unused) page.
+   * @param page          Page to read into.
+   * @throws  InvalidPageException  If the page is past the end of the file,
+   *                                or free (unused) and allow_free is false.
+   */
+  void readPage(const PageId page_number, const bool allow_free,
+                Page& page) const;
+
   /**
    * Writes a page into the file at the given page number.  This does not
    * update ensure that the number in the header equals the position on disk.
@@ -3,8 +3,20 @@
 //#include <stdio.h>
 #include <cstring>
 #include <memory>
+#include <thread>
+#include <vector>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
 #include "page.h"
 #include "buffer.h"
+#include "buf_pool_set.h"
+#include "buf_manifest.h"
+#include "victim_cache.h"
+#include "buf_trace.h"
+#include "buf_simulator.h"
+#include "mrc_estimator.h"
+#include "async_page.h"
 #include "file_iterator.h"
 #include "page_iterator.h"
 #include "exceptions/file_not_found_exception.h"
@@ -12,6 +24,11 @@
 #include "exceptions/page_not_pinned_exception.h"
 #include "exceptions/page_pinned_exception.h"
 #include "exceptions/buffer_exceeded_exception.h"
+#include "exceptions/hash_not_found_exception.h"
+#include "exceptions/pool_exists_exception.h"
+#include "exceptions/pool_not_found_exception.h"
+#include "exceptions/bad_manifest_exception.h"
+#include "exceptions/bad_trace_exception.h"
 
 #define PRINT_ERROR(str) \
 { \
@@ -37,6 +54,40 @@ void test4();
 void test5();
 void test6();
 void testBufMgr();
+void testReplacementPolicies();
+void testBackgroundFlusher();
+void testPrefetch();
+void testAccessStrategy();
+void testFrameArena();
+void testZeroCopyRead();
+void testResize();
+void testBatchWriteBack();
+void testStats();
+void testPageHandle();
+void testOptimisticRead();
+void testBufPoolSet();
+void testEvictionListener();
+void testWarmRestart();
+void testVictimCache();
+void testTraceReplay();
+void testHitRatioCurve();
+void testAsyncRead();
+#ifdef __cpp_impl_coroutine
+void testCoroutineRead();
+#endif
+void testReadPages();
+void testAccessHints();
+void testAdmissionFilter();
+void testConcurrentMisses();
+void benchBufMgr();
+void benchPartitions(File* file, std::uint32_t parts, unsigned int nthreads);
+void benchOptimisticRead(File* file, unsigned int nthreads);
+void benchLookupMiss();
+void benchFlushFile();
+void benchWriteBack();
+void removeTestFile(const std::string& filename);
+File makeTestFile(const std::string& filename, PageId numPages = 0, RecordId* rids = NULL);
+void testRecord(const std::string& filename, PageId pageNo);
 
 int main() 
 {
@@ -99,6 +150,37 @@ int main()
 
 	//This function tests buffer manager, comment this line if you don't wish to test buffer manager
 	testBufMgr();
+	testReplacementPolicies();
+	testBackgroundFlusher();
+	testPrefetch();
+	testAccessStrategy();
+	testFrameArena();
+	testZeroCopyRead();
+	testResize();
+	testBatchWriteBack();
+	testStats();
+	testPageHandle();
+	testOptimisticRead();
+	testBufPoolSet();
+	testEvictionListener();
+	testWarmRestart();
+	testVictimCache();
+	testTraceReplay();
+	testHitRatioCurve();
+	testAsyncRead();
+#ifdef __cpp_impl_coroutine
+	testCoroutineRead();
+#endif
+	testReadPages();
+	testAccessHints();
+	testAdmissionFilter();
+	testConcurrentMisses();
+
+	//This function measures multi-threaded buffer manager throughput, comment this line if you don't wish to run it
+	benchBufMgr();
+	benchLookupMiss();
+	benchFlushFile();
+	benchWriteBack();
 }
 
 void testBufMgr()
@@ -326,3 +408,2417 @@ void test6()
 
 	bufMgr->flushFile(file1ptr);
 }
+
+/**
+ * Removes a file left behind by an earlier run, if there is one.
+ */
+void removeTestFile(const std::string& filename)
+{
+	try
+	{
+		File::remove(filename);
+	}
+	catch(FileNotFoundException e)
+	{
+	}
+}
+
+/**
+ * Creates a test file afresh and writes numPages pages to it through a buffer
+ * manager of its own, so that none of them is resident in the caller's pool.
+ * Page n holds the record given by testRecord(); its id is stored in rids[n - 1]
+ * when rids is not NULL.
+ */
+File makeTestFile(const std::string& filename, PageId numPages, RecordId* rids)
+{
+	removeTestFile(filename);
+	File file = File::create(filename);
+	if (numPages != 0)
+	{
+		BufMgr loader(numPages < num ? numPages : num);
+		PageId pageNo;
+		Page* loaded;
+		for (PageId n = 0; n < numPages; n++)
+		{
+			loader.allocPage(&file, pageNo, loaded);
+			testRecord(filename, pageNo);
+			RecordId recordId = loaded->insertRecord(tmpbuf);
+			if (rids != NULL)
+			{
+				rids[n] = recordId;
+			}
+			loader.unPinPage(&file, pageNo, true);
+		}
+		loader.flushFile(&file);
+	}
+	return file;
+}
+
+/**
+ * Formats the record makeTestFile() writes on the given page into tmpbuf.
+ */
+void testRecord(const std::string& filename, PageId pageNo)
+{
+	sprintf(tmpbuf, "%s Page %d %7.1f", filename.c_str(), pageNo, (float)pageNo);
+}
+
+void testReplacementPolicies()
+{
+	const std::string& filename = "test.6";
+	const PageId numPages = 50;
+	const std::uint32_t poolSize = 20;
+	const ReplacementPolicyType policies[] = {CLOCK, LRU_K, TWO_Q, ARC};
+	const char* policyNames[] = {"CLOCK", "LRU_K", "TWO_Q", "ARC"};
+
+	{
+		RecordId rids[numPages];
+		File file = makeTestFile(filename, numPages, rids);
+
+		for (int p = 0; p < 4; p++)
+		{
+			BufMgr mgr(poolSize, 1, policies[p]);
+
+			// A small hot set of pages is reused between stretches of a scan over the whole file.
+			for (int round = 0; round < 10; round++)
+			{
+				for (PageId scan = 0; scan < numPages; scan++)
+				{
+					PageId index = (scan % 5 == 0) ? (PageId)(round % 2) : scan;
+					mgr.readPage(&file, index + 1, page);
+					testRecord(filename, index + 1);
+					if(strncmp(page->getRecord(rids[index]).c_str(), tmpbuf, strlen(tmpbuf)) != 0)
+					{
+						PRINT_ERROR("ERROR :: CONTENTS DID NOT MATCH");
+					}
+					mgr.unPinPage(&file, index + 1, false);
+				}
+			}
+
+			// Every frame pinned: the next request must fail whatever the policy.
+			for (i = 1; i <= poolSize; i++)
+				mgr.readPage(&file, i, page);
+			try
+			{
+				mgr.readPage(&file, poolSize + 1, page);
+				PRINT_ERROR("ERROR :: No more frames left for allocation. Exception should have been thrown before execution reaches this point.");
+			}
+			catch(BufferExceededException e)
+			{
+			}
+			for (i = 1; i <= poolSize; i++)
+				mgr.unPinPage(&file, i, false);
+
+			std::cout << "  " << policyNames[p] << ": " << mgr.getBufStats().diskreads << " disk reads" << "\n";
+		}
+	}
+
+	File::remove(filename);
+	std::cout << "Test replacement policies passed" << "\n";
+}
+
+void testBackgroundFlusher()
+{
+	const std::string& filename = "test.7";
+	const std::uint32_t poolSize = 20;
+
+	{
+		File file = makeTestFile(filename);
+		RecordId rids[2 * poolSize];
+		PageId pageNo;
+		BufMgr mgr(poolSize);
+
+		// Fill the whole pool with dirty pages.
+		for (i = 0; i < poolSize; i++)
+		{
+			mgr.allocPage(&file, pageNo, page);
+			testRecord(filename, pageNo);
+			rids[i] = page->insertRecord(tmpbuf);
+			mgr.unPinPage(&file, pageNo, true);
+		}
+
+		BufFlusherConfig config;
+		config.lowWatermark = 0.5;
+		config.highWatermark = 1.0;
+		config.intervalMs = 1;
+		mgr.startFlusher(config);
+		std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+		// Every frame has been cleaned in the background, so the evictions caused by these
+		// allocations must not write anything themselves.
+		mgr.stopFlusher();
+		mgr.clearBufStats();
+		for (i = poolSize; i < 2 * poolSize; i++)
+		{
+			mgr.allocPage(&file, pageNo, page);
+			testRecord(filename, pageNo);
+			rids[i] = page->insertRecord(tmpbuf);
+			mgr.unPinPage(&file, pageNo, true);
+		}
+		if (mgr.getBufStats().stalledevictions != 0)
+		{
+			PRINT_ERROR("ERROR :: Eviction stalled on a write although the flusher cleaned the pool");
+		}
+		mgr.flushFile(&file);
+
+		// Everything written by the flusher must read back intact.
+		for (i = 0; i < 2 * poolSize; i++)
+		{
+			mgr.readPage(&file, i + 1, page);
+			testRecord(filename, i + 1);
+			if(strncmp(page->getRecord(rids[i]).c_str(), tmpbuf, strlen(tmpbuf)) != 0)
+			{
+				PRINT_ERROR("ERROR :: CONTENTS DID NOT MATCH");
+			}
+			mgr.unPinPage(&file, i + 1, false);
+		}
+		mgr.flushFile(&file);
+	}
+
+	File::remove(filename);
+	std::cout << "Test background flusher passed" << "\n";
+}
+
+void testPrefetch()
+{
+	const std::string& filename = "test.8";
+	const PageId numPages = 10;
+
+	{
+		RecordId rids[numPages];
+		File file = makeTestFile(filename, numPages, rids);
+
+		BufMgr mgr(2 * numPages);
+		// The last page does not exist and must be skipped silently.
+		mgr.prefetch(&file, 1, numPages + 1);
+		for (int wait = 0; wait < 1000 && mgr.getBufStats().diskreads < numPages; wait++)
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		if (mgr.getBufStats().diskreads != numPages)
+		{
+			PRINT_ERROR("ERROR :: Prefetched pages were not loaded");
+		}
+
+		// All reads must now be hits.
+		for (i = 0; i < numPages; i++)
+		{
+			mgr.readPage(&file, i + 1, page);
+			testRecord(filename, i + 1);
+			if(strncmp(page->getRecord(rids[i]).c_str(), tmpbuf, strlen(tmpbuf)) != 0)
+			{
+				PRINT_ERROR("ERROR :: CONTENTS DID NOT MATCH");
+			}
+			mgr.unPinPage(&file, i + 1, false);
+		}
+		if (mgr.getBufStats().diskreads != numPages)
+		{
+			PRINT_ERROR("ERROR :: Prefetched page was read again");
+		}
+
+		// Requests still queued for the file are dropped before it is flushed.
+		mgr.prefetch(&file, 1, numPages);
+		mgr.flushFile(&file);
+	}
+
+	File::remove(filename);
+	std::cout << "Test prefetch passed" << "\n";
+}
+
+void testAccessStrategy()
+{
+	const std::string& filename = "test.9";
+	const PageId numPages = 60;
+	const PageId hotPages = 5;
+
+	{
+		RecordId rids[numPages];
+		File file = makeTestFile(filename, numPages, rids);
+
+		BufMgr mgr(20);
+		for (i = 1; i <= hotPages; i++)
+		{
+			mgr.readPage(&file, i, page);
+			mgr.unPinPage(&file, i, false);
+		}
+
+		// Scan the rest of the file, which is larger than the pool, through a ring of 4 frames.
+		BufferAccessStrategy strategy(4);
+		for (i = hotPages + 1; i <= numPages; i++)
+		{
+			mgr.readPage(&file, i, page, &strategy);
+			testRecord(filename, i);
+			if(strncmp(page->getRecord(rids[i - 1]).c_str(), tmpbuf, strlen(tmpbuf)) != 0)
+			{
+				PRINT_ERROR("ERROR :: CONTENTS DID NOT MATCH");
+			}
+			mgr.unPinPage(&file, i, false);
+		}
+
+		// The hot pages must have survived the scan.
+		std::uint64_t readsAfterScan = mgr.getBufStats().diskreads;
+		for (i = 1; i <= hotPages; i++)
+		{
+			mgr.readPage(&file, i, page);
+			mgr.unPinPage(&file, i, false);
+		}
+		if (mgr.getBufStats().diskreads != readsAfterScan)
+		{
+			PRINT_ERROR("ERROR :: Sequential scan with an access strategy evicted hot pages");
+		}
+		mgr.flushFile(&file);
+	}
+
+	File::remove(filename);
+	std::cout << "Test access strategy passed" << "\n";
+}
+
+void testFrameArena()
+{
+	const std::string& filename = "test.10";
+
+
+	{
+		File file = makeTestFile(filename);
+		PageId pageNo;
+		BufMgr mgr(num, 1, CLOCK, true /* hugePages */);
+
+		// Frames are consecutive, page-aligned slices of one arena.
+		if ((std::uintptr_t)mgr.bufPool % 4096 != 0)
+		{
+			PRINT_ERROR("ERROR :: Buffer pool is not page aligned");
+		}
+		for (i = 0; i < num; i++)
+		{
+			mgr.allocPage(&file, pageNo, page);
+			if ((std::uintptr_t)page % 4096 != 0 || page < mgr.bufPool || page >= mgr.bufPool + num)
+			{
+				PRINT_ERROR("ERROR :: Frame is not a page-aligned slice of the arena");
+			}
+			testRecord(filename, pageNo);
+			rid[i] = page->insertRecord(tmpbuf);
+			mgr.unPinPage(&file, pageNo, true);
+		}
+		mgr.flushFile(&file);
+
+		for (i = 0; i < num; i++)
+		{
+			mgr.readPage(&file, i + 1, page);
+			testRecord(filename, i + 1);
+			if(strncmp(page->getRecord(rid[i]).c_str(), tmpbuf, strlen(tmpbuf)) != 0)
+			{
+				PRINT_ERROR("ERROR :: CONTENTS DID NOT MATCH");
+			}
+			mgr.unPinPage(&file, i + 1, false);
+		}
+		mgr.flushFile(&file);
+	}
+
+	File::remove(filename);
+	std::cout << "Test frame arena passed" << "\n";
+}
+
+void testZeroCopyRead()
+{
+	const std::string& filename = "test.11";
+
+	{
+		File file = makeTestFile(filename, num, rid);
+
+		// Reading in place gives the same page as reading by value.
+		Page inPlace;
+		for (i = 0; i < num; i++)
+		{
+			file.readPage(i + 1, inPlace);
+			Page byValue = file.readPage(i + 1);
+			if (inPlace.page_number() != (PageId)(i + 1) ||
+					memcmp(&inPlace, &byValue, Page::SIZE) != 0)
+			{
+				PRINT_ERROR("ERROR :: In-place read does not match the page on disk");
+			}
+		}
+
+		try
+		{
+			file.readPage(num + 1, inPlace);
+			PRINT_ERROR("ERROR :: Reading a page past the end of the file should throw InvalidPageException");
+		}
+		catch(InvalidPageException e)
+		{
+		}
+
+		// Misses read straight into the frames.
+		BufMgr mgr(num);
+		for (i = 0; i < num; i++)
+		{
+			mgr.readPage(&file, i + 1, page);
+			testRecord(filename, i + 1);
+			if(strncmp(page->getRecord(rid[i]).c_str(), tmpbuf, strlen(tmpbuf)) != 0)
+			{
+				PRINT_ERROR("ERROR :: CONTENTS DID NOT MATCH");
+			}
+			mgr.unPinPage(&file, i + 1, false);
+		}
+		mgr.flushFile(&file);
+	}
+
+	File::remove(filename);
+	std::cout << "Test zero-copy read passed" << "\n";
+}
+
+void testResize()
+{
+	const std::string& filename = "test.12";
+	const PageId total = 3 * num;
+	std::vector<RecordId> rids(total);
+
+	{
+		File file = makeTestFile(filename, total, &rids[0]);
+		PageId pageNo;
+		BufMgr mgr(num, 1, CLOCK, false, total);
+
+		// Once grown, the pool holds every page pinned at the same time.
+		if (mgr.resize(total) != total)
+		{
+			PRINT_ERROR("ERROR :: Pool did not grow to its maximum size");
+		}
+		for (i = 0; i < total; i++)
+		{
+			mgr.readPage(&file, i + 1, page);
+			testRecord(filename, i + 1);
+			if(strncmp(page->getRecord(rids[i]).c_str(), tmpbuf, strlen(tmpbuf)) != 0)
+			{
+				PRINT_ERROR("ERROR :: CONTENTS DID NOT MATCH");
+			}
+		}
+
+		// Pinned frames cannot be given up.
+		if (mgr.resize(num) != total)
+		{
+			PRINT_ERROR("ERROR :: Shrinking gave up pinned frames");
+		}
+		for (i = 0; i < total; i++)
+		{
+			mgr.unPinPage(&file, i + 1, false);
+		}
+
+		// All pages are still resident and found through the rehashed tables.
+		mgr.clearBufStats();
+		for (i = 0; i < total; i++)
+		{
+			mgr.readPage(&file, i + 1, page);
+			mgr.unPinPage(&file, i + 1, false);
+		}
+		if (mgr.getBufStats().diskreads != 0)
+		{
+			PRINT_ERROR("ERROR :: Pages were lost while the hash tables were rehashed");
+		}
+
+		if (mgr.resize(num) != num)
+		{
+			PRINT_ERROR("ERROR :: Pool did not shrink once its frames were unpinned");
+		}
+		mgr.flushFile(&file);
+
+		// Pages in the frames given up move into the free frames below, dirty or not.
+		File other = File::create(filename + ".other");
+		mgr.resize(total);
+		for (i = 0; i < total; i++)
+		{
+			if (i % 3 == 0)
+			{
+				mgr.readPage(&file, i / 3 + 1, page);
+				mgr.unPinPage(&file, i / 3 + 1, i % 2 == 0);
+			}
+			else
+			{
+				mgr.allocPage(&other, pageNo, page);
+				mgr.unPinPage(&other, pageNo, false);
+			}
+		}
+		mgr.flushFile(&other);
+		mgr.clearBufStats();
+		if (mgr.resize(num) != num)
+		{
+			PRINT_ERROR("ERROR :: Pool did not shrink into its free frames");
+		}
+		for (i = 0; i < num; i++)
+		{
+			mgr.readPage(&file, i + 1, page);
+			testRecord(filename, i + 1);
+			if(strncmp(page->getRecord(rids[i]).c_str(), tmpbuf, strlen(tmpbuf)) != 0)
+			{
+				PRINT_ERROR("ERROR :: CONTENTS DID NOT MATCH");
+			}
+			mgr.unPinPage(&file, i + 1, false);
+		}
+		if (mgr.getBufStats().diskreads != 0 || mgr.getBufStats().evictions != 0)
+		{
+			PRINT_ERROR("ERROR :: Shrinking evicted pages that fit in the free frames");
+		}
+		mgr.flushFile(&file);
+	}
+	File::remove(filename + ".other");
+
+	{
+		File file = File::open(filename);
+		const ReplacementPolicyType policies[] = {CLOCK, LRU_K, TWO_Q, ARC};
+		for (int p = 0; p < 4; p++)
+		{
+			BufMgr mgr(num, 4, policies[p], false, total);
+
+			if (mgr.resize(10 * total) != total || mgr.resize(1) != 4)
+			{
+				PRINT_ERROR("ERROR :: Pool was not resized to the clamped target");
+			}
+
+			// Resize continuously while another thread reads.
+			bool done = false;
+			std::mutex doneLatch;
+			std::thread resizer([&mgr, &done, &doneLatch, total]()
+			{
+				for (std::uint32_t round = 0; ; round++)
+				{
+					{
+						std::lock_guard<std::mutex> guard(doneLatch);
+						if (done)
+						{
+							break;
+						}
+					}
+					mgr.resize(round % 2 == 0 ? total : num / 2);
+				}
+			});
+			for (int pass = 0; pass < 5; pass++)
+			{
+				for (i = 0; i < total; i++)
+				{
+					mgr.readPage(&file, i + 1, page);
+					testRecord(filename, i + 1);
+					if(strncmp(page->getRecord(rids[i]).c_str(), tmpbuf, strlen(tmpbuf)) != 0)
+					{
+						PRINT_ERROR("ERROR :: CONTENTS DID NOT MATCH");
+					}
+					// Dirty some pages so that shrinking has to write them back.
+					mgr.unPinPage(&file, i + 1, i % 3 == 0);
+				}
+			}
+			{
+				std::lock_guard<std::mutex> guard(doneLatch);
+				done = true;
+			}
+			resizer.join();
+			mgr.flushFile(&file);
+		}
+	}
+
+	File::remove(filename);
+	std::cout << "Test resize passed" << "\n";
+}
+
+void testBatchWriteBack()
+{
+	const std::string& filename = "test.13";
+
+
+	{
+		File file = makeTestFile(filename);
+		PageId pageNo;
+		// Pages are spread over the partitions by hash; leave room so none is evicted.
+		BufMgr mgr(2 * num, 4);
+
+		for (i = 0; i < num; i++)
+		{
+			mgr.allocPage(&file, pageNo, page);
+			testRecord(filename, pageNo);
+			rid[i] = page->insertRecord(tmpbuf);
+			mgr.unPinPage(&file, pageNo, true);
+		}
+
+		// A checkpoint writes every dirty page once and keeps it resident.
+		mgr.clearBufStats();
+		mgr.checkpoint();
+		if (mgr.getBufStats().diskwrites != num)
+		{
+			PRINT_ERROR("ERROR :: Checkpoint did not write every dirty page exactly once");
+		}
+		for (i = 0; i < num; i++)
+		{
+			Page onDisk = file.readPage(i + 1);
+			testRecord(filename, i + 1);
+			if(strncmp(onDisk.getRecord(rid[i]).c_str(), tmpbuf, strlen(tmpbuf)) != 0)
+			{
+				PRINT_ERROR("ERROR :: CONTENTS DID NOT MATCH");
+			}
+		}
+		mgr.checkpoint();
+		for (i = 0; i < num; i++)
+		{
+			mgr.readPage(&file, i + 1, page);
+			mgr.unPinPage(&file, i + 1, true);
+		}
+		if (mgr.getBufStats().diskwrites != num || mgr.getBufStats().diskreads != 0)
+		{
+			PRINT_ERROR("ERROR :: Checkpoint wrote clean pages or dropped resident ones");
+		}
+
+		// Deleting a page relinks its neighbour on disk; writing back the
+		// stale buffered copy of the neighbour must not undo that.
+		mgr.disposePage(&file, num / 2);
+		mgr.flushFile(&file);
+		PageId count = 0;
+		for (FileIterator iter = file.begin(); iter != file.end(); ++iter)
+		{
+			if ((*iter).page_number() == num / 2)
+			{
+				PRINT_ERROR("ERROR :: Disposed page is still linked into the file");
+			}
+			count++;
+		}
+		if (count != num - 1)
+		{
+			PRINT_ERROR("ERROR :: Batch write-back broke the list of used pages");
+		}
+	}
+
+	File::remove(filename);
+	std::cout << "Test batch write-back passed" << "\n";
+}
+
+void testStats()
+{
+	const std::string& filename = "test.14";
+	const PageId numPages = 10;
+
+
+	{
+		File file = makeTestFile(filename);
+		PageId pageNo;
+		BufMgr mgr(numPages / 2);
+
+		// Every call is one access, counted once as a hit, miss or alloc.
+		for (i = 0; i < numPages; i++)
+		{
+			mgr.allocPage(&file, pageNo, page);
+			mgr.unPinPage(&file, pageNo, true);
+		}
+		for (i = 0; i < numPages; i++)
+		{
+			mgr.readPage(&file, i + 1, page);
+			mgr.unPinPage(&file, i + 1, false);
+			mgr.readPage(&file, i + 1, page);
+			mgr.unPinPage(&file, i + 1, false);
+		}
+
+		BufStatsSnapshot snapshot = mgr.getStatsSnapshot();
+		const BufStats& total = snapshot.total;
+		if (total.accesses != 3 * numPages || total.allocs != numPages || total.misses != numPages ||
+				total.hits != numPages || total.hits + total.misses + total.allocs != total.accesses)
+		{
+			PRINT_ERROR("ERROR :: Accesses were not counted once each");
+		}
+		if (total.diskreads != numPages || total.readLatency.count != numPages)
+		{
+			PRINT_ERROR("ERROR :: Disk reads were not counted once each");
+		}
+		// The pool holds half the pages, so every alloc and miss beyond the first half evicts one.
+		if (total.evictions != numPages + numPages / 2 || total.stalledevictions != numPages ||
+				total.diskwrites != numPages || total.writeLatency.count != numPages)
+		{
+			PRINT_ERROR("ERROR :: Evictions were not counted correctly");
+		}
+		if (snapshot.numBufs != numPages / 2 || snapshot.files.size() != 1 ||
+				snapshot.files[filename].accesses != total.accesses ||
+				snapshot.files[filename].evictions != total.evictions)
+		{
+			PRINT_ERROR("ERROR :: Per-file statistics do not add up to the totals");
+		}
+
+		std::string json = snapshot.toJson();
+		std::string prometheus = snapshot.toPrometheus();
+		if (json.find("\"hits\":10,") == std::string::npos || json.find("\"test.14\":{") == std::string::npos ||
+				prometheus.find("\nbadgerdb_buffer_hits_total 10\n") == std::string::npos ||
+				prometheus.find("badgerdb_buffer_file_misses_total{file=\"test.14\"} 10\n") == std::string::npos ||
+				prometheus.find("badgerdb_buffer_read_latency_seconds_count 10\n") == std::string::npos)
+		{
+			PRINT_ERROR("ERROR :: Exported statistics are missing counters");
+		}
+
+		mgr.clearBufStats();
+		if (mgr.getBufStats().accesses != 0 || mgr.getStatsSnapshot().files[filename].accesses != 0)
+		{
+			PRINT_ERROR("ERROR :: Statistics were not cleared");
+		}
+		mgr.flushFile(&file);
+
+		// The file has no page left in the pool, so clearing forgets it.
+		mgr.clearBufStats();
+		if (mgr.getStatsSnapshot().files.size() != 0)
+		{
+			PRINT_ERROR("ERROR :: Statistics of a file without pages were kept");
+		}
+	}
+
+	File::remove(filename);
+	std::cout << "Test stats passed" << "\n";
+}
+
+void testPageHandle()
+{
+	const std::string& filename = "test.15";
+
+
+	{
+		File file = makeTestFile(filename);
+		PageId pageNo;
+		BufMgr mgr(2);
+
+		// Writing through a handle marks the page dirty; leaving the scope unpins it.
+		{
+			PageHandle handle = mgr.allocPage(&file, pageNo);
+			testRecord(filename, pageNo);
+			rid2 = handle.getMutable()->insertRecord(tmpbuf);
+			if (handle.pageNo() != pageNo)
+			{
+				PRINT_ERROR("ERROR :: Handle does not know its page number");
+			}
+		}
+		mgr.flushFile(&file);
+		if(strncmp(file.readPage(pageNo).getRecord(rid2).c_str(), tmpbuf, strlen(tmpbuf)) != 0)
+		{
+			PRINT_ERROR("ERROR :: CONTENTS DID NOT MATCH");
+		}
+
+		// Read-only access leaves the page clean.
+		mgr.clearBufStats();
+		{
+			PageHandle handle = mgr.readPage(&file, pageNo);
+			if(strncmp(handle->getRecord(rid2).c_str(), tmpbuf, strlen(tmpbuf)) != 0)
+			{
+				PRINT_ERROR("ERROR :: CONTENTS DID NOT MATCH");
+			}
+		}
+		mgr.flushFile(&file);
+		if (mgr.getBufStats().diskwrites != 0)
+		{
+			PRINT_ERROR("ERROR :: Page read through a handle was written back");
+		}
+
+		// A transient write holds off optimistic readers like any other, but leaves the page clean.
+		{
+			PageHandle handle = mgr.readPage(&file, pageNo);
+			handle.getTransient();
+			OptimisticRead read(handle.frame());
+			if (mgr.readOptimistic(&file, pageNo, read))
+			{
+				PRINT_ERROR("ERROR :: Optimistic read overlapped a transient write");
+			}
+		}
+		OptimisticRead after;
+		if (!mgr.readOptimistic(&file, pageNo, after) || !mgr.validate(after))
+		{
+			PRINT_ERROR("ERROR :: Transient writer was not retired on release");
+		}
+		mgr.flushFile(&file);
+		if (mgr.getBufStats().diskwrites != 0)
+		{
+			PRINT_ERROR("ERROR :: Page written transiently was written back");
+		}
+
+		// The pin is released while an exception unwinds the stack.
+		try
+		{
+			PageHandle handle = mgr.readPage(&file, pageNo);
+			throw InvalidPageException(pageNo, filename);
+		}
+		catch(InvalidPageException e)
+		{
+		}
+		mgr.flushFile(&file);
+
+		// Moving hands the pin over; each pin is released exactly once.
+		PageHandle first = mgr.readPage(&file, pageNo);
+		PageHandle second(std::move(first));
+		if (first || !second)
+		{
+			PRINT_ERROR("ERROR :: Moving a handle did not transfer the page");
+		}
+		PageHandle third = mgr.allocPage(&file, pageNo);
+		try
+		{
+			// Both frames are pinned.
+			mgr.allocPage(&file, pageNo);
+			PRINT_ERROR("ERROR :: Allocated a page although every frame is pinned");
+		}
+		catch(BufferExceededException e)
+		{
+		}
+		third = std::move(second);
+		PageHandle fourth = mgr.allocPage(&file, pageNo);
+		third.release();
+		fourth.release();
+		third.release();
+		mgr.flushFile(&file);
+	}
+
+	File::remove(filename);
+	std::cout << "Test page handle passed" << "\n";
+}
+
+void testOptimisticRead()
+{
+	const std::string& filename = "test.16";
+	// Two copies of a counter at opposite ends of the page, which a reader must always see equal.
+	const std::size_t lowOffset = 64, highOffset = Page::SIZE - 64;
+
+
+	{
+		File file = makeTestFile(filename);
+		PageId pageNo;
+		BufMgr mgr(4);
+
+		{
+			PageHandle handle = mgr.allocPage(&file, pageNo);
+			testRecord(filename, pageNo);
+			rid2 = handle.getMutable()->insertRecord(tmpbuf);
+		}
+
+		// The first read finds the frame through the hash table, the second through the hint.
+		OptimisticRead read;
+		for (int pass = 0; pass < 2; pass++)
+		{
+			if (!mgr.readOptimistic(&file, pageNo, read) ||
+					strncmp(read.page->getRecord(rid2).c_str(), tmpbuf, strlen(tmpbuf)) != 0 || !mgr.validate(read))
+			{
+				PRINT_ERROR("ERROR :: Optimistic read of a resident page failed");
+			}
+		}
+		if (read.frame == OptimisticRead::NO_FRAME)
+		{
+			PRINT_ERROR("ERROR :: Optimistic read did not report the frame");
+		}
+
+		// A read overlapping a write fails validation; no read starts while a writer is active.
+		{
+			PageHandle handle = mgr.readPage(&file, pageNo);
+			handle.getMutable();
+			if (mgr.validate(read) || mgr.readOptimistic(&file, pageNo, read))
+			{
+				PRINT_ERROR("ERROR :: Optimistic read did not notice a writer");
+			}
+		}
+		if (mgr.validate(read) || !mgr.readOptimistic(&file, pageNo, read) || !mgr.validate(read))
+		{
+			PRINT_ERROR("ERROR :: Optimistic read did not notice a finished write");
+		}
+		// A page pinned through a Page* may be written at any time until it is unpinned, so reads
+		// overlapping the pin fail even before the write is announced by unPinPage().
+		mgr.readPage(&file, pageNo, page);
+		if (mgr.validate(read) || mgr.readOptimistic(&file, pageNo, read))
+		{
+			PRINT_ERROR("ERROR :: Optimistic read did not notice a page pinned through Page*");
+		}
+		mgr.unPinPage(&file, pageNo, true);
+		if (!mgr.readOptimistic(&file, pageNo, read) || !mgr.validate(read))
+		{
+			PRINT_ERROR("ERROR :: Optimistic read failed after the Page* was unpinned");
+		}
+
+		// Once the page is evicted, neither the hint nor the hash table finds it.
+		mgr.readOptimistic(&file, pageNo, read);
+		for (i = 0; i < 8; i++)
+		{
+			PageId other;
+			mgr.allocPage(&file, other, page);
+			mgr.unPinPage(&file, other, false);
+		}
+		if (mgr.validate(read) || mgr.readOptimistic(&file, pageNo, read))
+		{
+			PRINT_ERROR("ERROR :: Optimistic read found an evicted page");
+		}
+
+		// Readers racing with a writer either fail validation or see both copies of the counter equal.
+		mgr.readPage(&file, pageNo, page);
+		mgr.unPinPage(&file, pageNo, false);
+		bool done = false;
+		std::mutex doneLatch;
+		std::thread writer([&mgr, &file, &done, &doneLatch, pageNo, lowOffset, highOffset]()
+		{
+			for (int value = 1; ; value++)
+			{
+				{
+					std::lock_guard<std::mutex> guard(doneLatch);
+					if (done)
+					{
+						break;
+					}
+				}
+				PageHandle handle = mgr.readPage(&file, pageNo);
+				char* data = (char*)handle.getMutable();
+				memcpy(data + lowOffset, &value, sizeof(value));
+				std::this_thread::yield();
+				memcpy(data + highOffset, &value, sizeof(value));
+			}
+		});
+		int validated = 0;
+		OptimisticRead racing;
+		auto start = std::chrono::steady_clock::now();
+		while (validated < 1000 && std::chrono::steady_clock::now() - start < std::chrono::seconds(5))
+		{
+			if (!mgr.readOptimistic(&file, pageNo, racing))
+			{
+				std::this_thread::yield();
+				continue;
+			}
+			int low, high;
+			memcpy(&low, (const char*)racing.page + lowOffset, sizeof(low));
+			memcpy(&high, (const char*)racing.page + highOffset, sizeof(high));
+			if (mgr.validate(racing))
+			{
+				if (low != high)
+				{
+					PRINT_ERROR("ERROR :: Validated optimistic read saw a torn page");
+				}
+				validated++;
+			}
+		}
+		{
+			std::lock_guard<std::mutex> guard(doneLatch);
+			done = true;
+		}
+		writer.join();
+		if (validated == 0)
+		{
+			PRINT_ERROR("ERROR :: No optimistic read validated");
+		}
+
+		// Shrinking the pool keeps given-up frames readable, so a stale hint fails cleanly.
+		BufMgr shrinking(4, 1, CLOCK, false, 4);
+		for (i = 0; i < 4; i++)
+		{
+			shrinking.readPage(&file, i + 1, page);
+			shrinking.unPinPage(&file, i + 1, false);
+		}
+		OptimisticRead last;
+		for (i = 0; i < 4; i++)
+		{
+			if (!shrinking.readOptimistic(&file, i + 1, last))
+			{
+				PRINT_ERROR("ERROR :: Optimistic read of a resident page failed");
+			}
+			if (last.frame == 3)
+			{
+				break;
+			}
+		}
+		shrinking.resize(1);
+		if (shrinking.validate(last) || shrinking.readOptimistic(&file, i + 1, last))
+		{
+			PRINT_ERROR("ERROR :: Optimistic read found a page in a frame given up by resize()");
+		}
+		// A reader still looking at the frame sees a zero page instead of faulting.
+		if (last.page->page_number() != 0)
+		{
+			PRINT_ERROR("ERROR :: Frame given up by resize() was not released");
+		}
+		shrinking.flushFile(&file);
+		mgr.flushFile(&file);
+	}
+
+	File::remove(filename);
+	std::cout << "Test optimistic read passed" << "\n";
+}
+
+void testBufPoolSet()
+{
+	const std::string& dataName = "test.17.dat";
+	const std::string& indexName = "test.17.idx";
+	const PageId indexPages = 10;
+
+	if (!BufPoolSet::matches("*.idx", indexName) || BufPoolSet::matches("*.idx", dataName) ||
+			!BufPoolSet::matches("test.??.*", dataName) || BufPoolSet::matches("test.?.*", dataName) ||
+			!BufPoolSet::matches("*", "") || !BufPoolSet::matches("t*s*7*", indexName))
+	{
+		PRINT_ERROR("ERROR :: File name patterns matched wrongly");
+	}
+
+	{
+		File data = makeTestFile(dataName);
+		File index = makeTestFile(indexName);
+		PageId pageNo;
+
+		BufPoolSet pools;
+		try
+		{
+			pools.poolFor(&data);
+			PRINT_ERROR("ERROR :: Found a pool before any was created");
+		}
+		catch(PoolNotFoundException e)
+		{
+		}
+		BufMgr& dataPool = pools.createPool("data", 5);
+		BufMgr& indexPool = pools.createPool("index", indexPages, 1, LRU_K);
+		pools.bindFile("*.idx", "index");
+		try
+		{
+			pools.createPool("data", 5);
+			PRINT_ERROR("ERROR :: Created a pool twice");
+		}
+		catch(PoolExistsException e)
+		{
+		}
+		try
+		{
+			pools.bindFile("*", "temp");
+			PRINT_ERROR("ERROR :: Bound files to a pool that does not exist");
+		}
+		catch(PoolNotFoundException e)
+		{
+		}
+		if (&pools.poolFor(&index) != &indexPool || &pools.poolFor(&data) != &dataPool ||
+				&pools.getPool("index") != &indexPool || pools.poolNames().size() != 2)
+		{
+			PRINT_ERROR("ERROR :: Files were not assigned to their pools");
+		}
+
+		// The index fits its pool and stays resident while a scan churns the data pool.
+		for (i = 0; i < indexPages; i++)
+		{
+			indexPool.allocPage(&index, pageNo, page);
+			indexPool.unPinPage(&index, pageNo, true);
+		}
+		for (i = 0; i < num; i++)
+		{
+			dataPool.allocPage(&data, pageNo, page);
+			dataPool.unPinPage(&data, pageNo, true);
+		}
+		for (i = 0; i < num; i++)
+		{
+			dataPool.readPage(&data, i + 1, page);
+			dataPool.unPinPage(&data, i + 1, false);
+			indexPool.readPage(&index, i % indexPages + 1, page);
+			indexPool.unPinPage(&index, i % indexPages + 1, false);
+		}
+		std::map<std::string, BufStatsSnapshot> stats = pools.getStatsSnapshots();
+		if (stats["index"].total.diskreads != 0 || stats["index"].total.evictions != 0 ||
+				stats["data"].total.diskreads != num)
+		{
+			PRINT_ERROR("ERROR :: Scan of the data pool evicted pages of the index pool");
+		}
+
+		pools.setDefaultPool("index");
+		if (&pools.poolFor(&data) != &indexPool)
+		{
+			PRINT_ERROR("ERROR :: Default pool was not changed");
+		}
+		dataPool.flushFile(&data);
+		indexPool.flushFile(&index);
+	}
+
+	File::remove(dataName);
+	File::remove(indexName);
+	std::cout << "Test buffer pool set passed" << "\n";
+}
+
+/**
+ * Records the pages reported by BufMgr::pageEvicted().
+ */
+class EvictionRecorder : public BufEvictionListener
+{
+ public:
+	std::vector<std::pair<PageId, FrameId> > evicted;
+
+	void pageEvicted(const File* file, PageId pageNo, FrameId frame)
+	{
+		evicted.push_back(std::make_pair(pageNo, frame));
+	}
+};
+
+void testEvictionListener()
+{
+	const std::string& filename = "test.18";
+	const std::uint32_t bufs = 4;
+
+
+	{
+		File file = makeTestFile(filename);
+		PageId pageNo;
+		BufMgr mgr(bufs);
+		EvictionRecorder recorder;
+		mgr.setEvictionListener(&file, &recorder);
+
+		std::vector<FrameId> frames;
+		for (i = 0; i < bufs; i++)
+		{
+			PageHandle handle = mgr.allocPage(&file, pageNo);
+			frames.push_back(handle.frame());
+		}
+
+		// A hint naming the right frame and one naming a wrong frame both find the page.
+		for (i = 0; i < bufs; i++)
+		{
+			PageHandle right = mgr.readPageHinted(&file, i + 1, frames[i]);
+			PageHandle wrong = mgr.readPageHinted(&file, i + 1, frames[(i + 1) % bufs]);
+			if (right.frame() != frames[i] || wrong.frame() != frames[i] || right.get() != wrong.get())
+			{
+				PRINT_ERROR("ERROR :: Hinted read did not find the resident page");
+			}
+		}
+		if (!recorder.evicted.empty())
+		{
+			PRINT_ERROR("ERROR :: Eviction reported for a resident page");
+		}
+
+		// Every page that leaves its frame is reported with that frame.
+		for (i = 0; i < bufs; i++)
+		{
+			mgr.allocPage(&file, pageNo, page);
+			mgr.unPinPage(&file, pageNo, true);
+		}
+		if (recorder.evicted.size() != bufs)
+		{
+			PRINT_ERROR("ERROR :: Evictions were not all reported");
+		}
+		for (i = 0; i < recorder.evicted.size(); i++)
+		{
+			PageId evictedPage = recorder.evicted[i].first;
+			if (evictedPage < 1 || evictedPage > bufs || recorder.evicted[i].second != frames[evictedPage - 1])
+			{
+				PRINT_ERROR("ERROR :: Eviction reported the wrong page or frame");
+			}
+		}
+
+		// An evicted page is read again through its stale hint.
+		{
+			PageHandle handle = mgr.readPageHinted(&file, 1, frames[0]);
+			if (handle.pageNo() != 1)
+			{
+				PRINT_ERROR("ERROR :: Hinted read of an evicted page failed");
+			}
+		}
+
+		recorder.evicted.clear();
+		mgr.setEvictionListener(&file, NULL);
+		mgr.flushFile(&file);
+		if (!recorder.evicted.empty())
+		{
+			PRINT_ERROR("ERROR :: Eviction reported to a removed listener");
+		}
+	}
+
+	File::remove(filename);
+	std::cout << "Test eviction listener passed" << "\n";
+}
+
+void testWarmRestart()
+{
+	const std::string& filename = "test.19";
+	const std::string& manifestName = "test.19.manifest";
+	const PageId numPages = 30, bufs = 10, hotFirst = 5, hotPages = 5;
+
+	std::remove(manifestName.c_str());
+
+	{
+		File file = makeTestFile(filename);
+		File other = File::create(filename + ".other");
+		std::vector<File*> files(1, &file);
+		PageId pageNo;
+
+		try
+		{
+			BufMgr mgr(bufs);
+			mgr.warmUp(manifestName, files);
+			PRINT_ERROR("ERROR :: Warmed up from a manifest that does not exist");
+		}
+		catch(FileNotFoundException e)
+		{
+		}
+
+		{
+			BufMgr mgr(bufs, 1, LRU_K);
+			for (i = 0; i < numPages; i++)
+			{
+				mgr.allocPage(&file, pageNo, page);
+				mgr.unPinPage(&file, pageNo, true);
+			}
+			// Referenced twice, the hot pages outrank those of the trailing scan.
+			for (int pass = 0; pass < 2; pass++)
+			{
+				for (i = hotFirst; i < hotFirst + hotPages; i++)
+				{
+					mgr.readPage(&file, i, page);
+					mgr.unPinPage(&file, i, false);
+				}
+			}
+			for (i = numPages - (bufs - hotPages) + 1; i <= numPages; i++)
+			{
+				mgr.readPage(&file, i, page);
+				mgr.unPinPage(&file, i, false);
+			}
+			if (mgr.saveManifest(manifestName) != bufs)
+			{
+				PRINT_ERROR("ERROR :: Manifest does not list every resident page");
+			}
+			mgr.flushFile(&file);
+		}
+		BufManifest manifest = BufManifest::load(manifestName);
+		if (manifest.files.size() != 1 || manifest.files[0] != filename || manifest.entries.size() != bufs)
+		{
+			PRINT_ERROR("ERROR :: Manifest was not read back");
+		}
+		for (i = 0; i < hotPages; i++)
+		{
+			if (manifest.entries[i].pageNo < hotFirst || manifest.entries[i].pageNo >= hotFirst + hotPages)
+			{
+				PRINT_ERROR("ERROR :: Manifest does not list the hottest pages first");
+			}
+		}
+
+		// A restarted pool finds every listed page resident.
+		{
+			BufMgr mgr(bufs);
+			if (mgr.warmUp(manifestName, files) != bufs)
+			{
+				PRINT_ERROR("ERROR :: Warm-up did not load every listed page");
+			}
+			// The hot pages and those of the scan are two runs, read with one
+			// read each, and the warm-up itself is no miss.
+			BufStats warm = mgr.getBufStats();
+			if (warm.diskreads != bufs || warm.readLatency.count != 2 || warm.misses != 0)
+			{
+				PRINT_ERROR("ERROR :: Warm-up did not read neighbouring pages together");
+			}
+			mgr.clearBufStats();
+			for (i = 0; i < bufs; i++)
+			{
+				mgr.readPage(&file, manifest.entries[i].pageNo, page);
+				mgr.unPinPage(&file, manifest.entries[i].pageNo, false);
+			}
+			if (mgr.getBufStats().misses != 0)
+			{
+				PRINT_ERROR("ERROR :: Warmed-up pool missed listed pages");
+			}
+			mgr.flushFile(&file);
+		}
+
+		// A smaller pool only takes the hottest pages.
+		{
+			BufMgr mgr(hotPages - 1);
+			if (mgr.warmUp(manifestName, files) != hotPages - 1)
+			{
+				PRINT_ERROR("ERROR :: Warm-up loaded more pages than fit");
+			}
+			mgr.clearBufStats();
+			for (i = 0; i < hotPages - 1; i++)
+			{
+				mgr.readPage(&file, manifest.entries[i].pageNo, page);
+				mgr.unPinPage(&file, manifest.entries[i].pageNo, false);
+			}
+			if (mgr.getBufStats().hits != hotPages - 1)
+			{
+				PRINT_ERROR("ERROR :: Warm-up of a smaller pool did not load the hottest pages");
+			}
+			mgr.flushFile(&file);
+		}
+
+		// Background warm-up races with the reads but loads each page once.
+		{
+			BufMgr mgr(bufs);
+			if (mgr.warmUp(manifestName, files, true) != bufs)
+			{
+				PRINT_ERROR("ERROR :: Background warm-up did not queue every listed page");
+			}
+			for (i = 0; i < bufs; i++)
+			{
+				mgr.readPage(&file, manifest.entries[i].pageNo, page);
+				mgr.unPinPage(&file, manifest.entries[i].pageNo, false);
+			}
+			mgr.flushFile(&file);
+			if (mgr.getBufStats().diskreads != bufs)
+			{
+				PRINT_ERROR("ERROR :: Background warm-up loaded pages twice");
+			}
+		}
+
+		// Pages of files that are not open are skipped.
+		{
+			BufMgr mgr(bufs);
+			if (mgr.warmUp(manifestName, std::vector<File*>(1, &other)) != 0)
+			{
+				PRINT_ERROR("ERROR :: Warm-up loaded pages of a file that was not passed in");
+			}
+		}
+
+		// The flusher leaves a manifest behind when it stops.
+		std::remove(manifestName.c_str());
+		{
+			BufMgr mgr(bufs);
+			BufFlusherConfig config;
+			config.manifestPath = manifestName;
+			mgr.startFlusher(config);
+			mgr.readPage(&file, 1, page);
+			mgr.unPinPage(&file, 1, false);
+			mgr.stopFlusher();
+			if (BufManifest::load(manifestName).entries.size() != 1)
+			{
+				PRINT_ERROR("ERROR :: Flusher did not save a manifest on shutdown");
+			}
+			mgr.flushFile(&file);
+		}
+
+		std::ofstream(manifestName.c_str(), std::ios::trunc) << "not a manifest";
+		try
+		{
+			BufMgr mgr(bufs);
+			mgr.warmUp(manifestName, files);
+			PRINT_ERROR("ERROR :: Warmed up from a corrupt manifest");
+		}
+		catch(BadManifestException e)
+		{
+		}
+	}
+
+	File::remove(filename);
+	File::remove(filename + ".other");
+	std::remove(manifestName.c_str());
+	std::cout << "Test warm restart passed" << "\n";
+}
+
+void testVictimCache()
+{
+	// The codec restores empty, sparse and incompressible pages exactly.
+	{
+		char in[Page::SIZE], out[Page::SIZE], packed[Page::SIZE * 2];
+		for (int pattern = 0; pattern < 3; pattern++)
+		{
+			for (std::size_t b = 0; b < Page::SIZE; b++)
+			{
+				in[b] = pattern == 0 ? 0 : pattern == 1 ? (b % 1000 < 20 ? (char)b : 0) : (char)rand();
+			}
+			std::size_t length = VictimCache::compress(in, Page::SIZE, packed, sizeof(packed));
+			if (length == 0 || !VictimCache::decompress(packed, length, out, Page::SIZE)
+					|| memcmp(in, out, Page::SIZE) != 0)
+			{
+				PRINT_ERROR("ERROR :: Victim cache codec did not restore a page");
+			}
+			if (pattern == 0 && length > 16)
+			{
+				PRINT_ERROR("ERROR :: Victim cache codec did not compress an empty page");
+			}
+			if (pattern == 2 && VictimCache::compress(in, Page::SIZE, packed, VictimCache::MAX_STORED_SIZE) != 0)
+			{
+				PRINT_ERROR("ERROR :: Victim cache codec claimed to compress random data");
+			}
+			if (VictimCache::decompress(packed, length - 1, out, Page::SIZE))
+			{
+				PRINT_ERROR("ERROR :: Victim cache codec accepted truncated data");
+			}
+		}
+	}
+
+	const std::string& filename = "test.20";
+	const PageId bufs = 5, numPages = 20;
+
+
+	{
+		File file = makeTestFile(filename);
+		BufMgr mgr(bufs);
+		mgr.setVictimCacheSize(numPages * Page::SIZE / 4);
+		PageId pageNo;
+		for (i = 0; i < numPages; i++)
+		{
+			mgr.allocPage(&file, pageNo, page);
+			testRecord(filename, pageNo);
+			rid[i] = page->insertRecord(tmpbuf);
+			mgr.unPinPage(&file, pageNo, true);
+		}
+
+		// Reading the pages in order evicts each one before it is read again,
+		// and every one comes back from the tier without touching the disk.
+		mgr.clearBufStats();
+		for (i = 1; i <= numPages; i++)
+		{
+			mgr.readPage(&file, i, page);
+			testRecord(filename, i);
+			if (strncmp(page->getRecord(rid[i - 1]).c_str(), tmpbuf, strlen(tmpbuf)) != 0)
+			{
+				PRINT_ERROR("ERROR :: Page served from the victim cache has the wrong contents");
+			}
+			mgr.unPinPage(&file, i, false);
+		}
+		BufStats stats = mgr.getBufStats();
+		if (stats.victimhits != numPages || stats.diskreads != 0)
+		{
+			PRINT_ERROR("ERROR :: Evicted pages were not served from the victim cache");
+		}
+
+		// Pages taken from the tier are no longer in it, and disposed pages
+		// are not served from it afterwards.
+		mgr.disposePage(&file, 1);
+		mgr.clearBufStats();
+		for (i = 2; i <= numPages; i++)
+		{
+			mgr.readPage(&file, i, page);
+			mgr.unPinPage(&file, i, false);
+		}
+		if (mgr.getBufStats().diskreads != 0)
+		{
+			PRINT_ERROR("ERROR :: Victim cache lost pages");
+		}
+
+		// Flushing a file drops its pages from the tier.
+		mgr.flushFile(&file);
+		mgr.clearBufStats();
+		for (i = 2; i <= numPages; i++)
+		{
+			mgr.readPage(&file, i, page);
+			mgr.unPinPage(&file, i, false);
+		}
+		stats = mgr.getBufStats();
+		if (stats.victimhits != 0 || stats.diskreads != numPages - 1)
+		{
+			PRINT_ERROR("ERROR :: Flushed file was served from the victim cache");
+		}
+
+		// Without the tier every miss reads the disk.
+		mgr.setVictimCacheSize(0);
+		mgr.clearBufStats();
+		for (i = 2; i <= numPages; i++)
+		{
+			mgr.readPage(&file, i, page);
+			mgr.unPinPage(&file, i, false);
+		}
+		stats = mgr.getBufStats();
+		if (stats.victimhits != 0 || stats.diskreads != stats.misses)
+		{
+			PRINT_ERROR("ERROR :: Disabled victim cache served pages");
+		}
+		mgr.flushFile(&file);
+	}
+
+	File::remove(filename);
+	std::cout << "Test victim cache passed" << "\n";
+}
+
+void testTraceReplay()
+{
+	const std::string& filename = "test.21";
+	const std::string& traceName = "test.21.trace";
+	const PageId bufs = 8, numPages = 24;
+
+
+	BufStats recorded;
+	{
+		File file = makeTestFile(filename);
+		BufMgr mgr(bufs);
+		mgr.startTrace(traceName);
+		PageId pageNo;
+		for (i = 0; i < numPages; i++)
+		{
+			mgr.allocPage(&file, pageNo, page);
+			mgr.unPinPage(&file, pageNo, true);
+		}
+		// A hot set re-read between passes of a scan, some of it written.
+		for (int pass = 0; pass < 3; pass++)
+		{
+			for (i = 1; i <= numPages; i++)
+			{
+				mgr.readPage(&file, i, page);
+				{
+					PageHandle handle = mgr.readPage(&file, 1 + i % 4);
+					if (i % 3 == 0)
+					{
+						handle.markDirty();
+					}
+				}
+				mgr.unPinPage(&file, i, i % 5 == 0);
+			}
+		}
+		mgr.disposePage(&file, numPages);
+		mgr.flushFile(&file);
+		for (i = 1; i < 4; i++)
+		{
+			mgr.readPage(&file, i, page);
+			mgr.unPinPage(&file, i, false);
+		}
+		mgr.flushFile(&file);
+		recorded = mgr.getBufStats();
+		std::uint64_t calls = mgr.stopTrace();
+		if (calls != BufTrace::load(traceName).records.size())
+		{
+			PRINT_ERROR("ERROR :: Trace does not hold every recorded call");
+		}
+	}
+
+	BufTrace trace = BufTrace::load(traceName);
+	if (trace.numFiles != 1 || trace.records[0].op != TRACE_ALLOC || trace.records[1].op != TRACE_UNPIN_DIRTY
+			|| trace.records.back().op != TRACE_FLUSH)
+	{
+		PRINT_ERROR("ERROR :: Trace records the wrong calls");
+	}
+	for (std::size_t r = 1; r < trace.records.size(); r++)
+	{
+		if (trace.records[r].time < trace.records[r - 1].time)
+		{
+			PRINT_ERROR("ERROR :: Trace times go backwards");
+		}
+	}
+
+	// Replayed with the size and policy it was recorded with, the trace
+	// reproduces the pool's statistics exactly.
+	{
+		BufSimulator sim(bufs, CLOCK);
+		sim.replay(trace);
+		const BufStats& stats = sim.getStats();
+		if (stats.accesses != recorded.accesses || stats.hits != recorded.hits || stats.misses != recorded.misses
+				|| stats.allocs != recorded.allocs || stats.diskreads != recorded.diskreads
+				|| stats.diskwrites != recorded.diskwrites || sim.failedPins() != 0)
+		{
+			PRINT_ERROR("ERROR :: Replay does not match the recorded pool");
+		}
+	}
+
+	// A pool holding every page only misses after the files were flushed,
+	// and every policy gets a result.
+	{
+		BufSimulator sim(numPages, ARC);
+		sim.replay(trace);
+		if (sim.getStats().misses != 3 || sim.getStats().hits <= recorded.hits)
+		{
+			PRINT_ERROR("ERROR :: Replay with a larger pool is wrong");
+		}
+		BufSimulator tiny(1, TWO_Q);
+		tiny.replay(trace);
+		if (tiny.failedPins() == 0)
+		{
+			PRINT_ERROR("ERROR :: Replay with one frame did not run out of frames");
+		}
+	}
+
+	std::ofstream(traceName.c_str(), std::ios::app) << "torn";
+	try
+	{
+		BufTrace::load(traceName);
+		PRINT_ERROR("ERROR :: Loaded a trace with a torn record");
+	}
+	catch(BadTraceException e)
+	{
+	}
+
+	File::remove(filename);
+	std::remove(traceName.c_str());
+	std::cout << "Test trace replay passed" << "\n";
+}
+
+void testHitRatioCurve()
+{
+	const std::string& filename = "test.22";
+	const PageId bufs = 20, numPages = 80, loop = 30;
+
+
+	{
+		File file = makeTestFile(filename);
+		BufMgr mgr(bufs);
+		// A pool this small needs every page sampled for exact estimates.
+		mgr.setHitRatioSampleRate(1);
+		if (!mgr.getStatsSnapshot().hitRatioCurve.empty())
+		{
+			PRINT_ERROR("ERROR :: Hit ratio estimated without reads");
+		}
+		PageId pageNo;
+		for (i = 0; i < numPages; i++)
+		{
+			mgr.allocPage(&file, pageNo, page);
+			mgr.unPinPage(&file, pageNo, false);
+		}
+		// A loop over more pages than the pool holds never hits in LRU
+		// pools smaller than the loop, and always in larger ones.
+		for (int pass = 0; pass < 2; pass++)
+		{
+			mgr.clearBufStats();
+			for (int repeat = 0; repeat < 10; repeat++)
+			{
+				for (i = 1; i <= loop; i++)
+				{
+					mgr.readPage(&file, i, page);
+					mgr.unPinPage(&file, i, false);
+				}
+			}
+		}
+		BufStatsSnapshot snapshot = mgr.getStatsSnapshot();
+		const std::vector<BufHitRatioEstimate>& curve = snapshot.hitRatioCurve;
+		if (curve.size() != 4 || curve[0].numBufs != bufs / 2 || curve[1].numBufs != bufs
+				|| curve[2].numBufs != bufs * 2 || curve[3].numBufs != bufs * 4)
+		{
+			PRINT_ERROR("ERROR :: Hit ratio curve has the wrong sizes");
+		}
+		if (curve[0].hitRatio != 0 || curve[1].hitRatio != 0 || curve[2].hitRatio != 1 || curve[3].hitRatio != 1)
+		{
+			PRINT_ERROR("ERROR :: Hit ratio curve of a loop is wrong");
+		}
+		if (snapshot.toJson().find("\"hitRatioCurve\":[{\"numBufs\":10,\"hitRatio\":0}") == std::string::npos
+				|| snapshot.toPrometheus().find("badgerdb_buffer_estimated_hit_ratio{frames=\"40\"} 1\n") == std::string::npos)
+		{
+			PRINT_ERROR("ERROR :: Hit ratio curve is not exported");
+		}
+
+		// Large partitions only track a sample of the pages. Uniform reads
+		// hit in LRU in proportion to the share of the pages held.
+		const std::uint32_t frames = 4096, distinct = 8192;
+		MrcEstimator estimator(frames, 1);
+		srand(22);
+		for (int r = 0; r < 400000; r++)
+		{
+			if (r == 100000)
+			{
+				estimator.clearCounts();
+			}
+			estimator.pageRead(&file, 1 + (rand() % distinct));
+		}
+		for (int s = 0; s < MrcEstimator::NUM_SIZES; s++)
+		{
+			double expected = estimator.poolSize(s) >= distinct ? 1.0 : (double) estimator.poolSize(s) / distinct;
+			double estimate = estimator.estimatedHits(s) / estimator.estimatedReads();
+			if (estimate < expected - 0.05 || estimate > expected + 0.05)
+			{
+				PRINT_ERROR("ERROR :: Sampled hit ratio estimate is off");
+			}
+		}
+		mgr.flushFile(&file);
+	}
+
+	File::remove(filename);
+	std::cout << "Test hit ratio curve passed" << "\n";
+}
+
+void testAsyncRead()
+{
+	const std::string& filename = "test.23";
+	const PageId bufs = 40, numPages = 30;
+
+	{
+		File file = makeTestFile(filename, numPages, rid);
+		BufMgr mgr(bufs);
+		// Completed reads hold their frames until their callbacks run, so
+		// the pool has room for all of them; none of the pages is resident.
+		const std::thread::id owner = std::this_thread::get_id();
+
+		// A resident page is passed on before the call returns.
+		{
+			AsyncPageScheduler scheduler(mgr);
+			mgr.readPage(&file, 1, page);
+			mgr.unPinPage(&file, 1, false);
+			bool called = false;
+			scheduler.readPage(&file, 1, [&called](PageHandle handle, std::exception_ptr error) {
+				called = !error && handle && handle.pageNo() == 1;
+			});
+			if (!called || scheduler.outstanding() != 0)
+			{
+				PRINT_ERROR("ERROR :: Resident page was not passed on at once");
+			}
+		}
+
+		// One thread keeps a read of every page going; the callbacks of the
+		// misses run on it when it calls run(). Only page 1 is resident.
+		{
+			AsyncPageScheduler scheduler(mgr);
+			mgr.clearBufStats();
+			int completed = 0, wrong = 0;
+			for (i = 1; i <= numPages; i++)
+			{
+				PageId expected = i;
+				scheduler.readPage(&file, expected, [&, expected](PageHandle handle, std::exception_ptr error) {
+					char record[100];
+					sprintf(record, "test.23 Page %d %7.1f", expected, (float)expected);
+					if (error || std::this_thread::get_id() != owner
+							|| strncmp(handle->getRecord(rid[expected - 1]).c_str(), record, strlen(record)) != 0)
+					{
+						wrong++;
+					}
+					completed++;
+				});
+			}
+			scheduler.run();
+			BufStats stats = mgr.getBufStats();
+			if (completed != (int) numPages || wrong != 0 || scheduler.outstanding() != 0)
+			{
+				PRINT_ERROR("ERROR :: Asynchronous reads did not complete on the calling thread");
+			}
+			if (stats.hits != 1 || stats.misses != numPages - 1)
+			{
+				PRINT_ERROR("ERROR :: Asynchronous reads were not counted");
+			}
+		}
+
+		// Callbacks start further reads, one after the other, as in a descent.
+		{
+			AsyncPageScheduler scheduler(mgr);
+			int depth = 0;
+			std::function<void(PageHandle, std::exception_ptr)> step;
+			step = [&](PageHandle handle, std::exception_ptr error) {
+				if (error || handle.pageNo() != (PageId) depth + 1)
+				{
+					return;
+				}
+				depth++;
+				if (depth < (int) numPages)
+				{
+					scheduler.readPage(&file, depth + 1, step);
+				}
+			};
+			scheduler.readPage(&file, 1, step);
+			scheduler.run();
+			if (depth != (int) numPages)
+			{
+				PRINT_ERROR("ERROR :: Chained asynchronous reads did not complete");
+			}
+		}
+
+		// A failed read delivers its exception to the callback.
+		{
+			AsyncPageScheduler scheduler(mgr);
+			bool failed = false;
+			scheduler.readPage(&file, numPages + 100, [&failed](PageHandle handle, std::exception_ptr error) {
+				try
+				{
+					if (error)
+					{
+						std::rethrow_exception(error);
+					}
+				}
+				catch(InvalidPageException e)
+				{
+					failed = !handle;
+				}
+			});
+			scheduler.run();
+			if (!failed)
+			{
+				PRINT_ERROR("ERROR :: Failed asynchronous read did not report the exception");
+			}
+		}
+
+		// Posted tasks run from runOnce() as well.
+		{
+			AsyncPageScheduler scheduler(mgr);
+			int ran = 0;
+			scheduler.post([&ran]() { ran++; });
+			scheduler.post([&ran]() { ran++; });
+			if (scheduler.outstanding() != 2 || scheduler.runOnce() != 2 || ran != 2 || scheduler.runOnce() != 0)
+			{
+				PRINT_ERROR("ERROR :: Posted tasks did not run");
+			}
+		}
+
+		// No page is left pinned.
+		mgr.flushFile(&file);
+	}
+
+	File::remove(filename);
+	std::cout << "Test asynchronous read passed" << "\n";
+}
+
+#ifdef __cpp_impl_coroutine
+PageTask readPagesInTurn(AsyncPageScheduler& scheduler, File* file, PageId first, PageId last,
+		std::vector<PageHandle>& held, int& failures)
+{
+	for (PageId pageNo = first; pageNo <= last; pageNo++)
+	{
+		try
+		{
+			PageHandle handle = co_await scheduler.readPageAsync(file, pageNo);
+			held.push_back(std::move(handle));
+		}
+		catch(InvalidPageException e)
+		{
+			failures++;
+		}
+	}
+}
+
+void testCoroutineRead()
+{
+	const std::string& filename = "test.27";
+	const PageId bufs = 40, numPages = 30;
+
+	{
+		File file = makeTestFile(filename, numPages, rid);
+		BufMgr mgr(bufs);
+		mgr.readPage(&file, 1, page);
+		mgr.unPinPage(&file, 1, false);
+
+		// Page 1 is resident, so the coroutine runs on past it and suspends
+		// on the miss of page 2; run() resumes it for each further miss.
+		{
+			AsyncPageScheduler scheduler(mgr);
+			std::vector<PageHandle> held;
+			int failures = 0;
+			mgr.clearBufStats();
+			readPagesInTurn(scheduler, &file, 1, numPages, held, failures);
+			if (held.size() != 1 || held[0].pageNo() != 1 || scheduler.outstanding() != 1)
+			{
+				PRINT_ERROR("ERROR :: Coroutine did not continue past the resident page");
+			}
+			scheduler.run();
+			BufStats stats = mgr.getBufStats();
+			if (held.size() != numPages || failures != 0 || stats.hits != 1 || stats.misses != numPages - 1)
+			{
+				PRINT_ERROR("ERROR :: Coroutine did not read every page");
+			}
+			for (i = 0; i < held.size(); i++)
+			{
+				testRecord(filename, i + 1);
+				if (held[i].pageNo() != i + 1
+						|| strncmp(held[i]->getRecord(rid[i]).c_str(), tmpbuf, strlen(tmpbuf)) != 0)
+				{
+					PRINT_ERROR("ERROR :: Coroutine read the wrong page");
+				}
+			}
+
+			// The handles the coroutine handed out keep their pages pinned.
+			bool pinned = false;
+			try
+			{
+				mgr.flushFile(&file);
+			}
+			catch(PagePinnedException e)
+			{
+				pinned = true;
+			}
+			if (!pinned)
+			{
+				PRINT_ERROR("ERROR :: Page read by the coroutine was not pinned");
+			}
+			held.clear();
+		}
+
+		// A failed read throws from co_await and leaves nothing pinned.
+		{
+			AsyncPageScheduler scheduler(mgr);
+			std::vector<PageHandle> held;
+			int failures = 0;
+			readPagesInTurn(scheduler, &file, numPages + 100, numPages + 100, held, failures);
+			scheduler.run();
+			if (failures != 1 || !held.empty())
+			{
+				PRINT_ERROR("ERROR :: Failed read did not throw from co_await");
+			}
+		}
+
+		// No page is left pinned.
+		mgr.flushFile(&file);
+	}
+
+	File::remove(filename);
+	std::cout << "Test coroutine read passed" << "\n";
+}
+#endif
+
+void testReadPages()
+{
+	const std::string& filename = "test.24";
+	const PageId numPages = 40;
+
+	{
+		File file = makeTestFile(filename, numPages, rid);
+		for (std::uint32_t parts = 1; parts <= 4; parts += 3)
+		{
+			BufMgr mgr(50, parts);
+			mgr.readPage(&file, 1, page);
+			mgr.unPinPage(&file, 1, false);
+			mgr.readPage(&file, 5, page);
+			mgr.unPinPage(&file, 5, false);
+
+			// Pages 1 and 5 are hits. The misses 2, 3, 7 and 8 are close enough
+			// to be read together, as are 20 and 21, and 39 and 40.
+			mgr.clearBufStats();
+			const PageId listed[] = {7, 3, 3, 1, 2, 8, 20, 21, 5, 40, 39, 3};
+			std::vector<PageId> pageNos(listed, listed + sizeof(listed) / sizeof(listed[0]));
+			std::vector<Page*> pages;
+			mgr.readPages(&file, pageNos, pages);
+			for (std::size_t p = 0; p < pageNos.size(); p++)
+			{
+				testRecord(filename, pageNos[p]);
+				if (pages[p]->page_number() != pageNos[p]
+						|| strncmp(pages[p]->getRecord(rid[pageNos[p] - 1]).c_str(), tmpbuf, strlen(tmpbuf)) != 0)
+				{
+					PRINT_ERROR("ERROR :: Page read by readPages() has the wrong contents");
+				}
+			}
+			BufStats stats = mgr.getBufStats();
+			if (stats.accesses != pageNos.size() || stats.misses != 8 || stats.diskreads != 8)
+			{
+				PRINT_ERROR("ERROR :: readPages() did not read each missing page once");
+			}
+			if (parts == 1 && stats.readLatency.count != 3)
+			{
+				PRINT_ERROR("ERROR :: readPages() did not coalesce neighbouring misses");
+			}
+			// Every entry holds a pin of its own.
+			for (std::size_t p = 0; p < pageNos.size(); p++)
+			{
+				mgr.unPinPage(&file, pageNos[p], false);
+			}
+			try
+			{
+				mgr.unPinPage(&file, 3, false);
+				PRINT_ERROR("ERROR :: Page listed three times was pinned more than three times");
+			}
+			catch(PageNotPinnedException e)
+			{
+			}
+
+			// Handles unpin the pages themselves.
+			{
+				std::vector<PageHandle> handles = mgr.readPages(&file, pageNos);
+				if (handles.size() != pageNos.size() || handles[0].pageNo() != 7 || handles[1]->page_number() != 3)
+				{
+					PRINT_ERROR("ERROR :: readPages() returned the wrong handles");
+				}
+			}
+
+			// A failed call leaves no page pinned, which flushFile() checks.
+			pageNos.push_back(numPages + 100);
+			try
+			{
+				mgr.readPages(&file, pageNos, pages);
+				PRINT_ERROR("ERROR :: readPages() read a page that does not exist");
+			}
+			catch(InvalidPageException e)
+			{
+			}
+			BufMgr small(5, parts);
+			pageNos.pop_back();
+			try
+			{
+				small.readPages(&file, pageNos, pages);
+				PRINT_ERROR("ERROR :: readPages() pinned more pages than the pool holds");
+			}
+			catch(BufferExceededException e)
+			{
+			}
+			small.flushFile(&file);
+			mgr.flushFile(&file);
+		}
+	}
+
+	File::remove(filename);
+	std::cout << "Test batched read passed" << "\n";
+}
+
+void testAccessHints()
+{
+	const std::string& filename = "test.25";
+	const PageId bufs = 4;
+	const ReplacementPolicyType policies[] = {CLOCK, LRU_K, TWO_Q, ARC};
+	const char* policyNames[] = {"CLOCK", "LRU_K", "TWO_Q", "ARC"};
+
+	{
+		File file = makeTestFile(filename, bufs + 3);
+
+		for (int p = 0; p < 4; p++)
+		{
+			// A page kept hot outlives pages loaded after it, which would
+			// otherwise have evicted it first.
+			{
+				BufMgr mgr(bufs, 1, policies[p]);
+				for (i = 1; i <= bufs; i++)
+				{
+					PageHandle handle = mgr.readPage(&file, i);
+					if (i == 1)
+					{
+						handle.setHint(KEEP_HOT);
+					}
+				}
+				for (i = bufs + 1; i <= bufs + 3; i++)
+				{
+					mgr.readPage(&file, i, page);
+					mgr.unPinPage(&file, i, false);
+				}
+				mgr.clearBufStats();
+				mgr.readPage(&file, 1, page);
+				mgr.unPinPage(&file, 1, false);
+				if (mgr.getBufStats().hits != 1)
+				{
+					PRINT_ERROR(std::string("ERROR :: Page kept hot was evicted by ") + policyNames[p]);
+				}
+				mgr.flushFile(&file);
+			}
+
+			// Hot frames delay the hand but must not make pinned frames count
+			// twice and the pool look full.
+			{
+				BufMgr mgr(bufs, 1, policies[p]);
+				Page* pinned[2];
+				mgr.readPage(&file, 1, pinned[0]);
+				mgr.readPage(&file, 2, pinned[1]);
+				for (i = 3; i <= bufs; i++)
+				{
+					mgr.readPage(&file, i, page);
+					mgr.unPinPage(&file, i, false, KEEP_HOT);
+				}
+				try
+				{
+					mgr.readPage(&file, bufs + 1, page);
+					mgr.unPinPage(&file, bufs + 1, false);
+				}
+				catch(BufferExceededException e)
+				{
+					PRINT_ERROR(std::string("ERROR :: Pool with hot frames reported full by ") + policyNames[p]);
+				}
+				mgr.unPinPage(&file, 1, false);
+				mgr.unPinPage(&file, 2, false);
+				mgr.flushFile(&file);
+			}
+
+			// A page to be evicted soon goes before pages read as often.
+			{
+				BufMgr mgr(bufs, 1, policies[p]);
+				for (int pass = 0; pass < 2; pass++)
+				{
+					for (i = 1; i <= bufs; i++)
+					{
+						mgr.readPage(&file, i, page);
+						mgr.unPinPage(&file, i, false, pass == 1 && i == 2 ? EVICT_SOON : NORMAL);
+					}
+				}
+				mgr.readPage(&file, bufs + 1, page);
+				mgr.unPinPage(&file, bufs + 1, false);
+				mgr.clearBufStats();
+				mgr.readPage(&file, 2, page);
+				mgr.unPinPage(&file, 2, false);
+				if (mgr.getBufStats().misses != 1)
+				{
+					PRINT_ERROR(std::string("ERROR :: Page to be evicted soon was kept by ") + policyNames[p]);
+				}
+				mgr.flushFile(&file);
+			}
+		}
+	}
+
+	File::remove(filename);
+	std::cout << "Test access hints passed" << "\n";
+}
+
+void testAdmissionFilter()
+{
+	const std::string& filename = "test.26";
+	const PageId bufs = 64;
+	const PageId hotPages = 32;
+	const PageId burstPages = 200;
+
+	{
+		File file = makeTestFile(filename, hotPages + 2 * burstPages);
+
+		// Counters saturate at MAX_COUNT without spilling into the counter
+		// sharing their byte, and aging halves them.
+		{
+			AdmissionFilter sketch(bufs);
+			for (i = 0; i < 2 * AdmissionFilter::MAX_COUNT; i++)
+			{
+				sketch.pageRead(&file, 1);
+			}
+			if (sketch.estimate(&file, 1) != AdmissionFilter::MAX_COUNT)
+			{
+				PRINT_ERROR("ERROR :: Admission filter counter did not saturate");
+			}
+			for (i = 2; i <= hotPages; i++)
+			{
+				if (sketch.estimate(&file, i) != 0)
+				{
+					PRINT_ERROR("ERROR :: Admission filter counter spilled into its neighbour");
+				}
+			}
+			for (i = 0; i < 100000 && sketch.estimate(&file, 1) == AdmissionFilter::MAX_COUNT; i++)
+			{
+				sketch.pageRead(&file, 2);
+			}
+			if (sketch.estimate(&file, 1) != AdmissionFilter::MAX_COUNT / 2)
+			{
+				PRINT_ERROR("ERROR :: Admission filter counts were not halved");
+			}
+		}
+
+		for (int filter = 0; filter < 2; filter++)
+		{
+			BufMgr mgr(bufs);
+			mgr.setAdmissionFilter(filter == 1);
+			// Read the hot pages a few times, then two bursts of pages read
+			// once, the first of which fills the probationary area.
+			for (int pass = 0; pass < 4; pass++)
+			{
+				for (i = 1; i <= hotPages; i++)
+				{
+					mgr.readPage(&file, i, page);
+					mgr.unPinPage(&file, i, false);
+				}
+			}
+			for (int burst = 0; burst < 2; burst++)
+			{
+				for (i = hotPages + burst * burstPages + 1; i <= hotPages + (burst + 1) * burstPages; i++)
+				{
+					mgr.readPage(&file, i, page);
+					mgr.unPinPage(&file, i, false);
+				}
+				if (burst == 0)
+				{
+					for (i = 1; i <= hotPages; i++)
+					{
+						mgr.readPage(&file, i, page);
+						mgr.unPinPage(&file, i, false);
+					}
+					mgr.clearBufStats();
+				}
+			}
+			BufStats burstStats = mgr.getBufStats();
+			mgr.clearBufStats();
+			for (i = 1; i <= hotPages; i++)
+			{
+				mgr.readPage(&file, i, page);
+				mgr.unPinPage(&file, i, false);
+			}
+			BufStats stats = mgr.getBufStats();
+			if (filter == 0 && stats.hits == hotPages)
+			{
+				PRINT_ERROR("ERROR :: Hot pages survived a burst without the admission filter");
+			}
+			if (filter == 1 && (stats.hits != hotPages || burstStats.rejections == 0 ||
+					burstStats.rejections > burstStats.misses))
+			{
+				PRINT_ERROR("ERROR :: Burst of pages read once displaced hot pages despite the admission filter");
+			}
+			mgr.flushFile(&file);
+		}
+	}
+
+	File::remove(filename);
+	std::cout << "Test admission filter passed" << "\n";
+}
+
+void testConcurrentMisses()
+{
+	const std::string& filename = "test.28";
+	const PageId bufs = 32, parts = 4;
+	const int threads = 4, opsPerThread = 2000;
+
+
+	{
+		File file = makeTestFile(filename);
+		std::vector<int> versions(num + 1, 0);
+		{
+			BufMgr mgr(bufs, parts);
+			PageId pageNo;
+			for (i = 0; i < num; i++)
+			{
+				mgr.allocPage(&file, pageNo, page);
+				sprintf(tmpbuf, "test.28 Page %4d v%6d", pageNo, 0);
+				rid[i] = page->insertRecord(tmpbuf);
+				mgr.unPinPage(&file, pageNo, true);
+			}
+			mgr.flushFile(&file);
+		}
+
+		// Threads miss on pages of the same partitions at once, and dirty victims are written back while
+		// other pages are read. Each thread updates the pages it owns and must read back its last version.
+		{
+			BufMgr mgr(bufs, parts);
+			std::atomic<int> wrong(0);
+			std::vector<std::thread> workers;
+			for (int t = 0; t < threads; t++)
+			{
+				workers.push_back(std::thread([&mgr, &file, &versions, &wrong, t, threads, opsPerThread]()
+				{
+					unsigned int seed = t + 1;
+					char record[100];
+					for (int op = 0; op < opsPerThread; op++)
+					{
+						seed = seed * 1103515245 + 12345;
+						PageId pageNo = (seed >> 16) % num + 1;
+						PageHandle handle = mgr.readPage(&file, pageNo);
+						if (handle->page_number() != pageNo)
+						{
+							wrong++;
+						}
+						// Pins do not keep others from writing, so only the owner looks at the record.
+						if ((int) (pageNo % threads) == t)
+						{
+							sprintf(record, "test.28 Page %4d v%6d", pageNo, versions[pageNo]);
+							if (handle->getRecord(rid[pageNo - 1]) != record)
+							{
+								wrong++;
+							}
+							sprintf(record, "test.28 Page %4d v%6d", pageNo, ++versions[pageNo]);
+							handle.getMutable()->updateRecord(rid[pageNo - 1], record);
+						}
+					}
+				}));
+			}
+			for (int t = 0; t < threads; t++)
+			{
+				workers[t].join();
+			}
+			if (wrong != 0)
+			{
+				PRINT_ERROR("ERROR :: Concurrent misses read a wrong or stale page");
+			}
+			if (mgr.getBufStats().stalledevictions == 0)
+			{
+				PRINT_ERROR("ERROR :: Concurrent misses did not evict dirty pages");
+			}
+			mgr.flushFile(&file);
+		}
+
+		// Every last version reached the disk.
+		{
+			BufMgr mgr(bufs);
+			for (i = 1; i <= num; i++)
+			{
+				mgr.readPage(&file, i, page);
+				sprintf(tmpbuf, "test.28 Page %4d v%6d", i, versions[i]);
+				if (page->getRecord(rid[i - 1]) != tmpbuf)
+				{
+					PRINT_ERROR("ERROR :: Page written back during a concurrent miss was lost");
+				}
+				mgr.unPinPage(&file, i, false);
+			}
+			mgr.flushFile(&file);
+		}
+	}
+
+	File::remove(filename);
+	std::cout << "Test concurrent misses passed" << "\n";
+}
+
+void benchBufMgr()
+{
+	const std::string& filename = "bench.1";
+	const PageId benchPages = 256;
+
+	{
+		// Populate the file through a buffer manager so the benchmark only measures hits.
+		File file = makeTestFile(filename, benchPages);
+
+		unsigned int cores = std::thread::hardware_concurrency();
+		unsigned int nthreads = cores;
+		if (nthreads < 4)
+			nthreads = 4;
+
+		std::cout << "\n" << "Buffer manager throughput, " << nthreads << " threads, all hits, hardware_concurrency=" << cores << ":" << "\n";
+		if (cores < 2)
+		{
+			// The threads take turns on one core, so they never contend for a latch.
+			std::cout << "  (one core: partitioning cannot show any scaling here)" << "\n";
+		}
+		benchPartitions(&file, 1, nthreads);
+		benchPartitions(&file, 16, nthreads);
+		benchOptimisticRead(&file, nthreads);
+	}
+
+	File::remove(filename);
+}
+
+void benchPartitions(File* file, std::uint32_t parts, unsigned int nthreads)
+{
+	const PageId benchPages = 256;
+	const int opsPerThread = 200000;
+
+	BufMgr mgr(2 * benchPages, parts);
+
+	// Warm up the pool so every page is resident.
+	for (PageId p = 1; p <= benchPages; p++)
+	{
+		Page* warm;
+		mgr.readPage(file, p, warm);
+		mgr.unPinPage(file, p, false);
+	}
+
+	std::vector<std::thread> threads;
+	auto start = std::chrono::steady_clock::now();
+	for (unsigned int t = 0; t < nthreads; t++)
+	{
+		threads.push_back(std::thread([&mgr, file, t, benchPages, opsPerThread]()
+		{
+			unsigned int seed = t * 7919 + 1;
+			for (int op = 0; op < opsPerThread; op++)
+			{
+				seed = seed * 1103515245 + 12345;
+				PageId p = 1 + (seed >> 8) % benchPages;
+				Page* hit;
+				mgr.readPage(file, p, hit);
+				mgr.unPinPage(file, p, false);
+			}
+		}));
+	}
+	for (unsigned int t = 0; t < nthreads; t++)
+		threads[t].join();
+	auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+
+	double ops = (double)nthreads * opsPerThread;
+	std::cout << "  partitions=" << parts << ": " << (long)(ops / (elapsed / 1e6)) << " readPage+unPinPage/s" << "\n";
+}
+
+void benchOptimisticRead(File* file, unsigned int nthreads)
+{
+	const PageId benchPages = 256;
+	const int opsPerThread = 200000;
+
+	BufMgr mgr(2 * benchPages);
+
+	for (PageId p = 1; p <= benchPages; p++)
+	{
+		Page* warm;
+		mgr.readPage(file, p, warm);
+		mgr.unPinPage(file, p, false);
+	}
+
+	std::vector<std::thread> threads;
+	auto start = std::chrono::steady_clock::now();
+	for (unsigned int t = 0; t < nthreads; t++)
+	{
+		threads.push_back(std::thread([&mgr, file, t, benchPages, opsPerThread]()
+		{
+			// Each thread remembers the frame of every page, as an index does for its inner nodes.
+			std::vector<FrameId> hints(benchPages + 1, OptimisticRead::NO_FRAME);
+			unsigned int seed = t * 7919 + 1;
+			for (int op = 0; op < opsPerThread; op++)
+			{
+				seed = seed * 1103515245 + 12345;
+				PageId p = 1 + (seed >> 8) % benchPages;
+				OptimisticRead read(hints[p]);
+				if (mgr.readOptimistic(file, p, read) && mgr.validate(read))
+					hints[p] = read.frame;
+			}
+		}));
+	}
+	for (unsigned int t = 0; t < nthreads; t++)
+		threads[t].join();
+	auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+
+	double ops = (double)nthreads * opsPerThread;
+	std::cout << "  optimistic, hinted: " << (long)(ops / (elapsed / 1e6)) << " readOptimistic+validate/s" << "\n";
+}
+
+void benchLookupMiss()
+{
+	const std::string& filename = "bench.2";
+	const int misses = 200000;
+
+
+	{
+		File file = makeTestFile(filename);
+		BufHashTbl table(num);
+		for (i = 0; i < num; i++)
+			table.insert(&file, i + 1, i);
+
+		// Before: a miss is reported by HashNotFoundException.
+		FrameId frameNo;
+		int found = 0;
+		auto start = std::chrono::steady_clock::now();
+		for (int m = 0; m < misses; m++)
+		{
+			try
+			{
+				table.lookup(&file, num + 1 + m, frameNo);
+				found++;
+			}
+			catch(HashNotFoundException& e)
+			{
+			}
+		}
+		auto throwing = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+
+		// After: a miss is a false return value.
+		start = std::chrono::steady_clock::now();
+		for (int m = 0; m < misses; m++)
+		{
+			if (table.find(&file, num + 1 + m, frameNo))
+				found++;
+		}
+		auto nonThrowing = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+
+		if (found != 0)
+		{
+			PRINT_ERROR("ERROR :: Lookup of absent page reported a frame");
+		}
+
+		std::cout << "\n" << "Hash table miss latency:" << "\n";
+		std::cout << "  lookup (throws): " << throwing / misses << " ns/miss" << "\n";
+		std::cout << "  find (no throw): " << nonThrowing / misses << " ns/miss" << "\n";
+	}
+
+	File::remove(filename);
+}
+
+void benchFlushFile()
+{
+	const std::string& filename = "bench.3";
+	const std::uint32_t poolFrames = 1 << 20;
+	const int numFiles = 1000;
+	const PageId pagesPerFile = 4;
+
+	// Only the frames actually used get memory, so a 1M-frame pool is cheap here.
+	BufMgr mgr(poolFrames, 8);
+	long long flushNs = 0;
+	for (int f = 0; f < numFiles; f++)
+	{
+		{
+			File file = makeTestFile(filename);
+			PageId pageNo;
+			for (i = 0; i < pagesPerFile; i++)
+			{
+				mgr.allocPage(&file, pageNo, page);
+				mgr.unPinPage(&file, pageNo, true);
+			}
+
+			// Closing a file flushes it; time only that part.
+			auto start = std::chrono::steady_clock::now();
+			mgr.flushFile(&file);
+			flushNs += std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+		}
+	}
+	File::remove(filename);
+
+	std::cout << "\n" << "Closing " << numFiles << " files of " << pagesPerFile << " pages against a "
+						<< poolFrames << "-frame pool:" << "\n";
+	std::cout << "  flushFile: " << flushNs / numFiles / 1000 << " us/file, " << flushNs / 1000000 << " ms total" << "\n";
+}
+
+void benchWriteBack()
+{
+	const std::string& filename = "bench.4";
+	const PageId benchPages = 2048;
+
+
+	{
+		File file = makeTestFile(filename);
+		std::vector<Page> pages;
+		for (i = 0; i < benchPages; i++)
+		{
+			pages.push_back(file.allocatePage());
+			pages.back().insertRecord("bench.4");
+		}
+
+		// Dirty pages come out of the pool in no particular order.
+		std::vector<const Page*> order;
+		for (i = 0; i < benchPages; i++)
+		{
+			order.push_back(&pages[(i * 7919) % benchPages]);
+		}
+
+		// Before: one seek, write and flush per page.
+		auto start = std::chrono::steady_clock::now();
+		for (i = 0; i < benchPages; i++)
+		{
+			file.writePage(*order[i]);
+		}
+		auto single = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+
+		// After: sorted, coalesced into runs and flushed once.
+		start = std::chrono::steady_clock::now();
+		file.writePages(order);
+		auto batched = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+
+		std::cout << "\n" << "Writing back " << benchPages << " dirty pages:" << "\n";
+		std::cout << "  writePage per page: " << single / 1000 << " ms" << "\n";
+		std::cout << "  writePages batch:   " << batched / 1000 << " ms" << "\n";
+	}
+
+	File::remove(filename);
+}
@@ -0,0 +1,114 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
+ */
+
+#include "mrc_estimator.h"
+#include "bufHashTbl.h"
+
+namespace badgerdb {
+
+const int MrcEstimator::NUM_SIZES;
+const double MrcEstimator::SIZE_FACTORS[NUM_SIZES] = {0.5, 1, 2, 4};
+const double MrcEstimator::DEFAULT_MAX_RATE = 1.0 / 64;
+const std::uint32_t MrcEstimator::MAX_SAMPLED;
+const std::uint32_t MrcEstimator::SAMPLE_SCALE;
+
+MrcEstimator::MrcEstimator(std::uint32_t numFrames, double maxRate)
+  : maxRate(maxRate)
+{
+  resize(numFrames);
+}
+
+void MrcEstimator::setMaxRate(double newMaxRate)
+{
+  maxRate = newMaxRate;
+  resize(sizes[1]);
+}
+
+void MrcEstimator::resize(std::uint32_t numFrames)
+{
+  for (int s = 0; s < NUM_SIZES; s++) {
+    sizes[s] = (std::uint32_t) (numFrames * SIZE_FACTORS[s]);
+    if (sizes[s] == 0)
+      sizes[s] = 1;
+    segments[s].clear();
+  }
+  index.clear();
+  rate = (double) MAX_SAMPLED / sizes[NUM_SIZES - 1];
+  if (rate > maxRate)
+    rate = maxRate;
+  if (rate > 1)
+    rate = 1;
+  threshold = (std::uint32_t) (rate * SAMPLE_SCALE);
+  // The rate actually applied, after rounding the threshold.
+  rate = (double) threshold / SAMPLE_SCALE;
+  // A segment may end up empty at low rates; pages then pass through it
+  // and only hit at the larger sizes.
+  std::size_t end = 0;
+  for (int s = 0; s < NUM_SIZES; s++) {
+    std::size_t next = (std::size_t) (sizes[s] * rate + 0.5);
+    capacity[s] = next > end ? next - end : 0;
+    if (next > end)
+      end = next;
+  }
+  clearCounts();
+}
+
+void MrcEstimator::pageRead(const File* file, PageId pageNo)
+{
+  reference(file, pageNo, true);
+}
+
+void MrcEstimator::pageAllocated(const File* file, PageId pageNo)
+{
+  reference(file, pageNo, false);
+}
+
+void MrcEstimator::clearCounts()
+{
+  sampledReads = 0;
+  for (int s = 0; s < NUM_SIZES; s++)
+    sampledHits[s] = 0;
+}
+
+void MrcEstimator::reference(const File* file, PageId pageNo, bool read)
+{
+  // Partitions are picked with the high half of the hash and hash table
+  // buckets with its lowest bits, so sample with the bits in between.
+  if (((BufHashTbl::hash(file, pageNo) >> 8) & (SAMPLE_SCALE - 1)) >= threshold)
+    return;
+  PageKey page = {file, pageNo};
+  std::unordered_map<PageKey, std::list<Entry>::iterator, PageKeyHash>::iterator it = index.find(page);
+  if (read)
+    sampledReads++;
+  if (it != index.end()) {
+    int segment = it->second->segment;
+    if (read) {
+      for (int s = segment; s < NUM_SIZES; s++)
+        sampledHits[s]++;
+    }
+    segments[0].splice(segments[0].begin(), segments[segment], it->second);
+    it->second->segment = 0;
+  } else {
+    Entry entry = {page, 0};
+    segments[0].push_front(entry);
+    index[page] = segments[0].begin();
+  }
+  // Push the overflow of each segment down into the next; pages falling
+  // off the last one are beyond every size estimated.
+  for (int s = 0; s < NUM_SIZES && segments[s].size() > capacity[s]; s++) {
+    std::list<Entry>::iterator last = --segments[s].end();
+    if (s + 1 < NUM_SIZES) {
+      last->segment = s + 1;
+      segments[s + 1].splice(segments[s + 1].begin(), segments[s], last);
+    } else {
+      index.erase(last->page);
+      segments[s].erase(last);
+    }
+  }
+}
+
+}
@@ -0,0 +1,170 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <list>
+#include <unordered_map>
+#include "file.h"
+#include "replacement_policy.h"
+#include "types.h"
+
+namespace badgerdb {
+
+/**
+* @brief Estimates the hit ratio a buffer pool partition would have at other sizes, from its live reads.
+*
+* The estimator models an LRU pool and follows the SHARDS approach: only pages whose hash falls below a
+* threshold are tracked, and distances among the sampled pages are scaled by the inverse sampling rate.
+* The sampled pages are kept in an LRU stack cut into segments that end at SIZE_FACTORS times the
+* partition size. A read finding its page in segment s would have hit in every pool at least as large as
+* the end of s, so a sampled read costs a table lookup and a splice per segment.
+*
+* The rate is chosen so that at most MAX_SAMPLED pages are tracked, which bounds the memory whatever the
+* size of the pool, and at most the highest rate given. The default keeps the cost per read negligible,
+* but the estimates rest on the sampled pages alone, so small pools need a higher rate to be estimated well.
+*
+* The estimates are those of LRU; the policy in use does better or worse depending on the workload,
+* which the estimate at 1x shows next to the measured hit ratio.
+*
+* @warning This class is not threadsafe. Each partition has its own, guarded by the partition latch.
+*/
+class MrcEstimator
+{
+ public:
+	/**
+   * Number of pool sizes estimated
+	 */
+  static const int NUM_SIZES = 4;
+
+	/**
+   * Pool sizes estimated, as multiples of the size of the partition
+	 */
+  static const double SIZE_FACTORS[NUM_SIZES];
+
+	/**
+   * Default of the highest fraction of pages sampled
+	 */
+  static const double DEFAULT_MAX_RATE;
+
+	/**
+	 * Constructor of MrcEstimator class.
+	 *
+	 * @param numFrames   Number of frames of the partition
+	 * @param maxRate     Highest fraction of pages to sample; 0 turns the estimator off
+	 */
+  explicit MrcEstimator(std::uint32_t numFrames, double maxRate = DEFAULT_MAX_RATE);
+
+	/**
+	 * Starts over for a new partition size, forgetting the sampled pages and the counts.
+	 */
+  void resize(std::uint32_t numFrames);
+
+	/**
+	 * Starts over with a new highest sampling rate, forgetting the sampled pages and the counts.
+	 *
+	 * @param maxRate     Highest fraction of pages to sample; 0 turns the estimator off
+	 */
+  void setMaxRate(double maxRate);
+
+	/**
+	 * Records a read of a page.
+	 */
+  void pageRead(const File* file, PageId pageNo);
+
+	/**
+	 * Records a page allocated in the pool. It becomes the most recently used page but is not a read.
+	 */
+  void pageAllocated(const File* file, PageId pageNo);
+
+	/**
+	 * Resets the read and hit counts, keeping the sampled pages.
+	 */
+  void clearCounts();
+
+	/**
+	 * Pool size of an estimate.
+	 *
+	 * @param size   	Index into SIZE_FACTORS
+	 */
+  std::uint32_t poolSize(int size) const { return sizes[size]; }
+
+	/**
+   * Estimated number of reads since the counts were cleared
+	 */
+  double estimatedReads() const { return threshold == 0 ? 0 : sampledReads / rate; }
+
+	/**
+	 * Estimated number of those reads that would have hit in a pool of the given size.
+	 *
+	 * @param size   	Index into SIZE_FACTORS
+	 */
+  double estimatedHits(int size) const { return threshold == 0 ? 0 : sampledHits[size] / rate; }
+
+ private:
+	/**
+   * Most pages tracked at a time
+	 */
+  static const std::uint32_t MAX_SAMPLED = 4096;
+
+	/**
+   * Hashes are compared with the threshold in units of 1 / SAMPLE_SCALE
+	 */
+  static const std::uint32_t SAMPLE_SCALE = 1 << 24;
+
+	/**
+   * @brief A sampled page and the segment of the stack it is in
+	 */
+  struct Entry
+  {
+    PageKey page;
+    int segment;
+  };
+
+	/**
+   * Pool sizes estimated, in frames
+	 */
+  std::uint32_t sizes[NUM_SIZES];
+
+	/**
+   * Highest fraction of pages to sample
+	 */
+  double maxRate;
+
+	/**
+   * Fraction of pages sampled, and the hash threshold giving it
+	 */
+  double rate;
+  std::uint32_t threshold;
+
+	/**
+   * The segments of the LRU stack, most recently used page first, and their capacity in sampled pages
+	 */
+  std::list<Entry> segments[NUM_SIZES];
+  std::size_t capacity[NUM_SIZES];
+
+	/**
+   * Position of every sampled page in the stack
+	 */
+  std::unordered_map<PageKey, std::list<Entry>::iterator, PageKeyHash> index;
+
+	/**
+   * Reads of sampled pages, and those that would have hit at each size
+	 */
+  std::uint64_t sampledReads;
+  std::uint64_t sampledHits[NUM_SIZES];
+
+	/**
+	 * Moves a sampled page to the top of the stack.
+	 *
+	 * @param read   	Whether to count the reference as a read
+	 */
+  void reference(const File* file, PageId pageNo, bool read);
+};
+
+}
@@ -11,6 +11,7 @@
 #include <stdint.h>
 #include <memory>
 #include <string>
+#include <type_traits>
 
 #include "types.h"
 
@@ -327,10 +328,10 @@ class Page {
 
   /**
    * Data stored on the page.  Includes bookkeeping information about slots as
-   * well as actual content.
+   * well as actual content.  Stored inline so that a Page is exactly one
+   * on-disk page and can live in a flat array of buffer frames.
    */
-
-  std::string data_;
+  char data_[DATA_SIZE];
 
   friend class File;
   friend class PageIterator;
@@ -342,5 +343,11 @@ static_assert(Page::SIZE > sizeof(PageHeader),
               "Page size must be large enough to hold header and data.");
 static_assert(Page::DATA_SIZE > 0,
               "Page must have some space to hold data.");
+static_assert(sizeof(Page) == Page::SIZE,
+              "Page object must have the same layout as a page on disk.");
+static_assert(std::is_standard_layout<Page>::value,
+              "Page object must start with its header.");
+static_assert(std::is_trivially_copyable<Page>::value,
+              "Page object must be readable and writable as raw bytes.");
 
 }
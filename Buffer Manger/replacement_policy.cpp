@@ -0,0 +1,611 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
+ */
+
+#include "replacement_policy.h"
+#include "buffer.h"
+#include "bufHashTbl.h"
+
+namespace badgerdb {
+
+std::size_t PageKeyHash::operator()(const PageKey& key) const
+{
+  return (std::size_t) BufHashTbl::hash(key.file, key.pageNo);
+}
+
+// -----------------------------------------------------------------------------
+// ReplacementPolicy
+// -----------------------------------------------------------------------------
+
+ReplacementPolicy* ReplacementPolicy::create(ReplacementPolicyType type, FrameId firstFrame, std::uint32_t numFrames)
+{
+  switch (type) {
+    case LRU_K:
+      return new LruKPolicy(firstFrame, numFrames);
+    case TWO_Q:
+      return new TwoQPolicy(firstFrame, numFrames);
+    case ARC:
+      return new ArcPolicy(firstFrame, numFrames);
+    case CLOCK:
+    default:
+      return new ClockPolicy(firstFrame, numFrames);
+  }
+}
+
+ReplacementPolicy::ReplacementPolicy(FrameId firstFrame, std::uint32_t numFrames)
+  : firstFrame(firstFrame), numFrames(numFrames), tracked(numFrames, false)
+{
+  // Hand out free frames in ascending order.
+  for (FrameId f = firstFrame + numFrames; f > firstFrame; f--)
+    freeFrames.push_back(f - 1);
+}
+
+void ReplacementPolicy::frameAccessed(FrameId frame)
+{
+  if (tracked[frame - firstFrame])
+    access(frame);
+}
+
+void ReplacementPolicy::frameLoaded(FrameId frame, const File* file, PageId pageNo)
+{
+  PageKey page = {file, pageNo};
+  tracked[frame - firstFrame] = true;
+  load(frame, page);
+}
+
+void ReplacementPolicy::frameUnpinned(BufDesc* descTable, FrameId frame, AccessHint hint)
+{
+  if (hint != NORMAL && tracked[frame - firstFrame])
+    this->hint(descTable, frame, hint);
+}
+
+void ReplacementPolicy::frameFreed(FrameId frame)
+{
+  if (tracked[frame - firstFrame]) {
+    forget(frame);
+    tracked[frame - firstFrame] = false;
+  }
+  freeFrames.push_back(frame);
+}
+
+void ReplacementPolicy::frameReclaimed(FrameId frame)
+{
+  if (tracked[frame - firstFrame]) {
+    forget(frame);
+    tracked[frame - firstFrame] = false;
+  }
+}
+
+void ReplacementPolicy::frameKept(FrameId frame)
+{
+  tracked[frame - firstFrame] = true;
+  restore(frame);
+}
+
+bool ReplacementPolicy::pickVictim(BufDesc* descTable, FrameId& frame)
+{
+  if (!freeFrames.empty()) {
+    frame = freeFrames.back();
+    freeFrames.pop_back();
+    return true;
+  }
+  if (!evict(descTable, frame))
+    return false;
+  tracked[frame - firstFrame] = false;
+  return true;
+}
+
+bool ReplacementPolicy::takeFreeFrame(FrameId limit, FrameId& frame)
+{
+  // The lowest frames are at the back unless frames were freed since.
+  for (std::size_t i = freeFrames.size(); i > 0; i--) {
+    if (freeFrames[i - 1] < limit) {
+      frame = freeFrames[i - 1];
+      freeFrames[i - 1] = freeFrames.back();
+      freeFrames.pop_back();
+      return true;
+    }
+  }
+  return false;
+}
+
+void ReplacementPolicy::resize(std::uint32_t newNumFrames)
+{
+  std::uint32_t oldNumFrames = numFrames;
+  if (newNumFrames < oldNumFrames) {
+    std::vector<FrameId> kept;
+    for (std::size_t i = 0; i < freeFrames.size(); i++) {
+      if (freeFrames[i] < firstFrame + newNumFrames)
+        kept.push_back(freeFrames[i]);
+    }
+    freeFrames.swap(kept);
+  } else {
+    for (FrameId f = firstFrame + newNumFrames; f > firstFrame + oldNumFrames; f--)
+      freeFrames.push_back(f - 1);
+  }
+  tracked.resize(newNumFrames, false);
+  numFrames = newNumFrames;
+  resized(oldNumFrames);
+}
+
+void ReplacementPolicy::rankFrames(const BufDesc* descTable, std::vector<FrameId>& frames)
+{
+  std::size_t begin = frames.size(), end = begin;
+  rank(descTable, frames);
+  for (std::size_t i = begin; i < frames.size(); i++) {
+    if (tracked[frames[i] - firstFrame])
+      frames[end++] = frames[i];
+  }
+  frames.resize(end);
+}
+
+bool ReplacementPolicy::isPinned(const BufDesc& desc)
+{
+  return desc.pinCnt != 0;
+}
+
+bool ReplacementPolicy::isReferenced(const BufDesc& desc)
+{
+  return desc.refbit;
+}
+
+bool ReplacementPolicy::testAndClearRefbit(BufDesc& desc)
+{
+  bool refbit = desc.refbit;
+  desc.refbit = false;
+  return refbit;
+}
+
+// -----------------------------------------------------------------------------
+// ClockPolicy
+// -----------------------------------------------------------------------------
+
+ClockPolicy::ClockPolicy(FrameId firstFrame, std::uint32_t numFrames)
+  : ReplacementPolicy(firstFrame, numFrames), hot(numFrames, false), clockHand(firstFrame + numFrames - 1)
+{
+}
+
+void ClockPolicy::load(FrameId frame, const PageKey& /* page */)
+{
+  hot[frame - firstFrame] = false;
+}
+
+void ClockPolicy::forget(FrameId frame)
+{
+  hot[frame - firstFrame] = false;
+}
+
+void ClockPolicy::hint(BufDesc* descTable, FrameId frame, AccessHint hint)
+{
+  hot[frame - firstFrame] = hint == KEEP_HOT;
+  if (hint == EVICT_SOON)
+    testAndClearRefbit(descTable[frame]);
+}
+
+bool ClockPolicy::evict(BufDesc* descTable, FrameId& frame)
+{
+  // The number of pinned frames passed since the hand last cleared a
+  // reference bit or hot flag. Once it reaches the number of frames, a whole
+  // round found nothing but pinned frames.
+  std::uint32_t num = 0;
+  // A referenced frame loses its reference bit and is skipped once, a hot
+  // one loses its flag and is skipped once more.
+  while (num < numFrames) {
+    // Advance the clock, wrapping around to the first managed frame.
+    if (++clockHand >= firstFrame + numFrames)
+      clockHand = firstFrame;
+    if (testAndClearRefbit(descTable[clockHand])) {
+      num = 0;
+      continue;
+    }
+    if (hot[clockHand - firstFrame]) {
+      hot[clockHand - firstFrame] = false;
+      num = 0;
+      continue;
+    }
+    if (isPinned(descTable[clockHand])) {
+      num++;
+      continue;
+    }
+    frame = clockHand;
+    return true;
+  }
+  // All the pages are pinned.
+  return false;
+}
+
+void ClockPolicy::restore(FrameId /* frame */)
+{
+  // The hand has passed the frame, so it is considered again in the next
+  // round like any other.
+}
+
+void ClockPolicy::resized(std::uint32_t /* oldNumFrames */)
+{
+  hot.resize(numFrames, false);
+  if (clockHand >= firstFrame + numFrames)
+    clockHand = firstFrame + numFrames - 1;
+}
+
+void ClockPolicy::rank(const BufDesc* descTable, std::vector<FrameId>& frames)
+{
+  // The hand takes unreferenced frames in the order it reaches them and
+  // spares referenced and hot ones for a round, so the hottest frames are
+  // the spared ones it passed last.
+  for (int referenced = 1; referenced >= 0; referenced--) {
+    for (std::uint32_t n = 0; n < numFrames; n++) {
+      FrameId frame = firstFrame + (clockHand - firstFrame + numFrames - n) % numFrames;
+      if ((isReferenced(descTable[frame]) || hot[frame - firstFrame]) == (referenced == 1))
+        frames.push_back(frame);
+    }
+  }
+}
+
+// -----------------------------------------------------------------------------
+// LruKPolicy
+// -----------------------------------------------------------------------------
+
+LruKPolicy::LruKPolicy(FrameId firstFrame, std::uint32_t numFrames, std::uint32_t k)
+  : ReplacementPolicy(firstFrame, numFrames), K(k == 0 ? 1 : k), now(0),
+    history((std::size_t) numFrames * (k == 0 ? 1 : k), 0)
+{
+}
+
+LruKPolicy::OrderKey LruKPolicy::orderKey(FrameId frame) const
+{
+  const std::uint64_t* times = &history[(std::size_t) (frame - firstFrame) * K];
+  return std::make_pair(std::make_pair(times[K - 1], times[0]), frame);
+}
+
+void LruKPolicy::reference(FrameId frame)
+{
+  std::uint64_t* times = &history[(std::size_t) (frame - firstFrame) * K];
+  for (std::uint32_t i = K - 1; i > 0; i--)
+    times[i] = times[i - 1];
+  times[0] = ++now;
+}
+
+void LruKPolicy::access(FrameId frame)
+{
+  order.erase(orderKey(frame));
+  reference(frame);
+  order.insert(orderKey(frame));
+}
+
+void LruKPolicy::load(FrameId frame, const PageKey& /* page */)
+{
+  // evict() leaves the history of the old page for restore().
+  forget(frame);
+  reference(frame);
+  order.insert(orderKey(frame));
+}
+
+void LruKPolicy::forget(FrameId frame)
+{
+  order.erase(orderKey(frame));
+  std::uint64_t* times = &history[(std::size_t) (frame - firstFrame) * K];
+  for (std::uint32_t i = 0; i < K; i++)
+    times[i] = 0;
+}
+
+void LruKPolicy::hint(BufDesc* /* descTable */, FrameId frame, AccessHint hint)
+{
+  std::uint64_t* times = &history[(std::size_t) (frame - firstFrame) * K];
+  if (hint == KEEP_HOT) {
+    // As if all K references had just happened.
+    order.erase(orderKey(frame));
+    ++now;
+    for (std::uint32_t i = 0; i < K; i++)
+      times[i] = now;
+  } else {
+    // No references: the oldest frame there is.
+    forget(frame);
+  }
+  order.insert(orderKey(frame));
+}
+
+bool LruKPolicy::evict(BufDesc* descTable, FrameId& frame)
+{
+  // The unpinned frame with the oldest K-th reference (zero if it has fewer
+  // than K), ties broken by the oldest last reference.
+  for (std::set<OrderKey>::iterator it = order.begin(); it != order.end(); ++it) {
+    if (isPinned(descTable[it->second]))
+      continue;
+    frame = it->second;
+    order.erase(it);
+    return true;
+  }
+  return false;
+}
+
+void LruKPolicy::restore(FrameId frame)
+{
+  // evict() kept the reference history.
+  order.insert(orderKey(frame));
+}
+
+void LruKPolicy::resized(std::uint32_t /* oldNumFrames */)
+{
+  history.resize((std::size_t) numFrames * K, 0);
+}
+
+void LruKPolicy::rank(const BufDesc* /* descTable */, std::vector<FrameId>& frames)
+{
+  // The reverse of the eviction order of evict().
+  for (std::set<OrderKey>::reverse_iterator it = order.rbegin(); it != order.rend(); ++it)
+    frames.push_back(it->second);
+}
+
+// -----------------------------------------------------------------------------
+// TwoQPolicy
+// -----------------------------------------------------------------------------
+
+TwoQPolicy::TwoQPolicy(FrameId firstFrame, std::uint32_t numFrames)
+  : ReplacementPolicy(firstFrame, numFrames), position(numFrames), inAm(numFrames, false),
+    pages(numFrames)
+{
+  // The sizes recommended by the 2Q paper: A1in holds a quarter of the
+  // frames, A1out remembers as many pages as half the frames.
+  kin = numFrames / 4 > 0 ? numFrames / 4 : 1;
+  kout = numFrames / 2 > 0 ? numFrames / 2 : 1;
+}
+
+void TwoQPolicy::access(FrameId frame)
+{
+  // Hits in A1in are deliberately ignored; they are most likely correlated
+  // references shortly after the first one.
+  std::uint32_t i = frame - firstFrame;
+  if (inAm[i])
+    am.splice(am.end(), am, position[i]);
+}
+
+void TwoQPolicy::load(FrameId frame, const PageKey& page)
+{
+  std::uint32_t i = frame - firstFrame;
+  pages[i] = page;
+  auto ghost = a1outIndex.find(page);
+  if (ghost != a1outIndex.end()) {
+    // Referenced again after leaving A1in: the page is hot.
+    a1out.erase(ghost->second);
+    a1outIndex.erase(ghost);
+    position[i] = am.insert(am.end(), frame);
+    inAm[i] = true;
+  } else {
+    position[i] = a1in.insert(a1in.end(), frame);
+    inAm[i] = false;
+  }
+}
+
+void TwoQPolicy::forget(FrameId frame)
+{
+  std::uint32_t i = frame - firstFrame;
+  (inAm[i] ? am : a1in).erase(position[i]);
+}
+
+void TwoQPolicy::hint(BufDesc* /* descTable */, FrameId frame, AccessHint hint)
+{
+  std::uint32_t i = frame - firstFrame;
+  std::list<FrameId>& queue = inAm[i] ? am : a1in;
+  if (hint == KEEP_HOT) {
+    // Promote to the most recently used end of Am.
+    am.splice(am.end(), queue, position[i]);
+    inAm[i] = true;
+  } else {
+    // Next in line in its queue.
+    queue.splice(queue.begin(), queue, position[i]);
+  }
+}
+
+bool TwoQPolicy::evictFrom(std::list<FrameId>& queue, BufDesc* descTable, FrameId& frame)
+{
+  for (std::list<FrameId>::iterator it = queue.begin(); it != queue.end(); ++it) {
+    if (!isPinned(descTable[*it])) {
+      frame = *it;
+      queue.erase(it);
+      return true;
+    }
+  }
+  return false;
+}
+
+bool TwoQPolicy::evict(BufDesc* descTable, FrameId& frame)
+{
+  bool fromA1in = a1in.size() > kin || am.empty();
+  if (!fromA1in && evictFrom(am, descTable, frame))
+    return true;
+  if (evictFrom(a1in, descTable, frame)) {
+    // Remember the page so a later reference promotes it to Am.
+    const PageKey& page = pages[frame - firstFrame];
+    a1outIndex[page] = a1out.insert(a1out.end(), page);
+    if (a1out.size() > kout) {
+      a1outIndex.erase(a1out.front());
+      a1out.pop_front();
+    }
+    return true;
+  }
+  return fromA1in && evictFrom(am, descTable, frame);
+}
+
+void TwoQPolicy::restore(FrameId frame)
+{
+  // Back to the front of its queue, and out of A1out if evict() put it there.
+  std::uint32_t i = frame - firstFrame;
+  std::list<FrameId>& queue = inAm[i] ? am : a1in;
+  position[i] = queue.insert(queue.begin(), frame);
+  if (!inAm[i]) {
+    auto ghost = a1outIndex.find(pages[i]);
+    if (ghost != a1outIndex.end()) {
+      a1out.erase(ghost->second);
+      a1outIndex.erase(ghost);
+    }
+  }
+}
+
+void TwoQPolicy::resized(std::uint32_t /* oldNumFrames */)
+{
+  position.resize(numFrames);
+  inAm.resize(numFrames, false);
+  pages.resize(numFrames);
+  kin = numFrames / 4 > 0 ? numFrames / 4 : 1;
+  kout = numFrames / 2 > 0 ? numFrames / 2 : 1;
+  while (a1out.size() > kout) {
+    a1outIndex.erase(a1out.front());
+    a1out.pop_front();
+  }
+}
+
+void TwoQPolicy::rank(const BufDesc* /* descTable */, std::vector<FrameId>& frames)
+{
+  // Pages in Am have been referenced after leaving A1in; A1in goes first.
+  frames.insert(frames.end(), am.rbegin(), am.rend());
+  frames.insert(frames.end(), a1in.rbegin(), a1in.rend());
+}
+
+// -----------------------------------------------------------------------------
+// ArcPolicy
+// -----------------------------------------------------------------------------
+
+ArcPolicy::ArcPolicy(FrameId firstFrame, std::uint32_t numFrames)
+  : ReplacementPolicy(firstFrame, numFrames), position(numFrames), inT2(numFrames, false),
+    pages(numFrames), p(0)
+{
+}
+
+void ArcPolicy::access(FrameId frame)
+{
+  // Any hit moves the frame to the most recently used end of T2.
+  std::uint32_t i = frame - firstFrame;
+  t2.splice(t2.end(), inT2[i] ? t2 : t1, position[i]);
+  inT2[i] = true;
+}
+
+void ArcPolicy::load(FrameId frame, const PageKey& page)
+{
+  std::uint32_t i = frame - firstFrame;
+  pages[i] = page;
+  GhostIndex::iterator ghost;
+  if ((ghost = b1Index.find(page)) != b1Index.end()) {
+    // Recency list was too small: grow the target size of T1.
+    std::uint32_t delta = b2.size() > b1.size() ? b2.size() / b1.size() : 1;
+    p = p + delta < numFrames ? p + delta : numFrames;
+    b1.erase(ghost->second);
+    b1Index.erase(ghost);
+    position[i] = t2.insert(t2.end(), frame);
+    inT2[i] = true;
+  } else if ((ghost = b2Index.find(page)) != b2Index.end()) {
+    // Frequency list was too small: shrink the target size of T1.
+    std::uint32_t delta = b1.size() > b2.size() ? b1.size() / b2.size() : 1;
+    p = p > delta ? p - delta : 0;
+    b2.erase(ghost->second);
+    b2Index.erase(ghost);
+    position[i] = t2.insert(t2.end(), frame);
+    inT2[i] = true;
+  } else {
+    position[i] = t1.insert(t1.end(), frame);
+    inT2[i] = false;
+    // Bound the directory: |T1| + |B1| <= c and |T1| + |T2| + |B1| + |B2| <= 2c.
+    if (t1.size() + b1.size() > numFrames && !b1.empty())
+      dropGhost(b1, b1Index);
+    if (t1.size() + t2.size() + b1.size() + b2.size() > 2 * (std::size_t) numFrames)
+      dropGhost(b2.empty() ? b1 : b2, b2.empty() ? b1Index : b2Index);
+  }
+}
+
+void ArcPolicy::forget(FrameId frame)
+{
+  std::uint32_t i = frame - firstFrame;
+  (inT2[i] ? t2 : t1).erase(position[i]);
+}
+
+void ArcPolicy::hint(BufDesc* /* descTable */, FrameId frame, AccessHint hint)
+{
+  std::uint32_t i = frame - firstFrame;
+  std::list<FrameId>& list = inT2[i] ? t2 : t1;
+  if (hint == KEEP_HOT) {
+    t2.splice(t2.end(), list, position[i]);
+    inT2[i] = true;
+  } else {
+    // The least recently used end of T1, which REPLACE takes from while
+    // T1 is above its target size.
+    t1.splice(t1.begin(), list, position[i]);
+    inT2[i] = false;
+  }
+}
+
+void ArcPolicy::dropGhost(std::list<PageKey>& ghost, GhostIndex& ghostIndex)
+{
+  if (ghost.empty())
+    return;
+  ghostIndex.erase(ghost.front());
+  ghost.pop_front();
+}
+
+bool ArcPolicy::evictFrom(std::list<FrameId>& list, std::list<PageKey>& ghost, GhostIndex& ghostIndex,
+                          BufDesc* descTable, FrameId& frame)
+{
+  for (std::list<FrameId>::iterator it = list.begin(); it != list.end(); ++it) {
+    if (!isPinned(descTable[*it])) {
+      frame = *it;
+      list.erase(it);
+      const PageKey& page = pages[frame - firstFrame];
+      ghostIndex[page] = ghost.insert(ghost.end(), page);
+      return true;
+    }
+  }
+  return false;
+}
+
+bool ArcPolicy::evict(BufDesc* descTable, FrameId& frame)
+{
+  // REPLACE from the ARC paper: take from T1 while it is above its target
+  // size, otherwise from T2. Fall back to the other list if every frame of
+  // the preferred one is pinned.
+  if (!t1.empty() && (t1.size() > p || t2.empty())) {
+    return evictFrom(t1, b1, b1Index, descTable, frame) ||
+           evictFrom(t2, b2, b2Index, descTable, frame);
+  }
+  return evictFrom(t2, b2, b2Index, descTable, frame) ||
+         evictFrom(t1, b1, b1Index, descTable, frame);
+}
+
+void ArcPolicy::restore(FrameId frame)
+{
+  // Back to the front of its list, and out of the ghost list evict() put it in.
+  std::uint32_t i = frame - firstFrame;
+  std::list<FrameId>& list = inT2[i] ? t2 : t1;
+  std::list<PageKey>& ghost = inT2[i] ? b2 : b1;
+  GhostIndex& ghostIndex = inT2[i] ? b2Index : b1Index;
+  position[i] = list.insert(list.begin(), frame);
+  GhostIndex::iterator it = ghostIndex.find(pages[i]);
+  if (it != ghostIndex.end()) {
+    ghost.erase(it->second);
+    ghostIndex.erase(it);
+  }
+}
+
+void ArcPolicy::resized(std::uint32_t /* oldNumFrames */)
+{
+  position.resize(numFrames);
+  inT2.resize(numFrames, false);
+  pages.resize(numFrames);
+  if (p > numFrames)
+    p = numFrames;
+  // Restore the directory bounds for the new cache size.
+  while (t1.size() + b1.size() > numFrames && !b1.empty())
+    dropGhost(b1, b1Index);
+  while (t1.size() + t2.size() + b1.size() + b2.size() > 2 * (std::size_t) numFrames &&
+         !(b1.empty() && b2.empty()))
+    dropGhost(b2.empty() ? b1 : b2, b2.empty() ? b1Index : b2Index);
+}
+
+void ArcPolicy::rank(const BufDesc* /* descTable */, std::vector<FrameId>& frames)
+{
+  // Pages in T2 have been referenced at least twice.
+  frames.insert(frames.end(), t2.rbegin(), t2.rend());
+  frames.insert(frames.end(), t1.rbegin(), t1.rend());
+}
+
+}
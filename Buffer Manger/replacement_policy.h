@@ -0,0 +1,480 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <list>
+#include <set>
+#include <vector>
+#include <unordered_map>
+
+#include "file.h"
+#include "types.h"
+
+namespace badgerdb {
+
+class BufDesc;
+
+/**
+ * @brief Replacement policies available to the buffer manager. Passed to the BufMgr constructor.
+ */
+enum ReplacementPolicyType
+{
+	CLOCK = 0,	/* Clock sweep over the reference bits */
+	LRU_K = 1,	/* LRU-K with K = 2 */
+	TWO_Q = 2,	/* Full 2Q with A1in, A1out and Am queues */
+	ARC = 3		/* Adaptive Replacement Cache */
+};
+
+/**
+ * @brief What the caller expects of a page it unpins, passed to BufMgr::unPinPage(). The policy in use
+ * decides how far to follow it.
+ */
+enum AccessHint
+{
+	NORMAL = 0,	/* No expectation; the policy goes by the references alone */
+	KEEP_HOT = 1,	/* Used again and again, such as an inner node of an index; keep it ahead of other pages */
+	EVICT_SOON = 2	/* Not needed again, such as a page read once by a scan; reuse its frame first */
+};
+
+/**
+ * @brief Identity of a page, used by policies that remember pages which are no longer resident.
+ */
+struct PageKey
+{
+	/**
+	 * File the page belongs to
+	 */
+  const File* file;
+
+	/**
+	 * Page number within the file
+	 */
+  PageId pageNo;
+
+  bool operator==(const PageKey& rhs) const {
+    return file == rhs.file && pageNo == rhs.pageNo;
+  }
+};
+
+/**
+ * @brief Hash functor for PageKey.
+ */
+struct PageKeyHash
+{
+  std::size_t operator()(const PageKey& key) const;
+};
+
+/**
+ * @brief Interface for choosing which frame of a buffer pool partition gets reused.
+ *
+ * A policy instance manages the frames [firstFrame, firstFrame + numFrames) of one partition. The buffer
+ * manager reports every hit, every page installed in a frame, every frame freed without going through
+ * the policy (disposePage, flushFile) and the hints given when pages are unpinned, and asks pickVictim()
+ * for a frame whenever it needs one. All calls
+ * are made with the partition latch held. Free frames are handed out by this base class; subclasses only
+ * decide among frames holding pages.
+ *
+ * @warning This class is not threadsafe.
+ */
+class ReplacementPolicy
+{
+ public:
+	/**
+	 * Creates a policy of the given type for a range of frames.
+	 *
+	 * @param type        Replacement policy to create
+	 * @param firstFrame  First frame managed by the policy
+	 * @param numFrames   Number of frames managed by the policy
+	 * @return  Newly allocated policy, owned by the caller.
+	 */
+  static ReplacementPolicy* create(ReplacementPolicyType type, FrameId firstFrame, std::uint32_t numFrames);
+
+	/**
+	 * Constructs a policy with all its frames free.
+	 *
+	 * @param firstFrame  First frame managed by the policy
+	 * @param numFrames   Number of frames managed by the policy
+	 */
+  ReplacementPolicy(FrameId firstFrame, std::uint32_t numFrames);
+
+  virtual ~ReplacementPolicy() {}
+
+	/**
+	 * Called when a resident page is pinned again.
+	 *
+	 * @param frame   Frame holding the page
+	 */
+  void frameAccessed(FrameId frame);
+
+	/**
+	 * Called after a page has been installed in a frame returned by pickVictim().
+	 *
+	 * @param frame   Frame holding the page
+	 * @param file    File the page belongs to
+	 * @param pageNo  Page number within the file
+	 */
+  void frameLoaded(FrameId frame, const File* file, PageId pageNo);
+
+	/**
+	 * Called when a page is unpinned with a hint other than NORMAL.
+	 *
+	 * @param descTable   Descriptor table of the buffer pool, indexed by frame number
+	 * @param frame   Frame holding the page
+	 * @param hint    What the caller expects of the page
+	 */
+  void frameUnpinned(BufDesc* descTable, FrameId frame, AccessHint hint);
+
+	/**
+	 * Called when a frame becomes free without having been chosen by pickVictim() (disposePage,
+	 * flushFile), or when a frame returned by pickVictim() ends up not being used.
+	 *
+	 * @param frame   Frame that is now free
+	 */
+  void frameFreed(FrameId frame);
+
+	/**
+	 * Called when the buffer manager takes a frame holding a page for immediate reuse without asking
+	 * pickVictim(), as done for the private ring of a BufferAccessStrategy. The frame stops being tracked.
+	 *
+	 * @param frame   Frame being reused
+	 */
+  void frameReclaimed(FrameId frame);
+
+	/**
+	 * Called when the frame holding a page that pickVictim() just returned keeps its page after all, as
+	 * when the admission filter of the buffer manager turns the new page away. The frame is tracked again
+	 * from where pickVictim() took it.
+	 *
+	 * @param frame   Frame returned by the last pickVictim() call
+	 */
+  void frameKept(FrameId frame);
+
+	/**
+	 * Chooses a frame to reuse. Free frames are handed out first; otherwise the choice is an unpinned
+	 * frame holding a valid page, which stops being tracked by the policy. The caller writes the page
+	 * back if needed and invalidates the frame.
+	 *
+	 * @param descTable   Descriptor table of the buffer pool, indexed by frame number
+	 * @param frame       Frame ID of chosen frame returned via this variable
+	 * @return  False if every frame of the partition is pinned.
+	 */
+  bool pickVictim(BufDesc* descTable, FrameId& frame);
+
+	/**
+	 * Takes a free frame below a given frame, for the buffer manager to move a page into. The frame stops
+	 * being free; the caller reports the page it installs with frameLoaded().
+	 *
+	 * @param limit   Frames from this one on are not taken
+	 * @param frame   Frame ID of the free frame returned via this variable
+	 * @return  False if no free frame lies below limit.
+	 */
+  bool takeFreeFrame(FrameId limit, FrameId& frame);
+
+	/**
+	 * Changes the number of managed frames, keeping firstFrame. Frames added at the end start out free.
+	 * Frames removed from the end must hold no page, i.e. have been passed to frameFreed() beforehand.
+	 *
+	 * @param newNumFrames  New number of frames managed by the policy
+	 */
+  void resize(std::uint32_t newNumFrames);
+
+	/**
+	 * Appends the frames holding pages tracked by the policy, hottest first, i.e. in the reverse of the
+	 * order they would be evicted in if no page were referenced any more.
+	 *
+	 * @param descTable   Descriptor table of the buffer pool, indexed by frame number
+	 * @param frames      Frames are appended to this
+	 */
+  void rankFrames(const BufDesc* descTable, std::vector<FrameId>& frames);
+
+ protected:
+	/**
+	 * Records a hit on a tracked frame.
+	 */
+  virtual void access(FrameId frame) = 0;
+
+	/**
+	 * Starts tracking a frame that now holds the given page.
+	 */
+  virtual void load(FrameId frame, const PageKey& page) = 0;
+
+	/**
+	 * Stops tracking a frame that was freed by the buffer manager.
+	 */
+  virtual void forget(FrameId frame) = 0;
+
+	/**
+	 * Moves a tracked frame towards the end of the eviction order the hint asks for, see AccessHint.
+	 */
+  virtual void hint(BufDesc* descTable, FrameId frame, AccessHint hint) = 0;
+
+	/**
+	 * Chooses an unpinned tracked frame and stops tracking it. Only called when no frame is free.
+	 *
+	 * @param descTable   Descriptor table of the buffer pool, indexed by frame number
+	 * @param frame       Frame ID of chosen frame returned via this variable
+	 * @return  False if every frame of the partition is pinned.
+	 */
+  virtual bool evict(BufDesc* descTable, FrameId& frame) = 0;
+
+	/**
+	 * Tracks again the frame the last evict() call chose, undoing what evict() did to it.
+	 */
+  virtual void restore(FrameId frame) = 0;
+
+	/**
+	 * Adjusts the per-frame state of the subclass after numFrames changed. Removed frames are not tracked.
+	 *
+	 * @param oldNumFrames  Number of frames managed before the change
+	 */
+  virtual void resized(std::uint32_t oldNumFrames) = 0;
+
+	/**
+	 * Appends managed frames hottest first, see rankFrames(). Frames that are not tracked may be
+	 * included; the caller drops them.
+	 */
+  virtual void rank(const BufDesc* descTable, std::vector<FrameId>& frames) = 0;
+
+	/**
+	 * Accessors for the private state of a buffer descriptor, which subclasses cannot reach directly.
+	 */
+  static bool isPinned(const BufDesc& desc);
+  static bool isReferenced(const BufDesc& desc);
+  static bool testAndClearRefbit(BufDesc& desc);
+
+	/**
+	 * First frame managed by this policy
+	 */
+  FrameId firstFrame;
+
+	/**
+	 * Number of frames managed by this policy
+	 */
+  std::uint32_t numFrames;
+
+ private:
+	/**
+	 * Frames that currently hold no page, next one to hand out at the back
+	 */
+  std::vector<FrameId> freeFrames;
+
+	/**
+	 * Whether each managed frame is tracked by the subclass
+	 */
+  std::vector<bool> tracked;
+};
+
+/**
+ * @brief The classic clock sweep over the reference bits of the buffer descriptors.
+ */
+class ClockPolicy : public ReplacementPolicy
+{
+ public:
+  ClockPolicy(FrameId firstFrame, std::uint32_t numFrames);
+
+ protected:
+  void access(FrameId /* frame */) {}
+  void load(FrameId frame, const PageKey& page);
+  void forget(FrameId frame);
+  void hint(BufDesc* descTable, FrameId frame, AccessHint hint);
+  bool evict(BufDesc* descTable, FrameId& frame);
+  void restore(FrameId frame);
+  void resized(std::uint32_t oldNumFrames);
+  void rank(const BufDesc* descTable, std::vector<FrameId>& frames);
+
+ private:
+	/**
+	 * Whether each managed frame was last unpinned with KEEP_HOT. The hand spares such a frame for one
+	 * more round after its reference bit.
+	 */
+  std::vector<bool> hot;
+
+	/**
+	 * Current position of clockhand within the managed frames
+	 */
+  FrameId clockHand;
+};
+
+/**
+ * @brief LRU-K: evicts the frame whose K-th most recent reference is oldest. Frames referenced fewer than K
+ * times count as infinitely old and are ordered among themselves by their last reference, so pages touched
+ * once by a scan go before pages that are reused.
+ */
+class LruKPolicy : public ReplacementPolicy
+{
+ public:
+	/**
+	 * @param firstFrame  First frame managed by the policy
+	 * @param numFrames   Number of frames managed by the policy
+	 * @param k           Number of references remembered per frame
+	 */
+  LruKPolicy(FrameId firstFrame, std::uint32_t numFrames, std::uint32_t k = 2);
+
+ protected:
+  void access(FrameId frame);
+  void load(FrameId frame, const PageKey& page);
+  void forget(FrameId frame);
+  void hint(BufDesc* descTable, FrameId frame, AccessHint hint);
+  bool evict(BufDesc* descTable, FrameId& frame);
+  void restore(FrameId frame);
+  void resized(std::uint32_t oldNumFrames);
+  void rank(const BufDesc* descTable, std::vector<FrameId>& frames);
+
+ private:
+	/**
+	 * Records a reference to a frame at the current time.
+	 */
+  void reference(FrameId frame);
+
+	/**
+	 * Number of references remembered per frame
+	 */
+  std::uint32_t K;
+
+	/**
+	 * Logical clock, advanced on every reference
+	 */
+  std::uint64_t now;
+
+	/**
+	 * Last K reference times of every frame, most recent first. Zero means no reference.
+	 */
+  std::vector<std::uint64_t> history;
+
+	/**
+	 * Key of a frame in order: its K-th and its last reference time, then the frame itself.
+	 */
+  typedef std::pair<std::pair<std::uint64_t, std::uint64_t>, FrameId> OrderKey;
+
+	/**
+	 * Key of a frame in order, from its current history.
+	 */
+  OrderKey orderKey(FrameId frame) const;
+
+	/**
+	 * Frames tracked by the policy in eviction order, so evict() only walks past pinned frames.
+	 */
+  std::set<OrderKey> order;
+};
+
+/**
+ * @brief 2Q: new pages enter a FIFO (A1in) and are only promoted to the main LRU queue (Am) if they are
+ * referenced again after leaving A1in, which is remembered in a ghost queue of page ids (A1out).
+ */
+class TwoQPolicy : public ReplacementPolicy
+{
+ public:
+  TwoQPolicy(FrameId firstFrame, std::uint32_t numFrames);
+
+ protected:
+  void access(FrameId frame);
+  void load(FrameId frame, const PageKey& page);
+  void forget(FrameId frame);
+  void hint(BufDesc* descTable, FrameId frame, AccessHint hint);
+  bool evict(BufDesc* descTable, FrameId& frame);
+  void restore(FrameId frame);
+  void resized(std::uint32_t oldNumFrames);
+  void rank(const BufDesc* descTable, std::vector<FrameId>& frames);
+
+ private:
+	/**
+	 * Evicts the least recently queued unpinned frame of a queue.
+	 */
+  bool evictFrom(std::list<FrameId>& queue, BufDesc* descTable, FrameId& frame);
+
+	/**
+	 * Queues holding resident frames, least recently used at the front
+	 */
+  std::list<FrameId> a1in, am;
+
+	/**
+	 * Position of every resident frame in its queue, and whether that queue is Am
+	 */
+  std::vector<std::list<FrameId>::iterator> position;
+  std::vector<bool> inAm;
+
+	/**
+	 * Page held by every resident frame
+	 */
+  std::vector<PageKey> pages;
+
+	/**
+	 * Ghost queue of pages recently evicted from A1in, oldest at the front
+	 */
+  std::list<PageKey> a1out;
+  std::unordered_map<PageKey, std::list<PageKey>::iterator, PageKeyHash> a1outIndex;
+
+	/**
+	 * Target size of A1in and maximum size of A1out
+	 */
+  std::uint32_t kin, kout;
+};
+
+/**
+ * @brief Adaptive Replacement Cache: balances a recency list (T1) against a frequency list (T2), adapting
+ * the target size of T1 from hits in the ghost lists of pages recently evicted from each (B1, B2).
+ */
+class ArcPolicy : public ReplacementPolicy
+{
+ public:
+  ArcPolicy(FrameId firstFrame, std::uint32_t numFrames);
+
+ protected:
+  void access(FrameId frame);
+  void load(FrameId frame, const PageKey& page);
+  void forget(FrameId frame);
+  void hint(BufDesc* descTable, FrameId frame, AccessHint hint);
+  bool evict(BufDesc* descTable, FrameId& frame);
+  void restore(FrameId frame);
+  void resized(std::uint32_t oldNumFrames);
+  void rank(const BufDesc* descTable, std::vector<FrameId>& frames);
+
+ private:
+  typedef std::unordered_map<PageKey, std::list<PageKey>::iterator, PageKeyHash> GhostIndex;
+
+	/**
+	 * Evicts the least recently used unpinned frame of a list, remembering its page in a ghost list.
+	 */
+  bool evictFrom(std::list<FrameId>& list, std::list<PageKey>& ghost, GhostIndex& ghostIndex,
+                 BufDesc* descTable, FrameId& frame);
+
+	/**
+	 * Drops the oldest entry of a ghost list.
+	 */
+  void dropGhost(std::list<PageKey>& ghost, GhostIndex& ghostIndex);
+
+	/**
+	 * Resident lists, least recently used at the front
+	 */
+  std::list<FrameId> t1, t2;
+
+	/**
+	 * Position of every resident frame in its list, and whether that list is T2
+	 */
+  std::vector<std::list<FrameId>::iterator> position;
+  std::vector<bool> inT2;
+
+	/**
+	 * Page held by every resident frame
+	 */
+  std::vector<PageKey> pages;
+
+	/**
+	 * Ghost lists, oldest at the front
+	 */
+  std::list<PageKey> b1, b2;
+  GhostIndex b1Index, b2Index;
+
+	/**
+	 * Adaptive target size of T1
+	 */
+  std::uint32_t p;
+};
+
+}
@@ -0,0 +1,99 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
+ */
+
+/**
+ * Replays a page reference trace recorded with BufMgr::startTrace() against simulated buffer pools and
+ * prints the hit ratio and disk I/O of each. Built on its own, from this directory, together with the
+ * sources in ../exceptions:
+ *
+ *   g++ -std=c++11 -O2 -pthread -I.. -o buf_sim buf_sim.cpp ../buf_simulator.cpp ../buf_trace.cpp \
+ *       ../replacement_policy.cpp ../bufHashTbl.cpp ../buf_stats.cpp ../file.cpp ../page.cpp ../exceptions/[a-z]*.cpp
+ *
+ * Usage: buf_sim <trace> <policy> <bufs>...
+ *
+ * The policy is clock, lru-k, 2q, arc or all; one line is printed per policy and pool size.
+ */
+
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <vector>
+#include "buf_simulator.h"
+#include "buf_trace.h"
+#include "exceptions/badgerdb_exception.h"
+
+using namespace badgerdb;
+
+namespace {
+
+const struct
+{
+  const char* name;
+  ReplacementPolicyType type;
+} POLICIES[] = {
+  {"clock", CLOCK},
+  {"lru-k", LRU_K},
+  {"2q", TWO_Q},
+  {"arc", ARC},
+};
+
+const std::size_t NUM_POLICIES = sizeof(POLICIES) / sizeof(POLICIES[0]);
+
+void usage()
+{
+  std::cerr << "Usage: buf_sim <trace> <clock|lru-k|2q|arc|all> <bufs>...\n";
+  std::exit(2);
+}
+
+}
+
+int main(int argc, char** argv)
+{
+  if (argc < 4)
+    usage();
+  std::vector<std::size_t> policies;
+  for (std::size_t p = 0; p < NUM_POLICIES; p++) {
+    if (std::strcmp(argv[2], "all") == 0 || std::strcmp(argv[2], POLICIES[p].name) == 0)
+      policies.push_back(p);
+  }
+  if (policies.empty())
+    usage();
+  std::vector<std::uint32_t> sizes;
+  for (int a = 3; a < argc; a++) {
+    char* end;
+    long bufs = std::strtol(argv[a], &end, 10);
+    if (*end != '\0' || bufs <= 0)
+      usage();
+    sizes.push_back((std::uint32_t) bufs);
+  }
+
+  BufTrace trace;
+  try {
+    trace = BufTrace::load(argv[1]);
+  } catch (BadgerDbException& e) {
+    std::cerr << e.message() << "\n";
+    return 1;
+  }
+  std::cout << trace.records.size() << " calls on " << trace.numFiles << " files\n";
+  std::cout << std::left << std::setw(8) << "policy" << std::right << std::setw(10) << "bufs"
+            << std::setw(10) << "hit%" << std::setw(12) << "diskreads" << std::setw(12) << "diskwrites"
+            << std::setw(12) << "failedpins" << "\n";
+  for (std::size_t p = 0; p < policies.size(); p++) {
+    for (std::size_t s = 0; s < sizes.size(); s++) {
+      BufSimulator sim(sizes[s], POLICIES[policies[p]].type);
+      sim.replay(trace);
+      const BufStats& stats = sim.getStats();
+      std::uint64_t reads = stats.hits + stats.misses;
+      std::cout << std::left << std::setw(8) << POLICIES[policies[p]].name << std::right << std::setw(10) << sizes[s]
+                << std::setw(10) << std::fixed << std::setprecision(2) << (reads == 0 ? 0.0 : 100.0 * stats.hits / reads)
+                << std::setw(12) << stats.diskreads << std::setw(12) << stats.diskwrites
+                << std::setw(12) << sim.failedPins() << "\n";
+    }
+  }
+  return 0;
+}
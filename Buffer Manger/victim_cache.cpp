@@ -0,0 +1,161 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
+ */
+
+#include <cstring>
+#include "victim_cache.h"
+
+namespace badgerdb {
+
+const std::size_t VictimCache::MAX_STORED_SIZE;
+const std::size_t VictimCache::MIN_RUN;
+const std::size_t VictimCache::MAX_RUN;
+const std::size_t VictimCache::MAX_LITERAL;
+
+VictimCache::VictimCache(std::size_t capacity)
+  : capacity(capacity), used(0)
+{
+}
+
+bool VictimCache::insert(const File* file, PageId pageNo, const Page& page)
+{
+  remove(file, pageNo);
+  // A Page is laid out exactly like a page on disk, so it is compressed as
+  // one block of bytes.
+  char buffer[MAX_STORED_SIZE];
+  std::size_t length = compress(reinterpret_cast<const char*>(&page), Page::SIZE, buffer, sizeof(buffer));
+  if (length == 0 || length > capacity)
+    return false;
+  shrinkTo(capacity - length);
+  PageKey key = {file, pageNo};
+  Entry entry = {key, std::vector<char>(buffer, buffer + length)};
+  index[key] = entries.insert(entries.end(), entry);
+  pagesByFile[file]++;
+  used += length;
+  return true;
+}
+
+bool VictimCache::take(const File* file, PageId pageNo, Page& page)
+{
+  PageKey key = {file, pageNo};
+  std::unordered_map<PageKey, std::list<Entry>::iterator, PageKeyHash>::iterator it = index.find(key);
+  if (it == index.end())
+    return false;
+  const std::vector<char>& data = it->second->data;
+  bool restored = decompress(&data[0], data.size(), reinterpret_cast<char*>(&page), Page::SIZE);
+  erase(it->second);
+  return restored;
+}
+
+void VictimCache::remove(const File* file, PageId pageNo)
+{
+  PageKey key = {file, pageNo};
+  std::unordered_map<PageKey, std::list<Entry>::iterator, PageKeyHash>::iterator it = index.find(key);
+  if (it != index.end())
+    erase(it->second);
+}
+
+void VictimCache::removeFile(const File* file)
+{
+  if (pagesByFile.count(file) == 0)
+    return;
+  for (std::list<Entry>::iterator it = entries.begin(); it != entries.end(); ) {
+    std::list<Entry>::iterator next = it;
+    ++next;
+    if (it->key.file == file)
+      erase(it);
+    it = next;
+  }
+}
+
+void VictimCache::setCapacity(std::size_t newCapacity)
+{
+  capacity = newCapacity;
+  shrinkTo(capacity);
+}
+
+void VictimCache::shrinkTo(std::size_t limit)
+{
+  while (used > limit)
+    erase(entries.begin());
+}
+
+void VictimCache::erase(std::list<Entry>::iterator entry)
+{
+  used -= entry->data.size();
+  std::unordered_map<const File*, std::size_t>::iterator count = pagesByFile.find(entry->key.file);
+  if (--count->second == 0)
+    pagesByFile.erase(count);
+  index.erase(entry->key);
+  entries.erase(entry);
+}
+
+// The compressed data is a sequence of tokens. A token byte below 0x80
+// is followed by that many plus one literal bytes. Otherwise its low seven
+// bits and the next byte hold a run length less MIN_RUN, and the byte
+// after them is the value repeated.
+
+std::size_t VictimCache::compress(const char* in, std::size_t length, char* out, std::size_t outCapacity)
+{
+  std::size_t i = 0, o = 0, literal = 0;
+  for (;;) {
+    std::size_t run = 1;
+    while (i + run < length && run < MAX_RUN && in[i + run] == in[i])
+      run++;
+    if (i < length && run < MIN_RUN) {
+      // Too short to pay off; the bytes join the pending literal.
+      i += run;
+      continue;
+    }
+    while (literal < i) {
+      std::size_t n = i - literal < MAX_LITERAL ? i - literal : MAX_LITERAL;
+      if (o + 1 + n > outCapacity)
+        return 0;
+      out[o++] = (char) (n - 1);
+      std::memcpy(out + o, in + literal, n);
+      o += n;
+      literal += n;
+    }
+    if (i == length)
+      return o;
+    if (o + 3 > outCapacity)
+      return 0;
+    std::size_t code = run - MIN_RUN;
+    out[o++] = (char) (0x80 | (code >> 8));
+    out[o++] = (char) (code & 0xFF);
+    out[o++] = in[i];
+    i += run;
+    literal = i;
+  }
+}
+
+bool VictimCache::decompress(const char* in, std::size_t length, char* out, std::size_t outLength)
+{
+  std::size_t i = 0, o = 0;
+  while (i < length) {
+    unsigned char token = (unsigned char) in[i++];
+    if (token < 0x80) {
+      std::size_t n = (std::size_t) token + 1;
+      if (i + n > length || o + n > outLength)
+        return false;
+      std::memcpy(out + o, in + i, n);
+      i += n;
+      o += n;
+    } else {
+      if (i + 2 > length)
+        return false;
+      std::size_t n = ((std::size_t) (token & 0x7F) << 8 | (unsigned char) in[i]) + MIN_RUN;
+      if (o + n > outLength)
+        return false;
+      std::memset(out + o, in[i + 1], n);
+      i += 2;
+      o += n;
+    }
+  }
+  return o == outLength;
+}
+
+}
@@ -0,0 +1,174 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <list>
+#include <unordered_map>
+#include <vector>
+
+#include "page.h"
+#include "replacement_policy.h"
+
+namespace badgerdb {
+
+/**
+ * @brief Second cache tier holding compressed copies of clean pages evicted from a buffer pool partition.
+ *
+ * Many evicted pages are sparse, such as half full B+ tree nodes and slotted pages with free space in
+ * the middle, and compress to a fraction of their size with a simple run-length codec. A miss that finds
+ * its page here decompresses it instead of reading it from disk, so the tier adds capacity to the pool
+ * for less memory than frames would take. The tier is exclusive: a page taken out of it is removed, so a
+ * page is never both in a frame and here, and no copy can go stale. Pages that do not compress to at
+ * most MAX_STORED_SIZE bytes are not kept. Entries are dropped least recently stored first once the
+ * compressed pages exceed the capacity.
+ *
+ * @warning This class is not threadsafe. Each partition has its own tier, guarded by the partition latch.
+ */
+class VictimCache
+{
+ public:
+	/**
+	 * Largest compressed size of a page that is kept; pages that compress worse are not worth the memory.
+	 */
+  static const std::size_t MAX_STORED_SIZE = Page::SIZE * 3 / 4;
+
+	/**
+	 * Constructs an empty tier.
+	 *
+	 * @param capacity  Number of bytes of compressed pages the tier may hold
+	 */
+  explicit VictimCache(std::size_t capacity);
+
+	/**
+	 * Stores a copy of a clean page, replacing any copy of the same page.
+	 *
+	 * @param file    File the page belongs to
+	 * @param pageNo  Page number within the file
+	 * @param page    Contents of the page
+	 * @return  False if the page did not compress well enough to be kept.
+	 */
+  bool insert(const File* file, PageId pageNo, const Page& page);
+
+	/**
+	 * Takes a page out of the tier.
+	 *
+	 * @param file    File the page belongs to
+	 * @param pageNo  Page number within the file
+	 * @param page    Decompressed contents returned via this variable
+	 * @return  False if the tier does not hold the page.
+	 */
+  bool take(const File* file, PageId pageNo, Page& page);
+
+	/**
+	 * Drops the copy of a page, if there is one.
+	 */
+  void remove(const File* file, PageId pageNo);
+
+	/**
+	 * Drops the copies of all pages of a file, for example before the file is closed.
+	 */
+  void removeFile(const File* file);
+
+	/**
+	 * Changes the capacity, dropping entries if the tier holds more.
+	 */
+  void setCapacity(std::size_t capacity);
+
+	/**
+	 * Number of pages held
+	 */
+  std::size_t numPages() const { return index.size(); }
+
+	/**
+	 * Number of bytes of compressed pages held
+	 */
+  std::size_t numBytes() const { return used; }
+
+	/**
+	 * Compresses a buffer with the run-length codec of the tier. Runs of at least MIN_RUN equal bytes,
+	 * such as zero padding, take three bytes; everything else is copied with one byte of overhead per
+	 * 128 bytes.
+	 *
+	 * @param in        Buffer to compress
+	 * @param length    Length of the buffer
+	 * @param out       Buffer the compressed data is written to
+	 * @param outCapacity Length of the output buffer
+	 * @return  Compressed length, or 0 if the output does not fit into outCapacity bytes.
+	 */
+  static std::size_t compress(const char* in, std::size_t length, char* out, std::size_t outCapacity);
+
+	/**
+	 * Reverses compress().
+	 *
+	 * @param in        Compressed data
+	 * @param length    Length of the compressed data
+	 * @param out       Buffer the data is restored to
+	 * @param outLength Length of the data before compression
+	 * @return  False if the compressed data is malformed or does not restore exactly outLength bytes.
+	 */
+  static bool decompress(const char* in, std::size_t length, char* out, std::size_t outLength);
+
+ private:
+	/**
+	 * Shortest run of equal bytes compress() encodes as a run
+	 */
+  static const std::size_t MIN_RUN = 4;
+
+	/**
+	 * Longest run of equal bytes a single run token can encode
+	 */
+  static const std::size_t MAX_RUN = 0x7FFF + MIN_RUN;
+
+	/**
+	 * Longest literal a single literal token can encode
+	 */
+  static const std::size_t MAX_LITERAL = 0x80;
+
+	/**
+	 * @brief A compressed page
+	 */
+  struct Entry
+  {
+    PageKey key;
+    std::vector<char> data;
+  };
+
+	/**
+	 * Drops the least recently stored entries until the tier fits its capacity.
+	 */
+  void shrinkTo(std::size_t capacity);
+
+	/**
+	 * Drops an entry.
+	 */
+  void erase(std::list<Entry>::iterator entry);
+
+	/**
+	 * Entries, least recently stored at the front
+	 */
+  std::list<Entry> entries;
+
+	/**
+	 * Position of every entry by page
+	 */
+  std::unordered_map<PageKey, std::list<Entry>::iterator, PageKeyHash> index;
+
+	/**
+	 * Number of entries of every file that has any, so removeFile() can skip files without entries
+	 */
+  std::unordered_map<const File*, std::size_t> pagesByFile;
+
+	/**
+	 * Number of bytes the tier may hold and does hold
+	 */
+  std::size_t capacity;
+  std::size_t used;
+};
+
+}